@@ -5,10 +5,21 @@
  * @file crusher.h
  * @brief Declarations for the crusher module.
  */
+#include "esp_err.h"
 
 /**
  * @brief Initializes the crusher module.
  */
 void Crusher_Start();
 
+/**
+ * @brief Turns the crusher on, does nothing if it is already on.
+ */
+esp_err_t Crusher_TurnOn();
+
+/**
+ * @brief Turns the crusher off, does nothing if it is already off.
+ */
+esp_err_t Crusher_TurnOff();
+
 #endif // CRUSHER_H
@@ -5,10 +5,21 @@
  * @file fan.h
  * @brief Declarations for the fan module.
  */
+#include "esp_err.h"
 
 /**
  * @brief Initializes the fan module.
  */
 void Fan_Start();
 
+/**
+ * @brief Turns the fan on, does nothing if it is already on.
+ */
+esp_err_t Fan_TurnOn();
+
+/**
+ * @brief Turns the fan off, does nothing if it is already off.
+ */
+esp_err_t Fan_TurnOff();
+
 #endif // FAN_H
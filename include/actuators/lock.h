@@ -5,10 +5,21 @@
  * @file lock.h
  * @brief Declarations for the lock module.
  */
+#include "esp_err.h"
 
 /**
  * @brief Initializes the lock module.
  */
 void Lock_Start();
 
+/**
+ * @brief Locks the lid, does nothing if it is already locked.
+ */
+esp_err_t Lock_Engage();
+
+/**
+ * @brief Unlocks the lid, does nothing if it is already unlocked.
+ */
+esp_err_t Lock_Release();
+
 #endif // LOCK_H
@@ -5,10 +5,21 @@
  * @file mixer.h
  * @brief Declarations for the mixer module.
  */
+#include "esp_err.h"
 
 /**
  * @brief Initializes the mixer module.
  */
 void Mixer_Start();
 
+/**
+ * @brief Turns the mixer on, does nothing if it is already on.
+ */
+esp_err_t Mixer_TurnOn();
+
+/**
+ * @brief Turns the mixer off, does nothing if it is already off.
+ */
+esp_err_t Mixer_TurnOff();
+
 #endif // MIXER_H
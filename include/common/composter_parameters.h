@@ -25,6 +25,7 @@ typedef struct {
     bool fan;                      // State flag for the fan component
     bool lock;                     // State flag for the lock component
     bool lid;                      // State flag for the lid component
+    bool full;                     // State flag for the capacity sensor
     SemaphoreHandle_t mutex;       // Semaphore for ensuring thread safety
 } ComposterParameters;
 
@@ -43,6 +44,7 @@ bool ComposterParameters_GetCrusherState(const ComposterParameters* params);
 bool ComposterParameters_GetFanState(const ComposterParameters* params);
 bool ComposterParameters_GetLockState(const ComposterParameters* params);
 bool ComposterParameters_GetLidState(const ComposterParameters* params);
+bool ComposterParameters_GetFullState(const ComposterParameters* params);
 
 // Functions to set various parameters and states
 void ComposterParameters_SetComplete(ComposterParameters* params, double value);
@@ -56,5 +58,6 @@ void ComposterParameters_SetCrusherState(ComposterParameters* params, bool value
 void ComposterParameters_SetFanState(ComposterParameters* params, bool value);
 void ComposterParameters_SetLockState(ComposterParameters* params, bool value);
 void ComposterParameters_SetLidState(ComposterParameters* params, bool value);
+void ComposterParameters_SetFullState(ComposterParameters* params, bool value);
 
 #endif // COMPOSTER_PARAMETERS_H
@@ -0,0 +1,61 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+/**
+ * @file event_log.h
+ * @brief Declarations for the deferred binary logging module.
+ *
+ * Hot paths such as event handlers record a compile-time message ID and up to
+ * EVENT_LOG_MAX_ARGS raw 32-bit arguments into a lock-free ring buffer. A low-priority
+ * task formats and prints the records later, keeping vsnprintf and the UART out of
+ * the calling task. Arguments must be integers or pointers to static strings
+ * (e.g. event bases), since they are only dereferenced when the record is printed.
+ */
+#include <stdint.h>
+
+#define EVENT_LOG_MAX_ARGS 2
+
+/*
+ * Table of deferred log messages: X(id, level, format).
+ * Each format takes exactly EVENT_LOG_MAX_ARGS 32-bit arguments.
+ */
+#define EVENT_LOG_MESSAGES(X) \
+    X(EVENT_LOG_EVENT_RECEIVED, ESP_LOG_INFO, "Event received: %s, %ld")
+
+// Compile-time IDs of the deferred log messages
+typedef enum {
+#define EVENT_LOG_ID(id, level, format) id,
+    EVENT_LOG_MESSAGES(EVENT_LOG_ID)
+#undef EVENT_LOG_ID
+    EVENT_LOG_ID_MAX
+} EventLogId_t;
+
+// Counters of the deferred log
+typedef struct {
+    uint32_t written;       // Records written to the ring buffer
+    uint32_t dropped;       // Records lost because the ring buffer was full
+    uint32_t printed;       // Records formatted by the drain task
+} EventLogStats_t;
+
+/**
+ * @brief Records a deferred log message.
+ *
+ * @param tag   Log tag of the caller, must outlive the record.
+ * @param id    Message ID from EVENT_LOG_MESSAGES.
+ * @param a0    First argument.
+ * @param a1    Second argument.
+ */
+#define EVENT_LOG(tag, id, a0, a1) EventLog_Write((tag), (id), (uint32_t) (uintptr_t) (a0), (uint32_t) (uintptr_t) (a1))
+
+/**
+ * @brief Starts the deferred log drain task.
+ */
+void EventLog_Start();
+
+// Function to record a message, safe from any task or ISR
+void EventLog_Write(const char *tag, EventLogId_t id, uint32_t a0, uint32_t a1);
+
+// Function to get a snapshot of the deferred log counters
+void EventLog_GetStats(EventLogStats_t *stats);
+
+#endif // EVENT_LOG_H
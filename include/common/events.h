@@ -98,23 +98,13 @@ typedef enum {
     PARAMETERS_EVENT_UNSTABLE   // Parameters unstable event
 } ParametersEvent_t;
 
-// Definición de eventos de humedad
-ESP_EVENT_DECLARE_BASE(HUMIDITY_EVENT);
+// Definition of sensor acquisition events
+ESP_EVENT_DECLARE_BASE(ACQUISITION_EVENT);
 
-// Enumeration of events related to humidity
+// Enumeration of events related to the sensor acquisition task
 typedef enum {
-    HUMIDITY_EVENT_STABLE,  // Humidity stable event
-    HUMIDITY_EVENT_UNSTABLE // Humidity unstable event
-} HumidityEvent_t;
-
-// Definición de eventos de temperatura
-ESP_EVENT_DECLARE_BASE(TEMPERATURE_EVENT);
-
-// Enumeration of events related to temperature
-typedef enum {
-    TEMPERATURE_EVENT_STABLE,    // Temperature stable event
-    TEMPERATURE_EVENT_UNSTABLE   // Temperature unstable event
-} TemperatureEvent_t;
+    ACQUISITION_EVENT_CYCLE     // Readings of one acquisition cycle, data is an AcquisitionResults_t
+} AcquisitionEvent_t;
 
 // Definición de eventos de capacidad
 ESP_EVENT_DECLARE_BASE(CAPACITY_EVENT);
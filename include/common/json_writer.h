@@ -0,0 +1,41 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+/**
+ * @file json_writer.h
+ * @brief Declarations for the JsonWriter module.
+ *
+ * Streams compact JSON directly into a caller-provided buffer without any heap
+ * allocation. Keys are only used inside objects; pass NULL at the root.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Define the structure to hold the writer state
+typedef struct {
+    char *buffer;           // Output buffer provided by the caller
+    size_t size;            // Size of the output buffer
+    size_t length;          // Bytes written so far, excluding the terminator
+    uint8_t depth;          // Number of open objects
+    bool needsComma;        // Whether the next member must be preceded by a comma
+    bool overflow;          // Set once the output did not fit in the buffer
+} JsonWriter;
+
+// Function to initialize a JsonWriter over a buffer
+void JsonWriter_Init(JsonWriter *writer, char *buffer, size_t size);
+
+// Functions to open and close objects
+void JsonWriter_BeginObject(JsonWriter *writer, const char *key);
+void JsonWriter_EndObject(JsonWriter *writer);
+
+// Functions to add typed members
+void JsonWriter_AddInt(JsonWriter *writer, const char *key, int32_t value);
+void JsonWriter_AddNumber(JsonWriter *writer, const char *key, double value);
+void JsonWriter_AddBool(JsonWriter *writer, const char *key, bool value);
+void JsonWriter_AddString(JsonWriter *writer, const char *key, const char *value);
+
+// Function to get the finished document, NULL if it overflowed or is incomplete
+const char *JsonWriter_Finish(JsonWriter *writer, size_t *length);
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,73 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+/**
+ * @file timer_wheel.h
+ * @brief Declarations for the TimerWheel module.
+ *
+ * Hierarchical timing wheel that runs every software timer of the application
+ * from a single task. Timers are caller-owned, arming and cancelling them is O(1)
+ * and never blocks, so it is safe from any task and from timer callbacks.
+ * Callbacks run in the wheel task and must not block either.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+// Function called when a timer expires
+typedef void (*TimerWheelCallback_t)(void *arg);
+
+// Link of a timer in a wheel slot
+typedef struct TimerWheelNode {
+    struct TimerWheelNode *next;
+    struct TimerWheelNode *prev;
+} TimerWheelNode_t;
+
+// Define the structure of a timer, only to be accessed through the functions below
+typedef struct {
+    TimerWheelNode_t node;          // Must stay the first member
+    const char *name;
+    TimerWheelCallback_t callback;
+    void *arg;
+    uint32_t period;                // Ticks
+    uint32_t expiry;                // Wheel tick the timer expires at
+    int64_t due_us;                 // Expected expiry time, to measure the jitter
+    bool periodic;
+    bool active;
+} WheelTimer_t;
+
+// Counters of the timing wheel
+typedef struct {
+    uint32_t active;                // Timers currently armed
+    uint32_t fired;                 // Callbacks run
+    uint32_t maxLatenessUs;         // Worst delay of a callback past its due time
+    uint32_t avgLatenessUs;
+} TimerWheelStats_t;
+
+/**
+ * @brief Starts the task that runs the timing wheel.
+ *
+ * Timers may be armed before, they run once the task is started.
+ */
+void TimerWheel_Start();
+
+// Function to set up a timer, it is left disarmed
+void TimerWheel_Init(WheelTimer_t *timer, const char *name, uint32_t period_ms, bool periodic,
+                     TimerWheelCallback_t callback, void *arg);
+
+// Function to arm a timer for its period, restarting it if it is already armed
+void TimerWheel_Arm(WheelTimer_t *timer);
+
+// Function to change the period of a timer and arm it
+void TimerWheel_ChangePeriod(WheelTimer_t *timer, uint32_t period_ms);
+
+// Function to disarm a timer, nothing happens if it is not armed
+void TimerWheel_Cancel(WheelTimer_t *timer);
+
+// Functions to query a timer
+bool TimerWheel_IsActive(const WheelTimer_t *timer);
+uint32_t TimerWheel_GetRemainingMs(const WheelTimer_t *timer);
+
+// Function to get a snapshot of the wheel counters
+void TimerWheel_GetStats(TimerWheelStats_t *stats);
+
+#endif // TIMER_WHEEL_H
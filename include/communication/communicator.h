@@ -11,9 +11,35 @@ static const int MIXER_STATE_BIT = BIT1;
 static const int CRUSHER_STATE_BIT = BIT2;
 static const int FAN_STATE_BIT = BIT3;
 
+/**
+ * @brief Classes of outbound Firebase traffic, each with its own rate budget.
+ */
+typedef enum {
+    COMMUNICATOR_TRAFFIC_COMMAND,       // Polling remote commands
+    COMMUNICATOR_TRAFFIC_STATE,         // Writing actuator changes
+    COMMUNICATOR_TRAFFIC_TELEMETRY,     // Routine sensor updates
+    COMMUNICATOR_TRAFFIC_MAX
+} CommunicatorTrafficClass_t;
+
+/**
+ * @brief Outbound traffic counters, indexed by CommunicatorTrafficClass_t.
+ */
+typedef struct {
+    uint32_t sent[COMMUNICATOR_TRAFFIC_MAX];        // Requests that went out
+    uint32_t throttled[COMMUNICATOR_TRAFFIC_MAX];   // Requests deferred for lack of budget
+    uint32_t coalesced[COMMUNICATOR_TRAFFIC_MAX];   // Triggers merged into an already pending request
+} CommunicatorTrafficStats_t;
+
 /**
  * @brief Initializes the communicator module.
  */
 void Communicator_Start();
 
+/**
+ * @brief Get a snapshot of the outbound traffic counters.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void Communicator_GetTrafficStats(CommunicatorTrafficStats_t *stats);
+
 #endif // COMMUNICATOR_H
\ No newline at end of file
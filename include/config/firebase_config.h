@@ -20,6 +20,9 @@
 #define USER_EMAIL "juanma@gmail.com"   // This gmail does not exist outside your database. it only exists in the firebase project as a user
 #define USER_PASSWORD "123456789"      // Dont add your gmail credentials. Setup users authentication in your Firebase project first
 
-#define COMPOSTER_ID "000002"
+// Composters live under this node. Each unit's ID is derived from its eFuse MAC
+// on first boot and persisted in NVS (namespace "composter", key "id"); write a
+// different value there to provision a fixed ID.
+#define COMPOSTERS_PATH "/composters/"
 
 #endif // FIREBASE_CONFIG_H
@@ -0,0 +1,52 @@
+#ifndef CONTROL_RULES_H
+#define CONTROL_RULES_H
+
+/**
+ * @file control_rules.h
+ * @brief Facts, actions and rules of the composter control policy.
+ *
+ * Kept free of ESP-IDF dependencies so the policy can be run on the host.
+ */
+#include <stddef.h>
+
+#include "control/rule_engine.h"
+
+// Facts that follow the state of the composter
+#define FACT_PARAMS_STABLE          (1UL << 0)   // Temperature and humidity are both stable
+#define FACT_LID_CLOSED             (1UL << 1)
+#define FACT_FULL                   (1UL << 2)
+#define FACT_LOCKED                 (1UL << 3)
+#define FACT_MIXER_ON               (1UL << 4)
+#define FACT_FAN_ON                 (1UL << 5)
+#define FACT_CRUSHER_ON             (1UL << 6)
+
+// Pulse facts, only set during the update that reports them
+#define FACT_MIXER_REQUESTED        (1UL << 16)  // Manual mixer request, from the app or a button
+#define FACT_FAN_REQUESTED          (1UL << 17)
+#define FACT_CRUSHER_REQUESTED      (1UL << 18)
+#define FACT_ROUTINE_MIX_DUE        (1UL << 19)  // Routine mixing timer fired
+#define FACT_MIXER_CHECK_DUE        (1UL << 20)  // Mixer run timer fired
+#define FACT_FAN_CHECK_DUE          (1UL << 21)  // Fan run timer fired
+#define FACT_CRUSHER_TIME_UP        (1UL << 22)  // Crusher run timer fired
+
+#define CONTROL_PULSE_FACTS         (0xFFFFUL << 16)
+
+// Enumeration of the actions of the control policy
+typedef enum {
+    CONTROL_ACTION_MIXER_ON,
+    CONTROL_ACTION_MIXER_OFF,
+    CONTROL_ACTION_FAN_ON,
+    CONTROL_ACTION_FAN_OFF,
+    CONTROL_ACTION_CRUSHER_ON,
+    CONTROL_ACTION_CRUSHER_OFF,
+    CONTROL_ACTION_LOCK,
+    CONTROL_ACTION_UNLOCK,
+    CONTROL_ACTION_REQUEST_TO_CLOSE_LID,
+    CONTROL_ACTION_REQUEST_TO_EMPTY_COMPOSTER
+} ControlAction_t;
+
+// Rule table of the control policy
+extern const Rule_t controlRules[];
+extern const size_t controlRulesCount;
+
+#endif // CONTROL_RULES_H
@@ -0,0 +1,36 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+/**
+ * @file controller.h
+ * @brief Declarations for the controller module.
+ *
+ * Owns the actuator control policy: events are turned into facts and fed to the
+ * rule engine by a single evaluation task, which drives the actuators.
+ */
+#include <stdint.h>
+
+// Counters of the controller
+typedef struct {
+    uint32_t decisions;         // Inputs evaluated
+    uint32_t dropped;           // Inputs lost because the queue was full
+    uint32_t lastLatencyUs;     // From the input being queued to the actions being done
+    uint32_t maxLatencyUs;
+    uint32_t maxEvaluated;      // Most rules evaluated for one input
+} ControlStats_t;
+
+/**
+ * @brief Starts the controller.
+ *
+ * Must be called after the actuator modules have been started.
+ */
+void Control_Start();
+
+/**
+ * @brief Gets a snapshot of the controller counters.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void Control_GetStats(ControlStats_t *stats);
+
+#endif // CONTROLLER_H
@@ -0,0 +1,67 @@
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+/**
+ * @file rule_engine.h
+ * @brief Declarations for the RuleEngine module.
+ *
+ * Evaluates a table of condition -> action rules over a set of boolean facts.
+ * Only rules whose inputs changed are evaluated, and every update is bounded to
+ * RULE_ENGINE_MAX_PASSES passes over the table. The engine has no platform
+ * dependencies, so the same tables run on the target and on the host.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define RULE_ENGINE_MAX_PASSES 3    // Passes per update for actions that trigger further rules
+
+// Set of facts, one bit per fact
+typedef uint32_t RuleFacts_t;
+
+// Define the structure of a rule
+typedef struct {
+    RuleFacts_t inputs;     // Facts whose change triggers an evaluation of the rule
+    RuleFacts_t required;   // Facts that must be set for the rule to fire
+    RuleFacts_t excluded;   // Facts that must be clear for the rule to fire
+    int action;             // Action passed to the action handler
+    RuleFacts_t sets;       // Facts set once the action succeeded
+    RuleFacts_t clears;     // Facts cleared once the action succeeded
+} Rule_t;
+
+// Function called to perform an action, returns false if it failed
+typedef bool (*RuleActionHandler_t)(int action, void *context);
+
+// Counters of the rule engine
+typedef struct {
+    uint32_t updates;       // Calls to RuleEngine_Update
+    uint32_t evaluated;     // Rule evaluations over all updates
+    uint32_t fired;         // Actions performed over all updates
+    uint32_t maxEvaluated;  // Most rule evaluations in a single update
+} RuleEngineStats_t;
+
+// Define the structure to hold the engine state
+typedef struct {
+    const Rule_t *rules;
+    size_t count;
+    RuleFacts_t facts;          // Current facts
+    RuleFacts_t pulses;         // Facts that only last for the update that set them
+    RuleActionHandler_t handler;
+    void *context;
+    RuleEngineStats_t stats;
+} RuleEngine;
+
+// Function to initialize an engine over a rule table
+void RuleEngine_Init(RuleEngine *engine, const Rule_t *rules, size_t count, RuleFacts_t pulses,
+                     RuleFacts_t facts, RuleActionHandler_t handler, void *context);
+
+// Function to change facts and run the rules they trigger, returns the number of actions performed
+uint32_t RuleEngine_Update(RuleEngine *engine, RuleFacts_t set, RuleFacts_t clear);
+
+// Function to get the current facts
+RuleFacts_t RuleEngine_GetFacts(const RuleEngine *engine);
+
+// Function to get a snapshot of the engine counters
+void RuleEngine_GetStats(const RuleEngine *engine, RuleEngineStats_t *stats);
+
+#endif // RULE_ENGINE_H
@@ -31,6 +31,25 @@ typedef struct {
  */
 typedef struct onewire_bus_t *onewire_bus_handle_t;
 
+/**
+ * @brief Type of the hook that power cycles the devices on a 1-wire bus
+ *
+ * @param[in] user_ctx User context passed to onewire_bus_set_power_cycle_hook
+ * @return ESP_OK once the devices are powered again
+ */
+typedef esp_err_t (*onewire_bus_power_cycle_cb_t)(void *user_ctx);
+
+/**
+ * @brief 1-wire bus recovery counters
+ *
+ */
+typedef struct {
+    uint32_t recoveries; /*!< calls to onewire_bus_recover, each one starts with a bus reset */
+    uint32_t channel_reinits; /*!< recoveries that had to re-initialize the rmt channels */
+    uint32_t power_cycles; /*!< recoveries that had to power cycle the devices */
+    uint32_t failures; /*!< recoveries that ended without finding the device */
+} onewire_bus_recovery_stats_t;
+
 /**
  * @brief Install new 1-wire bus
  *
@@ -53,6 +72,45 @@ esp_err_t onewire_new_bus_rmt(onewire_rmt_config_t *config, onewire_bus_handle_t
  */
 esp_err_t onewire_del_bus(onewire_bus_handle_t handle);
 
+/**
+ * @brief Recover a 1-wire bus in place after failed transactions
+ *
+ * @note Escalates until the bus answers again: first a bus reset, then a re-initialization of the
+ *       rmt channels, then the power cycle hook if one is set. The rmt channels, encoders and
+ *       buffers of the bus are reused, so recovering never leaks rmt resources.
+ *
+ * @param[in] handle 1-wire bus handle
+ * @param[in] rom_number ROM number of a device that must be found by a ROM search after each step, or NULL to only check for a presence pulse
+ * @return
+ *         - ESP_OK                The bus answers again.
+ *         - ESP_ERR_INVALID_ARG   Invalid argument.
+ *         - ESP_ERR_NOT_FOUND     No step brought the device back.
+ */
+esp_err_t onewire_bus_recover(onewire_bus_handle_t handle, const uint8_t *rom_number);
+
+/**
+ * @brief Set the hook used by onewire_bus_recover as its last step
+ *
+ * @param[in] handle 1-wire bus handle
+ * @param[in] cb Function that power cycles the devices, NULL to skip that step
+ * @param[in] user_ctx User context passed to the hook
+ * @return
+ *         - ESP_OK                Hook set successfully.
+ *         - ESP_ERR_INVALID_ARG   Invalid argument.
+ */
+esp_err_t onewire_bus_set_power_cycle_hook(onewire_bus_handle_t handle, onewire_bus_power_cycle_cb_t cb, void *user_ctx);
+
+/**
+ * @brief Get the recovery counters of a 1-wire bus
+ *
+ * @param[in] handle 1-wire bus handle
+ * @param[out] stats_out Recovery counters
+ * @return
+ *         - ESP_OK                Counters copied successfully.
+ *         - ESP_ERR_INVALID_ARG   Invalid argument.
+ */
+esp_err_t onewire_bus_get_recovery_stats(onewire_bus_handle_t handle, onewire_bus_recovery_stats_t *stats_out);
+
 /**
  * @brief Send reset pulse on 1-wire bus, and detect if there are devices on the bus
  *
@@ -112,6 +170,44 @@ esp_err_t onewire_bus_write_bit(onewire_bus_handle_t handle, uint8_t tx_bit);
  */
 esp_err_t onewire_bus_read_bit(onewire_bus_handle_t handle, uint8_t *rx_bit);
 
+/**
+ * @brief Write bytes and then read bytes from 1-wire bus in a single rmt transaction
+ *
+ * @note The receive channel records the written bytes too, so the rx buffer must hold tx_data_size + rx_data_size bytes.
+ *       When it can't (see max_rx_bytes in onewire_rmt_config_t), this falls back to onewire_bus_write_bytes followed by onewire_bus_read_bytes.
+ *
+ * @param[in] handle 1-wire bus handle
+ * @param[in] tx_data pointer to data to be sent, usually a rom command, a rom number and a function command
+ * @param[in] tx_data_size size of data to be sent, in bytes
+ * @param[out] rx_data pointer to received data
+ * @param[in] rx_data_size size of data to be received, in bytes
+ * @return
+ *         - ESP_OK                   Write and read bytes successfully.
+ *         - ESP_ERR_INVALID_ARG      Invalid argument.
+ *         - ESP_ERR_TIMEOUT          The transaction did not finish.
+ *         - ESP_ERR_INVALID_RESPONSE Fewer bits than expected were recorded.
+ */
+esp_err_t onewire_bus_write_read_bytes(onewire_bus_handle_t handle, const uint8_t *tx_data, uint8_t tx_data_size, uint8_t *rx_data, size_t rx_data_size);
+
+/**
+ * @brief Write bits and then read bits from 1-wire bus in a single rmt transaction
+ *
+ * @note Used by the ROM search to write the direction of a bit and read the next bit and its complement at once.
+ *       Bits are sent and received LSB first, at most 32 in total.
+ *
+ * @param[in] handle 1-wire bus handle
+ * @param[in] tx_bits bits to transmit
+ * @param[in] tx_bit_count number of bits to transmit
+ * @param[out] rx_bits received bits, not touched when rx_bit_count is 0
+ * @param[in] rx_bit_count number of bits to receive
+ * @return
+ *         - ESP_OK                   Write and read bits successfully.
+ *         - ESP_ERR_INVALID_ARG      Invalid argument.
+ *         - ESP_ERR_TIMEOUT          The transaction did not finish.
+ *         - ESP_ERR_INVALID_RESPONSE Fewer bits than expected were recorded.
+ */
+esp_err_t onewire_bus_write_read_bits(onewire_bus_handle_t handle, uint32_t tx_bits, uint8_t tx_bit_count, uint32_t *rx_bits, uint8_t rx_bit_count);
+
 #ifdef __cplusplus
 }
 #endif
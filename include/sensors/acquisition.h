@@ -0,0 +1,72 @@
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+/**
+ * @file acquisition.h
+ * @brief Declarations for the sensor acquisition module.
+ *
+ * A single task runs the reading jobs of every sensor. Sensor modules register
+ * their jobs and request them from timers, event handlers or interrupts; all
+ * jobs pending when the task wakes up run back to back as one cycle, and the
+ * readings of the cycle are posted as one ACQUISITION_EVENT_CYCLE event.
+ * Jobs run in registration order and must not block for long.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ACQUISITION_MAX_JOBS    8
+
+// Readings present in a result set
+#define ACQUISITION_READING_HUMIDITY        (1 << 0)
+#define ACQUISITION_READING_TEMPERATURE     (1 << 1)
+#define ACQUISITION_READING_CAPACITY        (1 << 2)
+#define ACQUISITION_READING_LID             (1 << 3)
+
+// Define the structure of the readings taken in one cycle
+typedef struct {
+    uint32_t cycle;             // Sequence number of the cycle
+    uint32_t readings;          // ACQUISITION_READING_* bits of the fields that were filled
+    float humidity;
+    bool isHumidityStable;
+    float temperature;
+    bool isTemperatureStable;
+    float complete;             // Percentage of the composter capacity in use
+    bool isFull;
+    bool isLidClosed;
+} AcquisitionResults_t;
+
+// Function that runs one job, filling its readings into the result set of the cycle
+typedef void (*AcquisitionJobFunction_t)(AcquisitionResults_t *results);
+
+// Counters of the acquisition task
+typedef struct {
+    uint32_t cycles;            // Wake-ups of the acquisition task
+    uint32_t jobs;              // Jobs run over all cycles
+    uint32_t published;         // Result sets posted
+    uint32_t maxCycleUs;        // Longest cycle
+} AcquisitionStats_t;
+
+/**
+ * @brief Starts the acquisition task.
+ *
+ * Must be called before the sensor modules are started.
+ */
+void Acquisition_Start();
+
+/**
+ * @brief Registers a sensor job.
+ *
+ * @param name  Name used in log messages.
+ * @param job   Function that runs the job.
+ * @return Job identifier, -1 if the job table is full.
+ */
+int Acquisition_Register(const char *name, AcquisitionJobFunction_t job);
+
+// Functions to request a job to run in the next cycle, from a task or from an interrupt
+void Acquisition_Request(int job);
+void Acquisition_RequestFromISR(int job);
+
+// Function to get a snapshot of the acquisition counters
+void Acquisition_GetStats(AcquisitionStats_t *stats);
+
+#endif // ACQUISITION_H
@@ -0,0 +1,56 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+/**
+ * @file adaptive_sampler.h
+ * @brief Declarations for the AdaptiveSampler module.
+ *
+ * Chooses the period until the next reading of a sensor from its trend: the
+ * period grows while readings are flat and shrinks as the rate of change grows
+ * or the reading gets close to its threshold. The sampler has no platform
+ * dependencies, so the same code runs on the target and on the host.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+// Define the structure of the sampler settings
+typedef struct {
+    uint32_t minPeriodMs;       // Shortest period between readings
+    uint32_t maxPeriodMs;       // Longest period between readings
+    uint32_t unstableMaxMs;     // Longest period while the reading is over the threshold
+    float threshold;            // The parameter is unstable above this value
+    float margin;               // Distance to the threshold below which readings speed up
+    float flatRate;             // Change per minute below which readings count as flat
+    uint32_t stableFixedMs;     // Period of the fixed schedule while stable, for the stats
+    uint32_t unstableFixedMs;   // Period of the fixed schedule while unstable, for the stats
+} AdaptiveSamplerConfig_t;
+
+// Counters of the sampler
+typedef struct {
+    uint32_t samples;               // Readings taken
+    uint32_t periodMs;              // Current period
+    uint32_t samplesPerDay;         // Readings per day at the current rate
+    uint32_t fixedSamplesPerDay;    // Readings per day the fixed schedule would have taken
+} AdaptiveSamplerStats_t;
+
+// Define the structure to hold the sampler state
+typedef struct {
+    AdaptiveSamplerConfig_t config;
+    float lastValue;
+    bool hasLast;
+    uint32_t periodMs;
+    uint32_t samples;
+    uint64_t elapsedMs;             // Time covered by the readings so far
+    uint64_t fixedSamplesMilli;     // Readings of the fixed schedule, in thousandths
+} AdaptiveSampler;
+
+// Function to initialize a sampler, the first period is the minimum one
+void AdaptiveSampler_Init(AdaptiveSampler *sampler, const AdaptiveSamplerConfig_t *config);
+
+// Function to account for a reading taken elapsed_ms after the previous one, returns the next period
+uint32_t AdaptiveSampler_Update(AdaptiveSampler *sampler, float value, uint32_t elapsed_ms);
+
+// Function to get a snapshot of the sampler counters
+void AdaptiveSampler_GetStats(const AdaptiveSampler *sampler, AdaptiveSamplerStats_t *stats);
+
+#endif // ADAPTIVE_SAMPLER_H
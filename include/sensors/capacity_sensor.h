@@ -9,11 +9,14 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_private/esp_clk.h"
 #include "driver/mcpwm_cap.h"
 #include "driver/gpio.h"
 #include "common/gpios.h"
+#include "common/timer_wheel.h"
+#include "sensors/acquisition.h"
 
 #define MAX_CAPACITY_FLOAT                10.0
 #define MAX_CAPACITY_PERCENT              0.1
@@ -23,14 +26,15 @@
 typedef struct {
     mcpwm_cap_channel_handle_t cap_chan;
     mcpwm_capture_event_callbacks_t cbs;
-    TaskHandle_t task_to_notify;
+    SemaphoreHandle_t echoDone;         // Given by the echo callback once a pulse is measured
+    StaticSemaphore_t echoDoneBuffer;
+    volatile uint32_t tof_ticks;        // Width of the last echo pulse
     mcpwm_cap_timer_handle_t cap_timer;
     mcpwm_capture_timer_config_t cap_conf;
     mcpwm_capture_channel_config_t cap_ch_conf;
     gpio_config_t io_conf;
-    TimerHandle_t fullTimer;
-    EventGroupHandle_t eventGroup;
-    int timerId;
+    WheelTimer_t fullTimer;
+    int job;                            // Acquisition job that measures the capacity
 } CapacitySensor_t;
 
 /**
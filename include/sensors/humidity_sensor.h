@@ -10,22 +10,25 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
-#include "freertos/timers.h"
 
 /* Libraries includes */
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 /* Internal includes */
+#include "common/timer_wheel.h"
+#include "sensors/adaptive_sampler.h"
+#include "sensors/acquisition.h"
 #include "common/events.h"
 #include "common/gpios.h"
 #include "drivers/DHT22.h"
 #include "driver/gpio.h"
 
 typedef struct {
-    TimerHandle_t stableTimer;
-    EventGroupHandle_t eventGroup;
-    int timerId;
+    WheelTimer_t stableTimer;
+    int job;                    // Acquisition job that reads the sensor
+    AdaptiveSampler sampler;
 } HumiditySensor_t;
 
 /**
@@ -34,4 +37,11 @@ typedef struct {
  */
 void HumiditySensor_Start();
 
+/**
+ * @brief Gets the sampling counters of the humidity sensor.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void HumiditySensor_GetSamplingStats(AdaptiveSamplerStats_t *stats);
+
 #endif // HUMIDITYSENSOR_H
\ No newline at end of file
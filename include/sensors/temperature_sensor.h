@@ -10,24 +10,30 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
-#include "freertos/timers.h"
 
 /* Libraries includes */
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 /* Internal includes */
+#include "common/timer_wheel.h"
+#include "sensors/adaptive_sampler.h"
+#include "sensors/acquisition.h"
 #include "drivers/onewire_bus.h"
 #include "drivers/ds18b20.h"
 #include "common/gpios.h"
 
 typedef struct {
-    TimerHandle_t stableTimer;
-    EventGroupHandle_t eventGroup;
+    WheelTimer_t stableTimer;
+    WheelTimer_t conversionTimer;   // Fires once a conversion is done
+    int convertJob;                 // Acquisition job that starts a conversion
+    int readJob;                    // Acquisition job that reads the conversion
     onewire_rmt_config_t config;
     onewire_bus_handle_t handle;
     onewire_rom_search_context_handler_t context_handler;
     uint8_t device_rom_id[8];
+    AdaptiveSampler sampler;
 } TemperatureSensor_t;
 
 /**
@@ -35,4 +41,11 @@ typedef struct {
  */
 void TemperatureSensor_Start();
 
+/**
+ * @brief Gets the sampling counters of the temperature sensor.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void TemperatureSensor_GetSamplingStats(AdaptiveSamplerStats_t *stats);
+
 #endif // TEMPERATURESENSOR_H
\ No newline at end of file
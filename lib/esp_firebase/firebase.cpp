@@ -1,9 +1,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 #include "esp_http_client.h"
 #include "esp_log.h"
 #include "esp_tls.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "miniz.h"
 #include "cJSON.h"
 #include "firebase.hpp"
 
@@ -12,18 +17,43 @@
 #define FIREBASE_APP_TAG "FirebaseApp"
 #define DEBUG false
 
+#define VALID_EPOCH_S 1600000000    // Wall-clock time before this means it was never set
+
+// gzip member header flags (RFC 1952)
+#define GZIP_FHCRC      0x02
+#define GZIP_FEXTRA     0x04
+#define GZIP_FNAME      0x08
+#define GZIP_FCOMMENT   0x10
+
+// Parsing stages of a gzip response, in stream order
+enum {
+    GZIP_HEADER,
+    GZIP_EXTRA_LEN,
+    GZIP_EXTRA,
+    GZIP_NAME,
+    GZIP_COMMENT,
+    GZIP_HCRC,
+    GZIP_DEFLATE,
+    GZIP_DONE,
+    GZIP_ERROR
+};
+
 extern const char cert_start[] asm("_binary_gtsr1_pem_start");
 
 static int output_len = 0;
+static bool ca_store_initialized = false;
 
 static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
+    FirebaseApp *app = static_cast<FirebaseApp *>(evt->user_data);
+
     switch (evt->event_id){
         case HTTP_EVENT_ERROR:
             if (DEBUG) if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_ERROR");
             break;
         case HTTP_EVENT_ON_CONNECTED:
             if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_ON_CONNECTED");
-            memset(evt->user_data, 0, HTTP_RECV_BUFFER_SIZE);
+            app->recordHandshake();
+            memset(app->local_response_buffer, 0, HTTP_RECV_BUFFER_SIZE);
             output_len = 0;
             break;
         case HTTP_EVENT_HEADER_SENT:
@@ -31,15 +61,33 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
             break;
         case HTTP_EVENT_ON_HEADER:
             if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+            if (strcasecmp(evt->header_key, "ETag") == 0) {
+                snprintf(app->response_etag, ETAG_BUFFER_SIZE, "%s", evt->header_value);
+            } else if (strcasecmp(evt->header_key, "Content-Encoding") == 0 && strcasecmp(evt->header_value, "gzip") == 0) {
+                app->beginGzipResponse();
+            }
             break;
         case HTTP_EVENT_ON_FINISH:
             if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_ON_FINISH");
+            if (app->response_gzipped) {
+                app->finishGzipResponse(output_len);
+            }
             output_len = 0;
             break;
         case HTTP_EVENT_ON_DATA:
             if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            memcpy((char *)evt->user_data + output_len, evt->data, evt->data_len);
-            output_len += evt->data_len;
+            if (app->response_gzipped) {
+                int len = app->inflateResponse((const uint8_t *) evt->data, evt->data_len, output_len);
+                if (len >= 0) {
+                    output_len = len;
+                }
+            } else if (output_len + evt->data_len < HTTP_RECV_BUFFER_SIZE) {
+                memcpy(app->local_response_buffer + output_len, evt->data, evt->data_len);
+                output_len += evt->data_len;
+            } else {
+                ESP_LOGE(HTTP_TAG, "Response larger than %d bytes, truncated", HTTP_RECV_BUFFER_SIZE - 1);
+            }
+            app->local_response_buffer[output_len] = '\0';
             break;
         case HTTP_EVENT_DISCONNECTED:
             if (DEBUG) ESP_LOGI(HTTP_TAG, "HTTP_EVENT_DISCONNECTED");
@@ -53,16 +101,36 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
 void FirebaseApp::firebaseClientInit(void) {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
 
+    // Parse the root CA once into the global store, shared by every client
+    // instead of being parsed again on each connection
+    if (!ca_store_initialized) {
+        esp_err_t err = esp_tls_init_global_ca_store();
+        if (err == ESP_OK) {
+            err = esp_tls_set_global_ca_store((const unsigned char *) FirebaseApp::https_certificate, strlen(FirebaseApp::https_certificate) + 1);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(FIREBASE_APP_TAG, "Failed to set up the CA store: %s", esp_err_to_name(err));
+        }
+        ca_store_initialized = err == ESP_OK;
+    }
+
     esp_http_client_config_t config = {
         .url = "https://google.com",        // Debes configurar esto como un enlace HTTPS válido
-        .cert_pem = FirebaseApp::https_certificate,
+        .cert_pem = ca_store_initialized ? NULL : FirebaseApp::https_certificate,
+        .user_agent = HTTP_USER_AGENT,
         .event_handler = http_event_handler,
         .buffer_size = HTTP_RECV_BUFFER_SIZE,
         .buffer_size_tx = 4096,
-        .user_data = FirebaseApp::local_response_buffer
+        .user_data = this,
+        .use_global_ca_store = ca_store_initialized
     };
 
     FirebaseApp::client = esp_http_client_init(&config);
+
+    // Every request body is JSON, headers persist across requests on the client
+    esp_http_client_set_header(FirebaseApp::client, "content-type", "application/json");
+    // Ask RTDB to return the ETag of the data on every request
+    esp_http_client_set_header(FirebaseApp::client, "X-Firebase-ETag", "true");
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "HTTP Client Initialized");
 }
 
@@ -72,18 +140,70 @@ esp_err_t FirebaseApp::setHeader(const char* header, const char* value) {
     return esp_http_client_set_header(FirebaseApp::client, header, value);
 }
 
-http_ret_t FirebaseApp::performRequest(const char* url, esp_http_client_method_t method, std::string post_field) {
+esp_err_t FirebaseApp::deleteHeader(const char* header) {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
 
+    return esp_http_client_delete_header(FirebaseApp::client, header);
+}
+
+// Sign-in and token requests go to the Identity Toolkit and Secure Token hosts
+static bool is_auth_url(const char* url) {
+    return strncmp(url, "https://" FIREBASE_IDENTITY_HOST "/", sizeof("https://" FIREBASE_IDENTITY_HOST "/") - 1) == 0
+        || strncmp(url, "https://" FIREBASE_SECURETOKEN_HOST "/", sizeof("https://" FIREBASE_SECURETOKEN_HOST "/") - 1) == 0;
+}
+
+http_ret_t FirebaseApp::performRequest(const char* url, esp_http_client_method_t method, const char* post_field) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    FirebaseApp::response_etag[0] = '\0';
+    FirebaseApp::response_gzipped = false;
+
+    if (FirebaseApp::requests_suspended
+            || (FirebaseApp::in_call && FirebaseApp::call_generation != FirebaseApp::cancel_generation)) {
+        if (DEBUG) ESP_LOGW(FIREBASE_APP_TAG, "Requests cancelled, not sending %s", url);
+        return {ESP_ERR_INVALID_STATE, 0};
+    }
+
+    // Every socket operation of the request is bounded by what is left of the deadline
+    int timeout_ms = HTTP_DEFAULT_TIMEOUT_MS;
+    if (FirebaseApp::request_deadline_us != 0) {
+        int64_t remaining_ms = (FirebaseApp::request_deadline_us - esp_timer_get_time()) / 1000;
+        if (remaining_ms <= 0) {
+            ESP_LOGW(FIREBASE_APP_TAG, "Deadline expired before the request was sent");
+            return {ESP_ERR_TIMEOUT, 0};
+        }
+        if (remaining_ms < timeout_ms) {
+            timeout_ms = (int)remaining_ms;
+        }
+    }
+    esp_http_client_set_timeout_ms(FirebaseApp::client, timeout_ms);
+
+    // Only database responses are compressed, the auth endpoints get plain JSON
+    bool gzip = FirebaseApp::accept_gzip && !is_auth_url(url);
+    if (gzip != FirebaseApp::gzip_headers) {
+        if (gzip) {
+            esp_http_client_set_header(FirebaseApp::client, "Accept-Encoding", "gzip");
+            esp_http_client_set_header(FirebaseApp::client, "User-Agent", HTTP_USER_AGENT_GZIP);
+        } else {
+            esp_http_client_delete_header(FirebaseApp::client, "Accept-Encoding");
+            esp_http_client_set_header(FirebaseApp::client, "User-Agent", HTTP_USER_AGENT);
+        }
+        FirebaseApp::gzip_headers = gzip;
+    }
+
+    FirebaseApp::request_start_us = esp_timer_get_time();
+    FirebaseApp::request_free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    FirebaseApp::request_min_free_heap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
     ESP_ERROR_CHECK(esp_http_client_set_url(FirebaseApp::client, url));
     ESP_ERROR_CHECK(esp_http_client_set_method(FirebaseApp::client, method));
-    ESP_ERROR_CHECK(esp_http_client_set_post_field(FirebaseApp::client, post_field.c_str(), post_field.length()));
+    // The body is sent straight from the caller's buffer, no copy is made
+    ESP_ERROR_CHECK(esp_http_client_set_post_field(FirebaseApp::client, post_field, post_field ? strlen(post_field) : 0));
     esp_err_t err = esp_http_client_perform(FirebaseApp::client);
     int status_code = esp_http_client_get_status_code(FirebaseApp::client);
-    if (err != ESP_OK || status_code != 200)
+    if (err != ESP_OK || (status_code != 200 && status_code != 304))
     {
         ESP_LOGE(FIREBASE_APP_TAG, "Error while performing request esp_err_t code=0x%x | status_code=%d", (int)err, status_code);
-        if (DEBUG) ESP_LOGE(FIREBASE_APP_TAG, "request: url=%s \nmethod=%d \npost_field=%s", url, method, post_field.c_str());
+        if (DEBUG) ESP_LOGE(FIREBASE_APP_TAG, "request: url=%s \nmethod=%d \npost_field=%s", url, method, post_field ? post_field : "");
         if (DEBUG) ESP_LOGE(FIREBASE_APP_TAG, "response=\n%s", local_response_buffer);
     }
     return {err, status_code};
@@ -96,6 +216,266 @@ void FirebaseApp::clearHTTPBuffer(void) {
     output_len = 0;
 }
 
+/**
+ * Closes the underlying connection, releasing the TLS session and its buffers.
+ *
+ * The client itself is kept and reconnects on the next request.
+ */
+void FirebaseApp::closeConnection(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    esp_http_client_close(FirebaseApp::client);
+}
+
+/**
+ * Logs the duration and peak heap of the TLS handshake that just completed.
+ *
+ * Called on HTTP_EVENT_ON_CONNECTED, which only fires when a new connection is
+ * opened. The duration includes DNS and TCP connect. The peak is exact when the
+ * handshake set a new heap low-water mark, otherwise it is a lower bound.
+ */
+void FirebaseApp::recordHandshake(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t min_free_heap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    size_t lowest = min_free_heap < FirebaseApp::request_min_free_heap ? min_free_heap : free_heap;
+    int peak = (int)FirebaseApp::request_free_heap - (int)lowest;
+    int retained = (int)FirebaseApp::request_free_heap - (int)free_heap;
+
+    FirebaseApp::handshake_count++;
+    ESP_LOGI(FIREBASE_APP_TAG, "TLS handshake #%lu: %lld ms, peak %d bytes, %d bytes retained, %u bytes free",
+        (unsigned long)FirebaseApp::handshake_count, (esp_timer_get_time() - FirebaseApp::request_start_us) / 1000,
+        peak, retained, (unsigned)free_heap);
+}
+
+/**
+ * Starts a call: the requests that follow, until endCall, make up one call.
+ *
+ * An RTDB call may issue several requests (e.g. a token refresh and a retry);
+ * they all have to finish before the same deadline, and a cancelRequests
+ * issued while the call runs fails the ones not sent yet.
+ *
+ * @param deadline_us Absolute deadline in esp_timer microseconds, 0 for none.
+ */
+void FirebaseApp::beginCall(int64_t deadline_us) {
+    FirebaseApp::request_deadline_us = deadline_us;
+    FirebaseApp::call_generation = FirebaseApp::cancel_generation;
+    FirebaseApp::in_call = true;
+}
+
+void FirebaseApp::endCall(void) {
+    FirebaseApp::request_deadline_us = 0;
+    FirebaseApp::in_call = false;
+}
+
+/**
+ * Makes the call in progress fail with ESP_ERR_INVALID_STATE on its next
+ * request. Calls that begin afterwards are not affected, so a network that
+ * comes back right away needs no resumeRequests. Safe to call from any task;
+ * a request already in flight still runs to its deadline.
+ */
+void FirebaseApp::cancelRequests(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    FirebaseApp::cancel_generation++;
+}
+
+/**
+ * Makes every request fail immediately with ESP_ERR_INVALID_STATE until
+ * resumeRequests is called.
+ */
+void FirebaseApp::suspendRequests(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    FirebaseApp::requests_suspended = true;
+}
+
+void FirebaseApp::resumeRequests(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    FirebaseApp::requests_suspended = false;
+}
+
+/**
+ * Asks the server for gzip-compressed responses on the database requests that follow.
+ *
+ * performRequest sends Accept-Encoding: gzip on RTDB requests only; sign-in and
+ * token refresh requests never carry it. The inflater state (~11 KB) is allocated
+ * on first use and kept for the life of the app. Responses are inflated into
+ * local_response_buffer, so they still have to fit in HTTP_RECV_BUFFER_SIZE once
+ * decompressed.
+ *
+ * @param enable true to send Accept-Encoding: gzip on database requests.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the inflater cannot be allocated.
+ */
+esp_err_t FirebaseApp::setAcceptGzip(bool enable) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    if (enable == FirebaseApp::accept_gzip) {
+        return ESP_OK;
+    }
+
+    if (enable && FirebaseApp::inflator == NULL) {
+        FirebaseApp::inflator = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+        if (FirebaseApp::inflator == NULL) {
+            ESP_LOGE(FIREBASE_APP_TAG, "Failed to allocate the gzip inflater");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    FirebaseApp::accept_gzip = enable;
+
+    return ESP_OK;
+}
+
+/**
+ * Prepares to inflate a response announced as Content-Encoding: gzip.
+ */
+void FirebaseApp::beginGzipResponse(void) {
+    if (FirebaseApp::inflator == NULL) {
+        ESP_LOGE(FIREBASE_APP_TAG, "Unrequested gzip response");
+        return;
+    }
+
+    tinfl_init(FirebaseApp::inflator);
+    FirebaseApp::response_gzipped = true;
+    FirebaseApp::gzip_state = GZIP_HEADER;
+    FirebaseApp::gzip_pos = 0;
+    FirebaseApp::gzip_in_bytes = 0;
+    FirebaseApp::gzip_inflate_us = 0;
+}
+
+/**
+ * Inflates a chunk of a gzip response into local_response_buffer.
+ *
+ * The gzip header may be split across chunks, so it is parsed one field at a
+ * time. The deflate stream is inflated without a separate window: the output
+ * buffer holds the whole document and back-references point into it. The
+ * trailer (CRC32 and size) is ignored; TLS already protects the body.
+ *
+ * @param data Compressed bytes received.
+ * @param len Number of compressed bytes.
+ * @param out_len Bytes already inflated into local_response_buffer.
+ *
+ * @return New number of inflated bytes, or -1 if the response is corrupt or too large.
+ */
+int FirebaseApp::inflateResponse(const uint8_t* data, size_t len, int out_len) {
+    int64_t start_us = esp_timer_get_time();
+    FirebaseApp::gzip_in_bytes += len;
+
+    while (len > 0 && FirebaseApp::gzip_state < GZIP_DONE) {
+        uint8_t state = FirebaseApp::gzip_state;
+
+        if (state == GZIP_DEFLATE) {
+            size_t in_size = len;
+            size_t out_size = HTTP_RECV_BUFFER_SIZE - 1 - out_len;
+            tinfl_status status = tinfl_decompress(FirebaseApp::inflator, data, &in_size,
+                (mz_uint8 *) FirebaseApp::local_response_buffer, (mz_uint8 *) FirebaseApp::local_response_buffer + out_len, &out_size,
+                TINFL_FLAG_HAS_MORE_INPUT | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+            data += in_size;
+            len -= in_size;
+            out_len += out_size;
+
+            if (status == TINFL_STATUS_DONE) {
+                FirebaseApp::gzip_state = GZIP_DONE;
+            } else if (status == TINFL_STATUS_HAS_MORE_OUTPUT) {
+                ESP_LOGE(FIREBASE_APP_TAG, "Inflated response larger than %d bytes", HTTP_RECV_BUFFER_SIZE - 1);
+                FirebaseApp::gzip_state = GZIP_ERROR;
+            } else if (status < 0) {
+                ESP_LOGE(FIREBASE_APP_TAG, "Corrupt gzip response (%d)", (int)status);
+                FirebaseApp::gzip_state = GZIP_ERROR;
+            } else if (in_size == 0) {
+                break;
+            }
+            continue;
+        }
+
+        uint8_t byte = *data++;
+        len--;
+        bool field_done = false;
+
+        switch (state) {
+            case GZIP_HEADER:
+                // Magic, method, flags, mtime, extra flags, OS
+                FirebaseApp::gzip_header[FirebaseApp::gzip_pos++] = byte;
+                if (FirebaseApp::gzip_pos == sizeof(FirebaseApp::gzip_header)) {
+                    if (gzip_header[0] != 0x1f || gzip_header[1] != 0x8b || gzip_header[2] != 8) {
+                        ESP_LOGE(FIREBASE_APP_TAG, "Invalid gzip header");
+                        FirebaseApp::gzip_state = GZIP_ERROR;
+                        continue;
+                    }
+                    FirebaseApp::gzip_flags = gzip_header[3];
+                    field_done = true;
+                }
+                break;
+            case GZIP_EXTRA_LEN:
+                FirebaseApp::gzip_header[FirebaseApp::gzip_pos++] = byte;
+                if (FirebaseApp::gzip_pos == 2) {
+                    // Reuse gzip_pos as the number of extra bytes left to skip
+                    FirebaseApp::gzip_pos = gzip_header[0] | (gzip_header[1] << 8);
+                    FirebaseApp::gzip_state = GZIP_EXTRA;
+                    if (FirebaseApp::gzip_pos > 0) {
+                        continue;
+                    }
+                    field_done = true;
+                }
+                break;
+            case GZIP_EXTRA:
+                field_done = --FirebaseApp::gzip_pos == 0;
+                break;
+            case GZIP_NAME:
+            case GZIP_COMMENT:
+                field_done = byte == 0;
+                break;
+            case GZIP_HCRC:
+                field_done = ++FirebaseApp::gzip_pos == 2;
+                break;
+        }
+
+        if (field_done) {
+            // Move on to the next optional field present in the header
+            uint8_t flags = FirebaseApp::gzip_flags;
+            state = FirebaseApp::gzip_state;
+            if (state < GZIP_EXTRA_LEN && (flags & GZIP_FEXTRA)) {
+                FirebaseApp::gzip_state = GZIP_EXTRA_LEN;
+            } else if (state < GZIP_NAME && (flags & GZIP_FNAME)) {
+                FirebaseApp::gzip_state = GZIP_NAME;
+            } else if (state < GZIP_COMMENT && (flags & GZIP_FCOMMENT)) {
+                FirebaseApp::gzip_state = GZIP_COMMENT;
+            } else if (state < GZIP_HCRC && (flags & GZIP_FHCRC)) {
+                FirebaseApp::gzip_state = GZIP_HCRC;
+            } else {
+                FirebaseApp::gzip_state = GZIP_DEFLATE;
+            }
+            FirebaseApp::gzip_pos = 0;
+        }
+    }
+
+    FirebaseApp::gzip_inflate_us += esp_timer_get_time() - start_us;
+    return FirebaseApp::gzip_state == GZIP_ERROR ? -1 : out_len;
+}
+
+/**
+ * Logs the compression ratio and inflate time of the response just received.
+ */
+void FirebaseApp::finishGzipResponse(int out_len) {
+    if (FirebaseApp::gzip_in_bytes == 0) {
+        return;
+    }
+
+    if (FirebaseApp::gzip_state != GZIP_DONE) {
+        ESP_LOGE(FIREBASE_APP_TAG, "Truncated or corrupt gzip response");
+        FirebaseApp::local_response_buffer[0] = '\0';
+        return;
+    }
+
+    ESP_LOGI(FIREBASE_APP_TAG, "gzip response: %u -> %d bytes (%d%%), inflated in %lld us",
+        (unsigned)FirebaseApp::gzip_in_bytes, out_len,
+        out_len > 0 ? (int)(FirebaseApp::gzip_in_bytes * 100 / out_len) : 0, FirebaseApp::gzip_inflate_us);
+}
+
 esp_err_t FirebaseApp::getRefreshToken(bool register_account) {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
 
@@ -109,11 +489,10 @@ esp_err_t FirebaseApp::getRefreshToken(bool register_account) {
     char *account_json = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
 
-    FirebaseApp::setHeader("content-type", "application/json");
     if (register_account) {
-        http_ret = FirebaseApp::performRequest(FirebaseApp::register_url.c_str(), HTTP_METHOD_POST, account_json);
+        http_ret = FirebaseApp::performRequest(FirebaseApp::register_url, HTTP_METHOD_POST, account_json);
     } else {
-        http_ret = FirebaseApp::performRequest(FirebaseApp::login_url.c_str(), HTTP_METHOD_POST, account_json);
+        http_ret = FirebaseApp::performRequest(FirebaseApp::login_url, HTTP_METHOD_POST, account_json);
     }
 
     free(account_json);
@@ -123,9 +502,8 @@ esp_err_t FirebaseApp::getRefreshToken(bool register_account) {
         cJSON *root = cJSON_Parse(begin);
         if (root) {
             cJSON *refreshToken = cJSON_GetObjectItemCaseSensitive(root, "refreshToken");
-            if (refreshToken && cJSON_IsString(refreshToken)) {
-                FirebaseApp::refresh_token = refreshToken->valuestring;
-                if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "Refresh Token=%s", FirebaseApp::refresh_token.c_str());
+            if (refreshToken && cJSON_IsString(refreshToken) && FirebaseApp::setRefreshToken(refreshToken->valuestring) == ESP_OK) {
+                if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "Refresh Token=%s", FirebaseApp::refresh_token);
                 cJSON_Delete(root);
                 return ESP_OK;
             }
@@ -143,13 +521,12 @@ esp_err_t FirebaseApp::getAuthToken() {
 
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "grant_type", "refresh_token");
-    cJSON_AddStringToObject(root, "refresh_token", FirebaseApp::refresh_token.c_str());
+    cJSON_AddStringToObject(root, "refresh_token", FirebaseApp::refresh_token);
 
     char *token_post_data = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
 
-    FirebaseApp::setHeader("content-type", "application/json");
-    http_ret = FirebaseApp::performRequest(FirebaseApp::auth_url.c_str(), HTTP_METHOD_POST, token_post_data);
+    http_ret = FirebaseApp::performRequest(FirebaseApp::auth_url, HTTP_METHOD_POST, token_post_data);
     free(token_post_data);
 
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
@@ -158,8 +535,29 @@ esp_err_t FirebaseApp::getAuthToken() {
         if (root) {
             cJSON *accessToken = cJSON_GetObjectItemCaseSensitive(root, "access_token");
             if (accessToken && cJSON_IsString(accessToken)) {
-                FirebaseApp::auth_token = accessToken->valuestring;
-                if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "Auth Token=%s", FirebaseApp::auth_token.c_str());
+                // expires_in is sent as a string holding seconds (usually "3600")
+                int64_t expires_in_s = 3600;
+                cJSON *expiresIn = cJSON_GetObjectItemCaseSensitive(root, "expires_in");
+                if (expiresIn && cJSON_IsString(expiresIn)) {
+                    expires_in_s = strtoll(expiresIn->valuestring, NULL, 10);
+                } else if (expiresIn && cJSON_IsNumber(expiresIn)) {
+                    expires_in_s = (int64_t) expiresIn->valuedouble;
+                }
+
+                if (FirebaseApp::setAuthToken(accessToken->valuestring, expires_in_s) != ESP_OK) {
+                    cJSON_Delete(root);
+                    return ESP_FAIL;
+                }
+
+                // The securetoken endpoint may rotate the refresh token
+                cJSON *refreshToken = cJSON_GetObjectItemCaseSensitive(root, "refresh_token");
+                if (refreshToken && cJSON_IsString(refreshToken)) {
+                    FirebaseApp::setRefreshToken(refreshToken->valuestring);
+                }
+
+                FirebaseApp::saveSession();
+
+                if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "Auth Token=%s", FirebaseApp::auth_query + strlen(AUTH_QUERY_PREFIX));
                 cJSON_Delete(root);
                 return ESP_OK;
             }
@@ -170,13 +568,216 @@ esp_err_t FirebaseApp::getAuthToken() {
     return ESP_FAIL;
 }
 
-FirebaseApp::FirebaseApp(const char *api_key) : https_certificate(cert_start), api_key(api_key) {
+/**
+ * Installs a new ID token and precomputes the auth query used by RTDB requests.
+ *
+ * @param token The ID token.
+ * @param expires_in_s Seconds until the token expires.
+ *
+ * @return ESP_OK on success, ESP_FAIL if the token does not fit the auth query buffer.
+ */
+esp_err_t FirebaseApp::setAuthToken(const char* token, int64_t expires_in_s) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    int len = snprintf(FirebaseApp::auth_query, AUTH_QUERY_BUFFER_SIZE, AUTH_QUERY_PREFIX "%s", token);
+    if (len < 0 || len >= AUTH_QUERY_BUFFER_SIZE) {
+        ESP_LOGE(FIREBASE_APP_TAG, "Auth token too long (%d bytes)", len);
+        FirebaseApp::auth_query[0] = '\0';
+        FirebaseApp::auth_query_len = 0;
+        return ESP_FAIL;
+    }
+    FirebaseApp::auth_query_len = len;
+    FirebaseApp::auth_token_expiry_us = esp_timer_get_time() + expires_in_s * 1000000LL;
+
+    return ESP_OK;
+}
+
+/**
+ * Stores a new refresh token.
+ *
+ * @param token The refresh token.
+ *
+ * @return ESP_OK on success, ESP_FAIL if the token does not fit its buffer.
+ */
+esp_err_t FirebaseApp::setRefreshToken(const char* token) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    size_t len = strlen(token);
+    if (len >= REFRESH_TOKEN_BUFFER_SIZE) {
+        ESP_LOGE(FIREBASE_APP_TAG, "Refresh token too long (%d bytes)", (int)len);
+        return ESP_FAIL;
+    }
+    memcpy(FirebaseApp::refresh_token, token, len + 1);
+
+    return ESP_OK;
+}
+
+/**
+ * Persists the account, refresh token and ID token in NVS.
+ *
+ * The ID token expiry is stored as wall-clock time, so it is only reusable after a
+ * reboot once the clock has been set; otherwise it is stored as 0 and the refresh
+ * token is used instead.
+ *
+ * @return ESP_OK on success, or error code on failure.
+ */
+esp_err_t FirebaseApp::saveSession(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    // Open NVS handle
+    nvs_handle_t my_handle;
+    esp_err_t err = nvs_open(FIREBASE_NVS_NAMESPACE, NVS_READWRITE, &my_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(NVS_TAG, "Failed to open namespace %s", FIREBASE_NVS_NAMESPACE);
+        return err;
+    }
+
+    time_t now = time(NULL);
+    int64_t expiry_s = 0;
+    if (now > VALID_EPOCH_S) {
+        expiry_s = now + FirebaseApp::getAuthTokenTimeToLive() / 1000000LL;
+    }
+
+    err = nvs_set_str(my_handle, "email", FirebaseApp::user_account.user_email);
+    if (err == ESP_OK) err = nvs_set_str(my_handle, "refresh", FirebaseApp::refresh_token);
+    if (err == ESP_OK) err = nvs_set_str(my_handle, "id_token", FirebaseApp::auth_query + strlen(AUTH_QUERY_PREFIX));
+    if (err == ESP_OK) err = nvs_set_i64(my_handle, "expiry", expiry_s);
+    if (err == ESP_OK) err = nvs_commit(my_handle);
+
+    // Close NVS handle
+    nvs_close(my_handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(NVS_TAG, "Failed to save session: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+/**
+ * Restores the session persisted by saveSession for the current account.
+ *
+ * The refresh token is always restored. The ID token is only restored when the
+ * wall clock shows it is still outside the refresh margin.
+ *
+ * @return ESP_OK if a refresh token was restored, ESP_FAIL otherwise.
+ */
+esp_err_t FirebaseApp::loadSession(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    // Open NVS handle
+    nvs_handle_t my_handle;
+    esp_err_t err = nvs_open(FIREBASE_NVS_NAMESPACE, NVS_READONLY, &my_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    char email[128];
+    size_t length = sizeof(email);
+    err = nvs_get_str(my_handle, "email", email, &length);
+    if (err != ESP_OK || strcmp(email, FirebaseApp::user_account.user_email) != 0) {
+        nvs_close(my_handle);
+        return ESP_FAIL;
+    }
+
+    length = REFRESH_TOKEN_BUFFER_SIZE;
+    err = nvs_get_str(my_handle, "refresh", FirebaseApp::refresh_token, &length);
+    if (err != ESP_OK || length <= 1) {
+        FirebaseApp::refresh_token[0] = '\0';
+        nvs_close(my_handle);
+        return ESP_FAIL;
+    }
+
+    int64_t expiry_s = 0;
+    time_t now = time(NULL);
+    nvs_get_i64(my_handle, "expiry", &expiry_s);
+
+    // The ID token is read straight in behind the auth query prefix
+    size_t prefix_len = strlen(AUTH_QUERY_PREFIX);
+    length = AUTH_QUERY_BUFFER_SIZE - prefix_len;
+    if (now > VALID_EPOCH_S && expiry_s - now > AUTH_TOKEN_REFRESH_MARGIN_S
+            && nvs_get_str(my_handle, "id_token", FirebaseApp::auth_query + prefix_len, &length) == ESP_OK) {
+        memcpy(FirebaseApp::auth_query, AUTH_QUERY_PREFIX, prefix_len);
+        FirebaseApp::auth_query_len = prefix_len + length - 1;
+        FirebaseApp::auth_token_expiry_us = esp_timer_get_time() + (expiry_s - now) * 1000000LL;
+    } else {
+        FirebaseApp::auth_query[0] = '\0';
+        FirebaseApp::auth_query_len = 0;
+    }
+
+    // Close NVS handle
+    nvs_close(my_handle);
+
+    return ESP_OK;
+}
+
+/**
+ * Exchanges the stored refresh token for a new ID token.
+ *
+ * @return ESP_OK if a new ID token was obtained, ESP_FAIL otherwise.
+ */
+esp_err_t FirebaseApp::refreshAuthToken(void) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    if (FirebaseApp::refresh_token[0] == '\0') {
+        ESP_LOGE(FIREBASE_APP_TAG, "No refresh token available");
+        return ESP_FAIL;
+    }
+
+    FirebaseApp::clearHTTPBuffer();
+    esp_err_t err = FirebaseApp::getAuthToken();
+    FirebaseApp::clearHTTPBuffer();
+
+    if (err != ESP_OK) {
+        ESP_LOGE(FIREBASE_APP_TAG, "Failed to refresh auth token");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(FIREBASE_APP_TAG, "Auth token refreshed, valid for %lld s", FirebaseApp::getAuthTokenTimeToLive() / 1000000LL);
+    return ESP_OK;
+}
+
+/**
+ * Returns the time left before the current ID token expires.
+ *
+ * @return Microseconds until expiry, 0 or negative if already expired.
+ */
+int64_t FirebaseApp::getAuthTokenTimeToLive(void) {
+    return FirebaseApp::auth_token_expiry_us - esp_timer_get_time();
+}
+
+/**
+ * Checks whether the ID token is inside the refresh margin.
+ *
+ * @return true if the token should be refreshed before the next request.
+ */
+bool FirebaseApp::isAuthTokenExpiring(void) {
+    return FirebaseApp::getAuthTokenTimeToLive() <= AUTH_TOKEN_REFRESH_MARGIN_S * 1000000LL;
+}
+
+/**
+ * Returns the ".json?auth=<token>" query appended to every RTDB URL.
+ *
+ * The query is rebuilt once per token refresh so requests only have to copy it.
+ *
+ * @param len Receives the length of the query, excluding the terminator.
+ *
+ * @return Pointer to the NUL-terminated query.
+ */
+const char* FirebaseApp::getAuthQuery(size_t* len) {
+    *len = FirebaseApp::auth_query_len;
+    return FirebaseApp::auth_query;
+}
+
+FirebaseApp::FirebaseApp(const char *api_key) : https_certificate(cert_start) {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
 
     FirebaseApp::local_response_buffer = (char *)malloc(HTTP_RECV_BUFFER_SIZE);
-    FirebaseApp::register_url += FirebaseApp::api_key;
-    FirebaseApp::login_url += FirebaseApp::api_key;
-    FirebaseApp::auth_url += FirebaseApp::api_key;
+    FirebaseApp::auth_query = (char *)calloc(1, AUTH_QUERY_BUFFER_SIZE);
+    FirebaseApp::response_etag[0] = '\0';
+    FirebaseApp::refresh_token[0] = '\0';
+    snprintf(FirebaseApp::register_url, AUTH_URL_BUFFER_SIZE, "https://" FIREBASE_IDENTITY_HOST "/v1/accounts:signUp?key=%s", api_key);
+    snprintf(FirebaseApp::login_url, AUTH_URL_BUFFER_SIZE, "https://" FIREBASE_IDENTITY_HOST "/v1/accounts:signInWithPassword?key=%s", api_key);
+    snprintf(FirebaseApp::auth_url, AUTH_URL_BUFFER_SIZE, "https://" FIREBASE_SECURETOKEN_HOST "/v1/token?key=%s", api_key);
     firebaseClientInit();
 }
 
@@ -184,6 +785,8 @@ FirebaseApp::~FirebaseApp() {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
 
     free(FirebaseApp::local_response_buffer);
+    free(FirebaseApp::auth_query);
+    free(FirebaseApp::inflator);
     esp_http_client_cleanup(FirebaseApp::client);
 }
 
@@ -242,3 +845,43 @@ esp_err_t FirebaseApp::loginUserAccount(const user_account_t &account) {
     if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "Login to user successful");
     return ESP_OK;
 }
+
+/**
+ * Resumes the persisted session, logging in with the password only if needed.
+ *
+ * Tries, in order: the persisted ID token (no request), the persisted refresh
+ * token (one request), and a full password login (two requests).
+ *
+ * @param account The user account to resume the session for.
+ *
+ * @return ESP_OK if a valid ID token is available, ESP_FAIL otherwise.
+ */
+esp_err_t FirebaseApp::resumeSession(const user_account_t &account) {
+    if (DEBUG) ESP_LOGI(FIREBASE_APP_TAG, "on %s", __func__);
+
+    int64_t start_us = esp_timer_get_time();
+    const char* source = "password login";
+
+    FirebaseApp::user_account.user_email = account.user_email;
+    FirebaseApp::user_account.user_password = account.user_password;
+
+    esp_err_t err = ESP_FAIL;
+    if (FirebaseApp::loadSession() == ESP_OK) {
+        if (!FirebaseApp::isAuthTokenExpiring()) {
+            source = "stored ID token";
+            err = ESP_OK;
+        } else if (FirebaseApp::refreshAuthToken() == ESP_OK) {
+            source = "stored refresh token";
+            err = ESP_OK;
+        }
+    }
+
+    if (err != ESP_OK) {
+        err = FirebaseApp::loginUserAccount(account);
+    }
+
+    if (err == ESP_OK) {
+        ESP_LOGI(FIREBASE_APP_TAG, "Session ready in %lld ms using %s", (esp_timer_get_time() - start_us) / 1000, source);
+    }
+    return err;
+}
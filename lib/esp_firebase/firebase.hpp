@@ -2,17 +2,28 @@
 #define  _FIREBASE_H_
 
 #include "esp_http_client.h"
-#include <string>
 
 #define HTTP_RECV_BUFFER_SIZE 4096
-
-using namespace std;
+#define AUTH_QUERY_PREFIX ".json?auth="
+#define AUTH_QUERY_BUFFER_SIZE 1536         // AUTH_QUERY_PREFIX followed by the ID token (~1 KB JWT)
+#define REFRESH_TOKEN_BUFFER_SIZE 512       // Refresh tokens are opaque, usually 200-300 chars
+#define AUTH_URL_BUFFER_SIZE 128            // Identity Toolkit / securetoken endpoint plus the API key
+#define ETAG_BUFFER_SIZE 48                 // RTDB ETags are 28-byte base64 SHA-1 digests
+#define AUTH_TOKEN_REFRESH_MARGIN_S 300     // Refresh the ID token this long before it expires
+#define FIREBASE_NVS_NAMESPACE "firebase"    // NVS namespace holding the persisted session
+#define HTTP_DEFAULT_TIMEOUT_MS 5000        // Per-request timeout when no deadline is set
+#define HTTP_USER_AGENT "ESP32 HTTP Client/1.0"            // esp_http_client's default
+#define HTTP_USER_AGENT_GZIP HTTP_USER_AGENT " (gzip)"     // Google front ends only compress for agents mentioning gzip
+#define FIREBASE_IDENTITY_HOST "identitytoolkit.googleapis.com"
+#define FIREBASE_SECURETOKEN_HOST "securetoken.googleapis.com"
 
 struct user_account_t {
     const char* user_email;
     const char* user_password;
 };
 
+struct tinfl_decompressor_tag;
+
 struct http_ret_t {
     esp_err_t err;
     int status_code;
@@ -21,31 +32,80 @@ struct http_ret_t {
 class FirebaseApp {
     private:
         const char* https_certificate;
-        std::string api_key = "";
-        std::string register_url = "https://identitytoolkit.googleapis.com/v1/accounts:signUp?key=";
-        std::string login_url = "https://identitytoolkit.googleapis.com/v1/accounts:signInWithPassword?key=";
-        std::string auth_url = "https://securetoken.googleapis.com/v1/token?key=";
-        std::string refresh_token = "";
+        char register_url[AUTH_URL_BUFFER_SIZE];
+        char login_url[AUTH_URL_BUFFER_SIZE];
+        char auth_url[AUTH_URL_BUFFER_SIZE];
+        char refresh_token[REFRESH_TOKEN_BUFFER_SIZE];
+        int64_t auth_token_expiry_us = 0;
+        char* auth_query;
+        size_t auth_query_len = 0;
         esp_http_client_handle_t client;
         bool client_initialized = false;
 
+        // Handshake profiling, sampled in performRequest and closed on HTTP_EVENT_ON_CONNECTED
+        int64_t request_start_us = 0;
+        size_t request_free_heap = 0;
+        size_t request_min_free_heap = 0;
+        uint32_t handshake_count = 0;
+
+        int64_t request_deadline_us = 0;        // 0: no deadline, HTTP_DEFAULT_TIMEOUT_MS applies
+        bool in_call = false;
+        uint32_t call_generation = 0;           // cancel_generation when the current call began
+        volatile uint32_t cancel_generation = 0;
+        volatile bool requests_suspended = false;
+
+        // Gzip responses are inflated straight into local_response_buffer, which doubles as the window
+        bool accept_gzip = false;
+        bool gzip_headers = false;              // Accept-Encoding currently set on the client
+        struct tinfl_decompressor_tag* inflator = NULL;
+        uint8_t gzip_state = 0;
+        uint8_t gzip_flags = 0;
+        uint8_t gzip_header[10];
+        size_t gzip_pos = 0;                    // Bytes of the current gzip header field seen so far
+        size_t gzip_in_bytes = 0;
+        int64_t gzip_inflate_us = 0;
+
         void firebaseClientInit(void);
         esp_err_t getRefreshToken(bool register_account);
         esp_err_t getAuthToken();
+        esp_err_t setAuthToken(const char* token, int64_t expires_in_s);
+        esp_err_t setRefreshToken(const char* token);
+        esp_err_t saveSession(void);
+        esp_err_t loadSession(void);
 
     public:
         user_account_t user_account = {"", ""};
         char* local_response_buffer;
-        std::string auth_token = "";
+        char response_etag[ETAG_BUFFER_SIZE];
+        bool response_gzipped = false;
 
-        http_ret_t performRequest(const char* url, esp_http_client_method_t method, std::string post_field = "");
+        http_ret_t performRequest(const char* url, esp_http_client_method_t method, const char* post_field = NULL);
         esp_err_t setHeader(const char* header, const char* value);
+        esp_err_t deleteHeader(const char* header);
         void clearHTTPBuffer(void);
+        void closeConnection(void);
+        void recordHandshake(void);
+        void beginCall(int64_t deadline_us);
+        void endCall(void);
+        void cancelRequests(void);
+        void suspendRequests(void);
+        void resumeRequests(void);
+
+        esp_err_t setAcceptGzip(bool enable);
+        void beginGzipResponse(void);
+        int inflateResponse(const uint8_t* data, size_t len, int out_len);
+        void finishGzipResponse(int out_len);
+
+        esp_err_t refreshAuthToken(void);
+        int64_t getAuthTokenTimeToLive(void);
+        bool isAuthTokenExpiring(void);
+        const char* getAuthQuery(size_t* len);
 
         FirebaseApp(const char * api_key);
         ~FirebaseApp();
         esp_err_t registerUserAccount(const user_account_t& account);
         esp_err_t loginUserAccount(const user_account_t& account);
+        esp_err_t resumeSession(const user_account_t& account);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,7 @@
-#include <iostream>
+#include <stdlib.h>
+#include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "cJSON.h"
 #include "firebase.hpp"
@@ -10,7 +12,15 @@
 
 RTDB::RTDB() {
     app = nullptr;
-    base_database_url = "";
+    RTDB::setBaseUrl("");
+    url_buffer = (char *)malloc(RTDB_URL_BUFFER_SIZE);
+}
+
+RTDB::~RTDB() {
+    free(url_buffer);
+    for (int i = 0; i < RTDB_CACHE_SIZE; i++) {
+        free(cache[i].body);
+    }
 }
 
 /**
@@ -25,10 +35,76 @@ void RTDB::initialize(FirebaseApp* app, const char* database_url) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
     this->app = app;
-    this->base_database_url = database_url;
+    RTDB::setBaseUrl(database_url);
+}
+
+RTDB::RTDB(FirebaseApp* app, const char* database_url) : app(app) {
+    RTDB::setBaseUrl(database_url);
+    url_buffer = (char *)malloc(RTDB_URL_BUFFER_SIZE);
+}
+
+/**
+ * Copies the database URL into the fixed base URL buffer.
+ *
+ * @param database_url The URL of the database, truncated if it does not fit.
+ */
+void RTDB::setBaseUrl(const char* database_url) {
+    int len = snprintf(base_database_url, RTDB_BASE_URL_BUFFER_SIZE, "%s", database_url);
+    if (len >= RTDB_BASE_URL_BUFFER_SIZE) {
+        ESP_LOGE(RTDB_TAG, "Database URL too long (%d bytes)", len);
+        len = RTDB_BASE_URL_BUFFER_SIZE - 1;
+    }
+    base_database_url_len = len;
+}
+
+/**
+ * Builds the request URL for the given path into the preallocated URL buffer.
+ *
+ * The URL is base_database_url + path + the auth query precomputed by FirebaseApp
+ * on every token refresh, so building it copies three known-length pieces and
+ * never allocates.
+ *
+ * @param path The path of the data in the database.
+ *
+ * @return Pointer to the URL buffer, or NULL if the URL does not fit.
+ */
+const char* RTDB::buildUrl(const char* path) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    size_t base_len = RTDB::base_database_url_len;
+    size_t path_len = strlen(path);
+    size_t auth_len;
+    const char* auth_query = this->app->getAuthQuery(&auth_len);
+
+    if (url_buffer == NULL || base_len + path_len + auth_len >= RTDB_URL_BUFFER_SIZE) {
+        ESP_LOGE(RTDB_TAG, "URL for path %s does not fit in %d bytes", path, RTDB_URL_BUFFER_SIZE);
+        return NULL;
+    }
+
+    char* end = url_buffer;
+    memcpy(end, RTDB::base_database_url, base_len);
+    end += base_len;
+    memcpy(end, path, path_len);
+    end += path_len;
+    memcpy(end, auth_query, auth_len + 1);
+
+    return url_buffer;
 }
 
-RTDB::RTDB(FirebaseApp* app, const char* database_url) : app(app), base_database_url(database_url) { }
+/**
+ * Refreshes the ID token inline when it is about to expire.
+ *
+ * The background refresh task normally renews the token ahead of time; this is
+ * the fallback for when it has not run yet (e.g. right after a long stall).
+ */
+void RTDB::ensureAuthToken() {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    if (this->app->isAuthTokenExpiring()) {
+        ESP_LOGI(RTDB_TAG, "Auth token about to expire, refreshing before request");
+        this->app->refreshAuthToken();
+    }
+}
 
 /**
  * Retrieves data from the Real-Time Database at the specified path.
@@ -42,31 +118,74 @@ RTDB::RTDB(FirebaseApp* app, const char* database_url) : app(app), base_database
 cJSON* RTDB::getData(const char* path) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
-    std::string url = RTDB::base_database_url;
-    url += path;
-    url += ".json?auth=" + this->app->auth_token;
+    // Serve recent reads straight from the cache
+    rtdb_cache_entry_t* entry = RTDB::findCacheEntry(path);
+    if (entry && esp_timer_get_time() - entry->fetched_us < cache_ttl_us) {
+        cache_hits++;
+        return cJSON_Parse(entry->body);
+    }
 
-    this->app->setHeader("content-type", "application/json");
-    http_ret_t http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_GET, "");
+    RTDB::ensureAuthToken();
+
+    const char* url = RTDB::buildUrl(path);
+    if (url == NULL) {
+        return NULL;
+    }
+
+    // Revalidate the cached copy instead of downloading it again
+    if (entry) {
+        this->app->setHeader("if-none-match", entry->etag);
+    }
+    http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_GET);
+    if (entry) {
+        this->app->deleteHeader("if-none-match");
+    }
+
+    // Unchanged documents are served from the cache, whether the server answered 304 or resent them
+    if (entry && http_ret.err == ESP_OK
+            && (http_ret.status_code == 304 || (http_ret.status_code == 200 && strcmp(this->app->response_etag, entry->etag) == 0))) {
+        if (DEBUG) ESP_LOGI(RTDB_TAG, "Data with path=%s not modified", path);
+        cache_not_modified++;
+        entry->fetched_us = esp_timer_get_time();
+        this->app->clearHTTPBuffer();
+        return cJSON_Parse(entry->body);
+    }
 
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
         const char* begin = this->app->local_response_buffer;
 
         cJSON* data_json = cJSON_Parse(begin);
         if (DEBUG) ESP_LOGI(RTDB_TAG, "Data with path=%s acquired", path);
+        cache_misses++;
+        if (data_json) {
+            RTDB::storeCacheEntry(path, this->app->response_etag, begin);
+        }
         this->app->clearHTTPBuffer();
         return data_json;
     } else {
         ESP_LOGE(RTDB_TAG, "Error while getting data at path %s| esp_err_t=%d | status_code=%d", path, (int)http_ret.err, http_ret.status_code);
-        ESP_LOGI(RTDB_TAG, "Token expired ? Trying refreshing auth");
-        this->app->setHeader("content-type", "application/json");
-        http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_GET, "");
+        this->app->clearHTTPBuffer();
+        if (http_ret.status_code == 401) {
+            ESP_LOGI(RTDB_TAG, "Token expired ? Trying refreshing auth");
+            if (this->app->refreshAuthToken() != ESP_OK) {
+                return NULL;
+            }
+            url = RTDB::buildUrl(path);
+            if (url == NULL) {
+                return NULL;
+            }
+        }
+        http_ret = this->app->performRequest(url, HTTP_METHOD_GET);
 
         if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
             const char* begin = this->app->local_response_buffer;
 
             cJSON* data_json = cJSON_Parse(begin);
             ESP_LOGI(RTDB_TAG, "Data with path=%s acquired", path);
+            cache_misses++;
+            if (data_json) {
+                RTDB::storeCacheEntry(path, this->app->response_etag, begin);
+            }
             this->app->clearHTTPBuffer();
             return data_json;
         } else {
@@ -90,11 +209,14 @@ cJSON* RTDB::getData(const char* path) {
 esp_err_t RTDB::putData(const char* path, const char* json_str) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
-    std::string url = RTDB::base_database_url;
-    url += path;
-    url += ".json?auth=" + this->app->auth_token;
-    this->app->setHeader("content-type", "application/json");
-    http_ret_t http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_PUT, json_str);
+    RTDB::ensureAuthToken();
+
+    const char* url = RTDB::buildUrl(path);
+    if (url == NULL) {
+        return ESP_FAIL;
+    }
+    http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_PUT, json_str);
+    RTDB::invalidateCache(path);
     this->app->clearHTTPBuffer();
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
         ESP_LOGI(RTDB_TAG, "PUT successful");
@@ -137,11 +259,14 @@ esp_err_t RTDB::putData(const char* path, cJSON* data_json) {
 esp_err_t RTDB::postData(const char* path, const char* json_str) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
-    std::string url = RTDB::base_database_url;
-    url += path;
-    url += ".json?auth=" + this->app->auth_token;
-    this->app->setHeader("content-type", "application/json");
-    http_ret_t http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_POST, json_str);
+    RTDB::ensureAuthToken();
+
+    const char* url = RTDB::buildUrl(path);
+    if (url == NULL) {
+        return ESP_FAIL;
+    }
+    http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_POST, json_str);
+    RTDB::invalidateCache(path);
     this->app->clearHTTPBuffer();
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
         ESP_LOGI(RTDB_TAG, "POST successful");
@@ -186,11 +311,14 @@ esp_err_t RTDB::postData(const char* path, cJSON* data_json) {
 esp_err_t RTDB::patchData(const char* path, const char* json_str) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
-    std::string url = RTDB::base_database_url;
-    url += path;
-    url += ".json?auth=" + this->app->auth_token;
-    this->app->setHeader("content-type", "application/json");
-    http_ret_t http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_PATCH, json_str);
+    RTDB::ensureAuthToken();
+
+    const char* url = RTDB::buildUrl(path);
+    if (url == NULL) {
+        return ESP_FAIL;
+    }
+    http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_PATCH, json_str);
+    RTDB::invalidateCache(path);
     this->app->clearHTTPBuffer();
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
         ESP_LOGI(RTDB_TAG, "PATCH successful");
@@ -220,6 +348,154 @@ esp_err_t RTDB::patchData(const char* path, cJSON* data_json) {
     return err;
 }
 
+/**
+ * Patches data at the specified path only if it has not changed since it was read.
+ *
+ * The patch is merged into the cached document for path and written back with a
+ * PUT carrying an if-match header, so the common case costs one round trip and
+ * refreshes the cache. If the server answers 412 (someone else wrote in between),
+ * or there is no cached document for the ETag, only the patched fields are sent
+ * with a plain PATCH so other fields are never overwritten with stale values. Any
+ * other failure of the PUT is returned as is.
+ *
+ * @param path The path where the data will be patched.
+ * @param etag The ETag the data is expected to have, NULL to use the cached one.
+ * @param json_str The JSON object holding the fields to update.
+ *
+ * @return ESP_OK if the data was written, ESP_FAIL otherwise.
+ */
+esp_err_t RTDB::patchIfMatch(const char* path, const char* etag, const char* json_str) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    rtdb_cache_entry_t* entry = RTDB::findCacheEntry(path);
+    if (etag == NULL && entry) {
+        etag = entry->etag;
+    }
+
+    cJSON* merged_json = NULL;
+    if (etag && entry && strcmp(entry->etag, etag) == 0) {
+        merged_json = cJSON_Parse(entry->body);
+    }
+
+    if (cJSON_IsObject(merged_json)) {
+        cJSON* patch_json = cJSON_Parse(json_str);
+        if (patch_json == NULL) {
+            ESP_LOGE(RTDB_TAG, "Invalid patch for path %s", path);
+            cJSON_Delete(merged_json);
+            return ESP_FAIL;
+        }
+
+        // Apply the patch to the cached document
+        cJSON* field = NULL;
+        cJSON_ArrayForEach(field, patch_json) {
+            cJSON* value = cJSON_Duplicate(field, true);
+            if (cJSON_HasObjectItem(merged_json, field->string)) {
+                cJSON_ReplaceItemInObjectCaseSensitive(merged_json, field->string, value);
+            } else {
+                cJSON_AddItemToObject(merged_json, field->string, value);
+            }
+        }
+        cJSON_Delete(patch_json);
+
+        char* merged_str = cJSON_PrintUnformatted(merged_json);
+        cJSON_Delete(merged_json);
+
+        RTDB::ensureAuthToken();
+        const char* url = RTDB::buildUrl(path);
+        if (url == NULL || merged_str == NULL) {
+            cJSON_free(merged_str);
+            return ESP_FAIL;
+        }
+
+        this->app->setHeader("if-match", etag);
+        http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_PUT, merged_str);
+        this->app->deleteHeader("if-match");
+
+        if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
+            // The response carries the ETag of what we just wrote
+            RTDB::storeCacheEntry(path, this->app->response_etag, merged_str);
+            cJSON_free(merged_str);
+            this->app->clearHTTPBuffer();
+            ESP_LOGI(RTDB_TAG, "Conditional PUT successful");
+            return ESP_OK;
+        }
+        cJSON_free(merged_str);
+        this->app->clearHTTPBuffer();
+
+        // Only a 412 says the write can be retried field by field; after a timeout or a
+        // server error the PUT may or may not have been applied, so nothing more is sent
+        if (http_ret.err != ESP_OK || http_ret.status_code != 412) {
+            ESP_LOGE(RTDB_TAG, "Conditional PUT failed at path %s| esp_err_t=%d | status_code=%d", path, (int)http_ret.err, http_ret.status_code);
+            return ESP_FAIL;
+        }
+
+        // The field-level patch below drops the cached entry, so the 412 body is not cached
+        ESP_LOGW(RTDB_TAG, "ETag mismatch at path %s, falling back to field-level patch", path);
+    } else {
+        cJSON_Delete(merged_json);
+    }
+
+    return RTDB::patchData(path, json_str);
+}
+
+/**
+ * Updates several locations of the database in a single request.
+ *
+ * Sends one PATCH to the database root whose keys are the slash-delimited paths
+ * of every location, so any number of child updates cost one round trip. The
+ * update is atomic: either every location is written or none is.
+ *
+ * @param updates The locations to update and their serialized JSON values.
+ * @param count The number of entries in updates.
+ *
+ * @return ESP_OK if the update was applied, ESP_FAIL otherwise.
+ */
+esp_err_t RTDB::updateMulti(const rtdb_update_t* updates, size_t count) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    if (updates == NULL || count == 0) {
+        return ESP_FAIL;
+    }
+
+    // Size the body up front: {"path":value,...}
+    size_t body_len = 2;
+    for (size_t i = 0; i < count; i++) {
+        const char* key = updates[i].path;
+        while (*key == '/') {
+            key++;
+        }
+        if (*key == '\0' || strpbrk(key, "\"\\") != NULL || updates[i].json_value == NULL) {
+            ESP_LOGE(RTDB_TAG, "Invalid multi-location update entry %d", (int)i);
+            return ESP_FAIL;
+        }
+        body_len += strlen(key) + strlen(updates[i].json_value) + 4;
+    }
+
+    char* body = (char *)malloc(body_len + 1);
+    if (body == NULL) {
+        return ESP_FAIL;
+    }
+
+    char* end = body;
+    *end++ = '{';
+    for (size_t i = 0; i < count; i++) {
+        const char* key = updates[i].path;
+        while (*key == '/') {
+            key++;
+        }
+        end += sprintf(end, "%s\"%s\":%s", i ? "," : "", key, updates[i].json_value);
+    }
+    *end++ = '}';
+    *end = '\0';
+
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "Multi-location update: %s", body);
+
+    esp_err_t err = RTDB::patchData("", body);
+    free(body);
+
+    return err;
+}
+
 /**
  * Deletes data from the Real-Time Database.
  *
@@ -232,11 +508,14 @@ esp_err_t RTDB::patchData(const char* path, cJSON* data_json) {
 esp_err_t RTDB::deleteData(const char* path) {
     if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
 
-    std::string url = RTDB::base_database_url;
-    url += path;
-    url += ".json?auth=" + this->app->auth_token;
-    this->app->setHeader("content-type", "application/json");
-    http_ret_t http_ret = this->app->performRequest(url.c_str(), HTTP_METHOD_DELETE, "");
+    RTDB::ensureAuthToken();
+
+    const char* url = RTDB::buildUrl(path);
+    if (url == NULL) {
+        return ESP_FAIL;
+    }
+    http_ret_t http_ret = this->app->performRequest(url, HTTP_METHOD_DELETE);
+    RTDB::invalidateCache(path);
     this->app->clearHTTPBuffer();
     if (http_ret.err == ESP_OK && http_ret.status_code == 200) {
         ESP_LOGI(RTDB_TAG, "DELETE successful");
@@ -246,3 +525,129 @@ esp_err_t RTDB::deleteData(const char* path) {
         return ESP_FAIL;
     }
 }
+
+/**
+ * Sets how long cached documents are served without asking the server.
+ *
+ * @param ttl_ms Time to live in milliseconds, 0 to revalidate on every read.
+ */
+void RTDB::setCacheTtl(uint32_t ttl_ms) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    cache_ttl_us = ttl_ms * 1000LL;
+}
+
+/**
+ * Reports the read cache counters.
+ *
+ * @param hits Reads served from the cache without a request.
+ * @param not_modified Reads the server confirmed unchanged by ETag.
+ * @param misses Reads that fetched a new version of the document.
+ */
+void RTDB::getCacheStats(uint32_t* hits, uint32_t* not_modified, uint32_t* misses) {
+    *hits = cache_hits;
+    *not_modified = cache_not_modified;
+    *misses = cache_misses;
+}
+
+rtdb_cache_entry_t* RTDB::findCacheEntry(const char* path) {
+    for (int i = 0; i < RTDB_CACHE_SIZE; i++) {
+        if (cache[i].body && strcmp(cache[i].path, path) == 0) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Caches a copy of a document body along with its ETag, evicting the oldest entry if full.
+ *
+ * Only the serialized body is kept: it is several times smaller than the parsed
+ * tree, and callers get a fresh tree of their own anyway.
+ */
+void RTDB::storeCacheEntry(const char* path, const char* etag, const char* body) {
+    if (etag[0] == '\0' || strlen(path) >= RTDB_CACHE_PATH_MAX) {
+        return;
+    }
+
+    rtdb_cache_entry_t* entry = RTDB::findCacheEntry(path);
+    if (entry == NULL) {
+        entry = &cache[0];
+        for (int i = 0; i < RTDB_CACHE_SIZE; i++) {
+            if (cache[i].body == NULL) {
+                entry = &cache[i];
+                break;
+            }
+            if (cache[i].fetched_us < entry->fetched_us) {
+                entry = &cache[i];
+            }
+        }
+    }
+
+    size_t body_len = strlen(body);
+    char* copy = (char *)malloc(body_len + 1);
+    free(entry->body);
+    entry->body = copy;
+    if (copy == NULL) {
+        return;
+    }
+    memcpy(copy, body, body_len + 1);
+    strcpy(entry->path, path);
+    snprintf(entry->etag, ETAG_BUFFER_SIZE, "%s", etag);
+    entry->fetched_us = esp_timer_get_time();
+}
+
+/**
+ * Drops cached documents that overlap a path that was just written.
+ */
+void RTDB::invalidateCache(const char* path) {
+    size_t path_len = strlen(path);
+
+    for (int i = 0; i < RTDB_CACHE_SIZE; i++) {
+        if (cache[i].body == NULL) {
+            continue;
+        }
+        size_t entry_len = strlen(cache[i].path);
+        size_t len = entry_len < path_len ? entry_len : path_len;
+        if (strncmp(cache[i].path, path, len) == 0) {
+            free(cache[i].body);
+            cache[i].body = NULL;
+        }
+    }
+}
+
+/**
+ * Sets the deadline of each call, measured from when it is issued. It bounds
+ * the wait for the shared client as well as every request of the call.
+ *
+ * @param timeout_ms Deadline in milliseconds.
+ */
+void RTDB::setRequestTimeout(uint32_t timeout_ms) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    request_timeout_ms = timeout_ms;
+}
+
+uint32_t RTDB::getRequestTimeout() {
+    return request_timeout_ms;
+}
+
+/**
+ * Enables gzip-compressed responses from this database.
+ *
+ * Worth it for large documents; small ones grow by the gzip framing. Every
+ * database response may then come compressed, auth responses never do. The
+ * compression ratio and inflate time of each one are logged.
+ *
+ * @param enable true to request gzip responses.
+ */
+void RTDB::setCompression(bool enable) {
+    if (DEBUG) ESP_LOGI(RTDB_TAG, "on %s", __func__);
+
+    if (this->app == nullptr) {
+        return;
+    }
+    if (this->app->setAcceptGzip(enable) != ESP_OK) {
+        ESP_LOGE(RTDB_TAG, "Failed to %s gzip responses", enable ? "enable" : "disable");
+    }
+}
@@ -2,16 +2,50 @@
 #define  _ESP_FIREBASE_RTDB_H_
 
 #include "firebase.hpp"
+#include "rtdb_types.h"
 #include "cJSON.h"
 
+#define RTDB_BASE_URL_BUFFER_SIZE 128                           // https://<project>-default-rtdb.<region>.firebasedatabase.app/
+#define RTDB_URL_BUFFER_SIZE (256 + AUTH_QUERY_BUFFER_SIZE)   // Base URL and path plus the auth query
+#define RTDB_CACHE_SIZE 4                                       // Paths whose documents are cached
+#define RTDB_CACHE_PATH_MAX 64
+#define RTDB_CACHE_TTL_MS 0                                     // 0: revalidate with the server on every read
+#define RTDB_REQUEST_TIMEOUT_MS 5000                            // Default deadline of a call, retries included
+
+struct rtdb_cache_entry_t {
+    char path[RTDB_CACHE_PATH_MAX];
+    char etag[ETAG_BUFFER_SIZE];
+    char* body;                                                 // Serialized document, parsed on each read
+    int64_t fetched_us;
+};
+
 class RTDB {
     private:
         FirebaseApp* app;
-        std::string base_database_url;
+        char base_database_url[RTDB_BASE_URL_BUFFER_SIZE];
+        size_t base_database_url_len;
+        char* url_buffer;
+
+        rtdb_cache_entry_t cache[RTDB_CACHE_SIZE] = {};
+        int64_t cache_ttl_us = RTDB_CACHE_TTL_MS * 1000LL;
+        uint32_t cache_hits = 0;
+        uint32_t cache_not_modified = 0;
+        uint32_t cache_misses = 0;
+        uint32_t request_timeout_ms = RTDB_REQUEST_TIMEOUT_MS;
+
+        void ensureAuthToken();
+        void setBaseUrl(const char* database_url);
+        const char* buildUrl(const char* path);
+        rtdb_cache_entry_t* findCacheEntry(const char* path);
+        void storeCacheEntry(const char* path, const char* etag, const char* body);
+        void invalidateCache(const char* path);
 
     public:
         RTDB();
         RTDB(FirebaseApp* app, const char* database_url);
+        ~RTDB();
+        RTDB(const RTDB&) = delete;
+        RTDB& operator=(const RTDB&) = delete;
         void initialize(FirebaseApp* app, const char* database_url);
 
         cJSON* getData(const char* path);
@@ -26,6 +60,17 @@ class RTDB {
         esp_err_t patchData(const char* path, cJSON* data_json);
 
         esp_err_t deleteData(const char* path);
+
+        esp_err_t patchIfMatch(const char* path, const char* etag, const char* json_str);
+        esp_err_t updateMulti(const rtdb_update_t* updates, size_t count);
+
+        void setCacheTtl(uint32_t ttl_ms);
+        void getCacheStats(uint32_t* hits, uint32_t* not_modified, uint32_t* misses);
+
+        void setRequestTimeout(uint32_t timeout_ms);
+        uint32_t getRequestTimeout();
+
+        void setCompression(bool enable);
 };
 
 #endif
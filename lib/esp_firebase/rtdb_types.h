@@ -0,0 +1,12 @@
+#ifndef _ESP_FIREBASE_RTDB_TYPES_H_
+#define  _ESP_FIREBASE_RTDB_TYPES_H_
+
+// Types shared between the RTDB class and its C wrapper
+
+// One location of a multi-location update
+typedef struct {
+    const char* path;           // Slash-delimited path relative to the database root
+    const char* json_value;     // Serialized JSON value, e.g. "true", "42" or "{\"a\":1}"
+} rtdb_update_t;
+
+#endif
@@ -1,10 +1,40 @@
+#include <stdlib.h>
+#include <string.h>
+#include <new>
 #include "rtdb_wrapper.h"
 #include "rtdb.h"
 #include "firebase.hpp"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "lwip/netdb.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 #define DEBUG false
 
+#define TOKEN_REFRESH_TASK_STACK_SIZE   4096
+#define TOKEN_REFRESH_RETRY_MS          30 * 1000
+#define RTDB_WORKER_TASK_STACK_SIZE     8192
+#define RTDB_ASYNC_QUEUE_LENGTH         8
+#define RTDB_ASYNC_PATH_MAX             64
+#define RTDB_HOSTNAME_MAX               96
+#define RTDB_CLIENT_MEMORY_BUDGET       48 * 1024   // Buffers, TLS session and tasks of the client
+
+typedef enum {
+    RTDB_REQUEST_GET,
+    RTDB_REQUEST_PATCH
+} rtdb_request_method_t;
+
+typedef struct {
+    RTDB_t *me;
+    rtdb_request_method_t method;
+    char path[RTDB_ASYNC_PATH_MAX];
+    char *body;                     // Owned by the request, freed by the worker
+    rtdb_callback_t callback;
+    void *arg;
+} rtdb_request_t;
+
 static const char *TAG = "RTDB_Wrapper";
 
 int RTDB_Initialize(RTDB_t* me, const char * api_key, user_account_t account, const char* database_url);
@@ -15,48 +45,247 @@ int RTDB_PostData(RTDB_t* me, const char* path, const char* json_str);
 int RTDB_PatchData(RTDB_t* me, const char* path, const char* json_str);
 int RTDB_PatchDataJson(RTDB_t* me, const char* path, cJSON* data_json);
 int RTDB_DeleteData(RTDB_t* me, const char* path);
+int RTDB_PatchDataIfMatch(RTDB_t* me, const char* path, const char* etag, const char* json_str);
+int RTDB_UpdateMulti(RTDB_t* me, const rtdb_update_t* updates, size_t count);
+int RTDB_GetDataAsync(RTDB_t* me, const char* path, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+int RTDB_PatchDataAsync(RTDB_t* me, const char* path, const char* json_str, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+int RTDB_PatchDataJsonAsync(RTDB_t* me, const char* path, cJSON* data_json, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+void RTDB_SetCacheTtl(RTDB_t* me, uint32_t ttl_ms);
+void RTDB_GetCacheStats(RTDB_t* me, rtdb_cache_stats_t *stats);
+void RTDB_SetRequestTimeout(RTDB_t* me, uint32_t timeout_ms);
+void RTDB_GetRequestStats(RTDB_t* me, rtdb_request_stats_t *stats);
+void RTDB_SetCompression(RTDB_t* me, bool enable);
+static int64_t begin_call(RTDB *obj);
+static void end_call(RTDB *obj, int64_t start_us, int result);
 static user_account_t convert_to_user_account(user_data_t data);
+static int64_t resolve_host(const char* host);
+static void token_refresh_task(void* param);
+static void rtdb_worker_task(void* param);
+static int start_worker();
+static void stop_worker();
+static void flush_requests();
+static int enqueue_request(RTDB_t* me, rtdb_request_method_t method, const char* path, char* body, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
 
 FirebaseApp* globalFirebaseApp = NULL;
-SemaphoreHandle_t rtdbMutex;
-
+SemaphoreHandle_t rtdbMutex = NULL;
+static RTDB_t* globalRTDB = NULL;
+static volatile bool rtdbSuspended = false;
+static TaskHandle_t tokenRefreshTask = NULL;
+static TaskHandle_t rtdbWorkerTask = NULL;
+static volatile bool rtdbWorkerStopping = false;
+static SemaphoreHandle_t rtdbWorkerStopped = NULL;  // Given by the worker as it exits
+static QueueHandle_t requestQueues[RTDB_PRIORITY_MAX];
+static rtdb_request_stats_t requestStats = {};      // Updated while holding rtdbMutex
+
+/**
+ * Returns the database client, creating it on the first call.
+ *
+ * There is a single client for the whole application: it survives Wi-Fi drops
+ * and later calls just resume and return it. Creation is refused if the free
+ * heap is below RTDB_CLIENT_MEMORY_BUDGET or the login fails.
+ *
+ * @return The client, or NULL if it could not be created.
+ */
 RTDB_t* RTDB_Create(const char * api_key, user_data_t account, const char* database_url) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (rtdbMutex == NULL) {
+        rtdbMutex = xSemaphoreCreateMutex();
+    }
+
+    if (globalRTDB != NULL) {
+        RTDB_Resume(globalRTDB);
+        return globalRTDB;
+    }
+
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
     if (globalFirebaseApp == NULL) {
-        globalFirebaseApp = new FirebaseApp(api_key);
-        ESP_ERROR_CHECK(globalFirebaseApp->loginUserAccount(convert_to_user_account(account)));
+        if (free_heap < RTDB_CLIENT_MEMORY_BUDGET) {
+            ESP_LOGE(TAG, "Not enough heap for the database client: %u free, %u needed", (unsigned) free_heap, (unsigned) (RTDB_CLIENT_MEMORY_BUDGET));
+            return NULL;
+        }
+
+        // Built without exceptions: allocation failures are reported as NULL
+        FirebaseApp* app = new (std::nothrow) FirebaseApp(api_key);
+        if (app == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate the Firebase app");
+            return NULL;
+        }
+        if (app->resumeSession(convert_to_user_account(account)) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to log in to Firebase");
+            delete app;
+            return NULL;
+        }
+        globalFirebaseApp = app;
+    }
+
+    if (tokenRefreshTask == NULL) {
+        xTaskCreate(token_refresh_task, "token_refresh_task", TOKEN_REFRESH_TASK_STACK_SIZE, NULL, 3, &tokenRefreshTask);
     }
 
     RTDB_t* me = (RTDB_t*)malloc(sizeof(RTDB_t));
-    if (me) {
-        *((void **) &me->obj)           = (void *) new RTDB(globalFirebaseApp, database_url);
-        *((void **) &me->initialize)    = (void *) RTDB_Initialize;
-        *((void **) &me->getData)       = (void *) RTDB_GetData;
-        *((void **) &me->putData)       = (void *) RTDB_PutData;
-        *((void **) &me->putDataJson)   = (void *) RTDB_PutDataJson;
-        *((void **) &me->postData)      = (void *) RTDB_PostData;
-        *((void **) &me->patchData)     = (void *) RTDB_PatchData;
-        *((void **) &me->patchDataJson) = (void *) RTDB_PatchDataJson;
-        *((void **) &me->deleteData)    = (void *) RTDB_DeleteData;
+    RTDB* obj = me ? new (std::nothrow) RTDB(globalFirebaseApp, database_url) : NULL;
+    if (obj == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate the database client");
+        free(me);
+        return NULL;
     }
 
-    rtdbMutex = xSemaphoreCreateMutex();
+    *((void **) &me->obj)           = (void *) obj;
+    *((void **) &me->initialize)    = (void *) RTDB_Initialize;
+    *((void **) &me->getData)       = (void *) RTDB_GetData;
+    *((void **) &me->putData)       = (void *) RTDB_PutData;
+    *((void **) &me->putDataJson)   = (void *) RTDB_PutDataJson;
+    *((void **) &me->postData)      = (void *) RTDB_PostData;
+    *((void **) &me->patchData)     = (void *) RTDB_PatchData;
+    *((void **) &me->patchDataJson) = (void *) RTDB_PatchDataJson;
+    *((void **) &me->deleteData)    = (void *) RTDB_DeleteData;
+    *((void **) &me->patchDataIfMatch)      = (void *) RTDB_PatchDataIfMatch;
+    *((void **) &me->updateMulti)           = (void *) RTDB_UpdateMulti;
+    *((void **) &me->getDataAsync)          = (void *) RTDB_GetDataAsync;
+    *((void **) &me->patchDataAsync)        = (void *) RTDB_PatchDataAsync;
+    *((void **) &me->patchDataJsonAsync)    = (void *) RTDB_PatchDataJsonAsync;
+    *((void **) &me->setCacheTtl)           = (void *) RTDB_SetCacheTtl;
+    *((void **) &me->getCacheStats)         = (void *) RTDB_GetCacheStats;
+    *((void **) &me->setRequestTimeout)     = (void *) RTDB_SetRequestTimeout;
+    *((void **) &me->getRequestStats)       = (void *) RTDB_GetRequestStats;
+    *((void **) &me->setCompression)        = (void *) RTDB_SetCompression;
+
+    globalRTDB = me;
+    rtdbSuspended = false;
+    ESP_LOGI(TAG, "Database client ready, %d bytes of heap in use", (int) (free_heap - heap_caps_get_free_size(MALLOC_CAP_8BIT)));
 
     return me;
 }
 
+/**
+ * Destroys the database client. The FirebaseApp session and the token refresh
+ * task are kept for the next RTDB_Create.
+ *
+ * The asynchronous worker is stopped first, after the request in flight ends
+ * at its deadline, and the requests still queued complete with
+ * ESP_ERR_INVALID_STATE and no data. The next asynchronous request starts the
+ * worker again. Must not be called from a request callback.
+ */
 void RTDB_Destroy(RTDB_t *me) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
     if (me == NULL) {
         return;
     }
 
-    vSemaphoreDelete(rtdbMutex);
+    stop_worker();
+    flush_requests();
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
     delete static_cast<RTDB *>(me->obj);
-    free(globalFirebaseApp);
+    if (me == globalRTDB) {
+        globalRTDB = NULL;
+    }
+    xSemaphoreGive(rtdbMutex);
+
     free(me);
 }
 
+/**
+ * Suspends the client while the network is down.
+ *
+ * Closes the connection so the TLS session is released, pauses token refreshes
+ * and makes queued asynchronous requests fail immediately instead of timing out.
+ */
+void RTDB_Suspend(RTDB_t *me) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL || rtdbSuspended) {
+        return;
+    }
+
+    rtdbSuspended = true;
+    globalFirebaseApp->suspendRequests();
+
+    // Waits at most for the deadline of the request in flight
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    globalFirebaseApp->closeConnection();
+    xSemaphoreGive(rtdbMutex);
+
+    ESP_LOGI(TAG, "Database client suspended, %u bytes of heap free", (unsigned) heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
+
+/**
+ * Resumes a suspended client and lets the token refresh task catch up.
+ */
+void RTDB_Resume(RTDB_t *me) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL) {
+        return;
+    }
+
+    globalFirebaseApp->resumeRequests();
+    if (!rtdbSuspended) {
+        return;
+    }
+
+    rtdbSuspended = false;
+    xTaskNotifyGive(tokenRefreshTask);
+
+    ESP_LOGI(TAG, "Database client resumed");
+}
+
+/**
+ * Cancels the call in progress without blocking, e.g. from an event handler
+ * when the network goes down. Its remaining requests fail immediately with
+ * ESP_ERR_INVALID_STATE; the request in flight, if any, ends at its deadline.
+ * Calls started afterwards are not affected, so a network that is back before
+ * the caller noticed the drop needs no RTDB_Resume.
+ */
+void RTDB_Cancel(RTDB_t *me) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL || globalFirebaseApp == NULL) {
+        return;
+    }
+
+    globalFirebaseApp->cancelRequests();
+}
+
+/**
+ * Resolves the database, identity and securetoken hosts ahead of their first
+ * connection, e.g. as soon as the station gets an IP address.
+ *
+ * The results land in the lwIP DNS table, which honors the record TTLs, so the
+ * connections that follow skip the lookup. Each host is resolved twice and the
+ * difference is logged as the latency saved per new connection.
+ *
+ * Does not need the client to exist and can be called from any task.
+ *
+ * @param database_url URL of the database, the host is taken from it.
+ */
+void RTDB_PreresolveHosts(const char* database_url) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    char rtdb_host[RTDB_HOSTNAME_MAX] = "";
+    const char* begin = strstr(database_url, "://");
+    begin = begin ? begin + 3 : database_url;
+    size_t len = strcspn(begin, "/:");
+    if (len < RTDB_HOSTNAME_MAX) {
+        memcpy(rtdb_host, begin, len);
+        rtdb_host[len] = '\0';
+    }
+
+    const char* hosts[] = {rtdb_host, FIREBASE_IDENTITY_HOST, FIREBASE_SECURETOKEN_HOST};
+    for (size_t i = 0; i < sizeof(hosts) / sizeof(hosts[0]); i++) {
+        if (hosts[i][0] == '\0') {
+            continue;
+        }
+
+        int64_t cold_us = resolve_host(hosts[i]);
+        if (cold_us < 0) {
+            continue;
+        }
+        int64_t cached_us = resolve_host(hosts[i]);
+
+        ESP_LOGI(TAG, "Resolved %s in %lld us, %lld us from cache: %lld us saved per new connection",
+            hosts[i], cold_us, cached_us, cold_us - cached_us);
+    }
+}
+
 int RTDB_Initialize(RTDB_t* me, const char * api_key, user_account_t account, const char* database_url) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
     RTDB *obj;
@@ -86,12 +315,12 @@ cJSON * RTDB_GetData(RTDB_t* me, const char* path) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
-    if (DEBUG) ESP_LOGI(TAG, "on %s: %d", __func__, __LINE__);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return NULL;
+    }
     data_json = obj->getData(path);
-    if (DEBUG) ESP_LOGI(TAG, "on %s: %d", __func__, __LINE__);
-    xSemaphoreGive(rtdbMutex);
-    if (DEBUG) ESP_LOGI(TAG, "on %s: %d", __func__, __LINE__);
+    end_call(obj, start_us, data_json ? ESP_OK : ESP_FAIL);
 
     if (data_json == NULL) {
         return NULL;
@@ -109,9 +338,12 @@ int RTDB_PutData(RTDB_t* me, const char* path, const char* json_str) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->putData(path, json_str);
-    xSemaphoreGive(rtdbMutex);
+    end_call(obj, start_us, result);
 
     return result;
 }
@@ -125,9 +357,12 @@ int RTDB_PutDataJson(RTDB_t* me, const char* path, cJSON* data_json) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->putData(path, data_json);
-    xSemaphoreGive(rtdbMutex);
+    end_call(obj, start_us, result);
 
     return result;
 }
@@ -141,9 +376,12 @@ int RTDB_PostData(RTDB_t* me, const char* path, const char* json_str) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->postData(path, json_str);
-    xSemaphoreGive(rtdbMutex);
+    end_call(obj, start_us, result);
 
     return result;
 }
@@ -157,9 +395,12 @@ int RTDB_PatchData(RTDB_t* me, const char* path, const char* json_str) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->patchData(path, json_str);
-    xSemaphoreGive(rtdbMutex);
+    end_call(obj, start_us, result);
 
     return result;
 }
@@ -173,9 +414,12 @@ int RTDB_PatchDataJson(RTDB_t* me, const char* path, cJSON* data_json) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->patchData(path, data_json);
-    xSemaphoreGive(rtdbMutex);
+    end_call(obj, start_us, result);
 
     return result;
 }
@@ -189,13 +433,447 @@ int RTDB_DeleteData(RTDB_t* me, const char* path) {
 
     obj = static_cast<RTDB *>(me->obj);
 
-    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
     int result = obj->deleteData(path);
+    end_call(obj, start_us, result);
+
+    return result;
+}
+
+int RTDB_PatchDataIfMatch(RTDB_t* me, const char* path, const char* etag, const char* json_str) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL) {
+        return ESP_FAIL;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    int result = obj->patchIfMatch(path, etag, json_str);
+    end_call(obj, start_us, result);
+
+    return result;
+}
+
+int RTDB_UpdateMulti(RTDB_t* me, const rtdb_update_t* updates, size_t count) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL) {
+        return ESP_FAIL;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    int64_t start_us = begin_call(obj);
+    if (start_us == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    int result = obj->updateMulti(updates, count);
+    end_call(obj, start_us, result);
+
+    return result;
+}
+
+int RTDB_GetDataAsync(RTDB_t* me, const char* path, rtdb_priority_t priority, rtdb_callback_t callback, void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL) {
+        return ESP_FAIL;
+    }
+
+    return enqueue_request(me, RTDB_REQUEST_GET, path, NULL, priority, callback, arg);
+}
+
+int RTDB_PatchDataAsync(RTDB_t* me, const char* path, const char* json_str, rtdb_priority_t priority, rtdb_callback_t callback, void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL || json_str == NULL) {
+        return ESP_FAIL;
+    }
+
+    char *body = strdup(json_str);
+    if (body == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return enqueue_request(me, RTDB_REQUEST_PATCH, path, body, priority, callback, arg);
+}
+
+int RTDB_PatchDataJsonAsync(RTDB_t* me, const char* path, cJSON* data_json, rtdb_priority_t priority, rtdb_callback_t callback, void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL || data_json == NULL) {
+        return ESP_FAIL;
+    }
+
+    char *body = cJSON_PrintUnformatted(data_json);
+    if (body == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    return enqueue_request(me, RTDB_REQUEST_PATCH, path, body, priority, callback, arg);
+}
+
+void RTDB_SetCacheTtl(RTDB_t* me, uint32_t ttl_ms) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL) {
+        return;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    obj->setCacheTtl(ttl_ms);
+    xSemaphoreGive(rtdbMutex);
+}
+
+void RTDB_GetCacheStats(RTDB_t* me, rtdb_cache_stats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL || stats == NULL) {
+        return;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    obj->getCacheStats(&stats->hits, &stats->not_modified, &stats->misses);
+    xSemaphoreGive(rtdbMutex);
+}
+
+void RTDB_SetRequestTimeout(RTDB_t* me, uint32_t timeout_ms) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL) {
+        return;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    obj->setRequestTimeout(timeout_ms);
+    xSemaphoreGive(rtdbMutex);
+}
+
+void RTDB_GetRequestStats(RTDB_t* me, rtdb_request_stats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (me == NULL || stats == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    *stats = requestStats;
+    xSemaphoreGive(rtdbMutex);
+}
+
+void RTDB_SetCompression(RTDB_t* me, bool enable) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    RTDB *obj;
+    if (me == NULL) {
+        return;
+    }
+
+    obj = static_cast<RTDB *>(me->obj);
+
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    obj->setCompression(enable);
+    xSemaphoreGive(rtdbMutex);
+}
+
+/**
+ * Starts a call on the shared client.
+ *
+ * Waits for the client no longer than the call's deadline, then arms that
+ * deadline on the FirebaseApp so every request of the call is bounded by it.
+ *
+ * @return Start time of the call, or 0 if the client stayed busy past the deadline.
+ */
+static int64_t begin_call(RTDB *obj) {
+    int64_t start_us = esp_timer_get_time();
+    uint32_t timeout_ms = obj->getRequestTimeout();
+
+    if (xSemaphoreTake(rtdbMutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        ESP_LOGW(TAG, "Client busy for %lu ms, call abandoned", (unsigned long) timeout_ms);
+        return 0;
+    }
+
+    globalFirebaseApp->beginCall(start_us + timeout_ms * 1000LL);
+    return start_us;
+}
+
+/**
+ * Ends a call started with begin_call, recording its latency against the deadline.
+ */
+static void end_call(RTDB *obj, int64_t start_us, int result) {
+    uint32_t latency_ms = (esp_timer_get_time() - start_us) / 1000;
+    uint32_t timeout_ms = obj->getRequestTimeout();
+
+    globalFirebaseApp->endCall();
+
+    requestStats.calls++;
+    requestStats.last_latency_ms = latency_ms;
+    if (latency_ms > requestStats.max_latency_ms) {
+        requestStats.max_latency_ms = latency_ms;
+    }
+    if (result == ESP_ERR_INVALID_STATE) {
+        requestStats.cancelled++;
+    } else if (result == ESP_ERR_TIMEOUT || latency_ms > timeout_ms) {
+        requestStats.deadline_misses++;
+        ESP_LOGW(TAG, "Call missed its deadline: %lu ms of %lu ms", (unsigned long) latency_ms, (unsigned long) timeout_ms);
+    }
+
+    xSemaphoreGive(rtdbMutex);
+}
+
+/**
+ * Queues a request for the RTDB worker task.
+ *
+ * Takes ownership of body, which is freed if the request cannot be queued.
+ */
+static int enqueue_request(RTDB_t* me, rtdb_request_method_t method, const char* path, char* body, rtdb_priority_t priority, rtdb_callback_t callback, void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (priority >= RTDB_PRIORITY_MAX || strlen(path) >= RTDB_ASYNC_PATH_MAX) {
+        free(body);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (start_worker() != ESP_OK) {
+        free(body);
+        return ESP_ERR_NO_MEM;
+    }
+
+    rtdb_request_t request = {
+        .me = me,
+        .method = method,
+        .path = "",
+        .body = body,
+        .callback = callback,
+        .arg = arg
+    };
+    strcpy(request.path, path);
+
+    if (xQueueSend(requestQueues[priority], &request, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Request queue %d full, dropping request for %s", priority, path);
+        free(body);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xTaskNotifyGive(rtdbWorkerTask);
+    return ESP_OK;
+}
+
+/**
+ * Starts the RTDB worker task and its queues on the first asynchronous request.
+ *
+ * Applications that only make synchronous calls never pay for the worker stack
+ * and queues.
+ *
+ * @return ESP_OK if the worker is running, ESP_ERR_NO_MEM if it could not be started.
+ */
+static int start_worker() {
+    if (rtdbWorkerTask != NULL) {
+        return ESP_OK;
+    }
+
+    int result = ESP_OK;
+    xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+    // Another task may have started it while we were waiting
+    if (rtdbWorkerTask == NULL) {
+        for (int i = 0; i < RTDB_PRIORITY_MAX && result == ESP_OK; i++) {
+            if (requestQueues[i] == NULL) {
+                requestQueues[i] = xQueueCreate(RTDB_ASYNC_QUEUE_LENGTH, sizeof(rtdb_request_t));
+            }
+            if (requestQueues[i] == NULL) {
+                result = ESP_ERR_NO_MEM;
+            }
+        }
+        if (result == ESP_OK && rtdbWorkerStopped == NULL) {
+            rtdbWorkerStopped = xSemaphoreCreateBinary();
+            if (rtdbWorkerStopped == NULL) {
+                result = ESP_ERR_NO_MEM;
+            }
+        }
+        if (result == ESP_OK && xTaskCreate(rtdb_worker_task, "rtdb_worker_task", RTDB_WORKER_TASK_STACK_SIZE, NULL, 3, &rtdbWorkerTask) != pdPASS) {
+            rtdbWorkerTask = NULL;
+            result = ESP_ERR_NO_MEM;
+        }
+        if (result != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start the RTDB worker task");
+        }
+    }
     xSemaphoreGive(rtdbMutex);
 
     return result;
 }
 
+/**
+ * Stops the worker task and waits for it to exit. A request in flight ends at
+ * its deadline; the queued ones are left for flush_requests.
+ *
+ * The worker signals through a semaphore rather than a task notification, which
+ * would clear the notification bits the caller waits on.
+ */
+static void stop_worker() {
+    if (rtdbWorkerTask == NULL) {
+        return;
+    }
+
+    rtdbWorkerStopping = true;
+    xTaskNotifyGive(rtdbWorkerTask);
+    xSemaphoreTake(rtdbWorkerStopped, portMAX_DELAY);
+
+    rtdbWorkerTask = NULL;
+    rtdbWorkerStopping = false;
+}
+
+/**
+ * Completes every queued request with ESP_ERR_INVALID_STATE. Only called once
+ * the worker is stopped.
+ */
+static void flush_requests() {
+    rtdb_request_t request;
+
+    for (int i = 0; i < RTDB_PRIORITY_MAX; i++) {
+        if (requestQueues[i] == NULL) {
+            continue;
+        }
+        while (xQueueReceive(requestQueues[i], &request, 0) == pdTRUE) {
+            free(request.body);
+            if (request.callback) {
+                request.callback(ESP_ERR_INVALID_STATE, NULL, request.arg);
+            }
+        }
+    }
+}
+
+/**
+ * Services queued asynchronous requests one at a time.
+ *
+ * This is the only task that issues asynchronous requests on the shared HTTP
+ * client. Queues are always drained highest priority first, so a pending
+ * command is never stuck behind telemetry.
+ */
+static void rtdb_worker_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    rtdb_request_t request;
+
+    while (!rtdbWorkerStopping) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (!rtdbWorkerStopping) {
+            int priority = 0;
+            while (priority < RTDB_PRIORITY_MAX && xQueueReceive(requestQueues[priority], &request, 0) != pdTRUE) {
+                priority++;
+            }
+            if (priority == RTDB_PRIORITY_MAX) {
+                break;
+            }
+
+            RTDB *obj = static_cast<RTDB *>(request.me->obj);
+            cJSON *data_json = NULL;
+            int result;
+
+            int64_t start_us = begin_call(obj);
+            if (start_us == 0) {
+                result = ESP_ERR_TIMEOUT;
+            } else {
+                if (rtdbSuspended) {
+                    result = ESP_ERR_INVALID_STATE;
+                } else if (request.method == RTDB_REQUEST_GET) {
+                    data_json = obj->getData(request.path);
+                    result = data_json ? ESP_OK : ESP_FAIL;
+                } else {
+                    result = obj->patchData(request.path, request.body);
+                }
+                end_call(obj, start_us, result);
+            }
+
+            free(request.body);
+
+            if (request.callback) {
+                request.callback(result, data_json, request.arg);
+            } else {
+                cJSON_Delete(data_json);
+            }
+        }
+    }
+
+    xSemaphoreGive(rtdbWorkerStopped);
+    vTaskDelete(NULL);
+}
+
+/**
+ * Keeps the shared FirebaseApp ID token fresh.
+ *
+ * Sleeps until the token enters its refresh margin and renews it while holding
+ * the RTDB mutex, so requests issued during the refresh wait for the new token
+ * instead of going out with the stale one.
+ */
+static void token_refresh_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    while (true) {
+        // Nothing to do without network, RTDB_Resume wakes us up
+        if (rtdbSuspended) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        int64_t wait_ms = globalFirebaseApp->getAuthTokenTimeToLive() / 1000 - AUTH_TOKEN_REFRESH_MARGIN_S * 1000;
+
+        if (wait_ms > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+            continue;
+        }
+
+        esp_err_t err = ESP_OK;
+        xSemaphoreTake(rtdbMutex, portMAX_DELAY);
+        // A request may have refreshed the token inline while we were waiting
+        if (globalFirebaseApp->isAuthTokenExpiring()) {
+            globalFirebaseApp->beginCall(esp_timer_get_time() + RTDB_REQUEST_TIMEOUT_MS * 1000LL);
+            err = globalFirebaseApp->refreshAuthToken();
+            globalFirebaseApp->endCall();
+        }
+        xSemaphoreGive(rtdbMutex);
+
+        if (err != ESP_OK) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TOKEN_REFRESH_RETRY_MS));
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * Looks a host up the same way esp-tls does when it connects.
+ *
+ * @return Time taken by the lookup in microseconds, or -1 if it failed.
+ */
+static int64_t resolve_host(const char* host) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *result = NULL;
+
+    int64_t start_us = esp_timer_get_time();
+    int err = getaddrinfo(host, NULL, &hints, &result);
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    if (err != 0 || result == NULL) {
+        ESP_LOGW(TAG, "Failed to resolve %s: %d", host, err);
+        return -1;
+    }
+    freeaddrinfo(result);
+
+    return elapsed_us;
+}
+
 static user_account_t convert_to_user_account(user_data_t data) {
     user_account_t account;
     account.user_email = data.user_email;
@@ -3,6 +3,9 @@
 
 #include "cJSON.h"
 #include "esp_err.h"
+#include "rtdb_types.h"
+#include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +16,35 @@ typedef struct {
     const char* user_password;
 } user_data_t;
 
+// Priority classes for asynchronous requests, serviced highest first
+typedef enum {
+    RTDB_PRIORITY_COMMAND,      // Remote commands that drive actuators
+    RTDB_PRIORITY_STATE,        // Actuator state reported back to the database
+    RTDB_PRIORITY_TELEMETRY,    // Periodic sensor values
+    RTDB_PRIORITY_MAX
+} rtdb_priority_t;
+
+// Completion callback for asynchronous requests. Runs in the RTDB worker task.
+// For GET requests data_json holds the response and is owned by the callback
+// (release it with cJSON_Delete); it is NULL for every other request.
+typedef void (*rtdb_callback_t)(int result, cJSON *data_json, void *arg);
+
+// Read cache counters, see RTDB::getCacheStats
+typedef struct {
+    uint32_t hits;              // Reads served from the cache without a request
+    uint32_t not_modified;      // Reads the server confirmed unchanged by ETag
+    uint32_t misses;            // Reads that fetched a new version of the document
+} rtdb_cache_stats_t;
+
+// Latency of synchronous and queued calls measured against their deadline
+typedef struct {
+    uint32_t calls;
+    uint32_t deadline_misses;   // Calls that timed out or finished past their deadline
+    uint32_t cancelled;         // Calls rejected because the client was cancelled or suspended
+    uint32_t last_latency_ms;
+    uint32_t max_latency_ms;
+} rtdb_request_stats_t;
+
 typedef struct _RTDB_t {
     int (* const initialize)        (struct _RTDB_t *me, const char * api_key, user_data_t account, const char* database_url);
     cJSON * (* const getData)       (struct _RTDB_t *me, const char* path);
@@ -22,12 +54,29 @@ typedef struct _RTDB_t {
     int (* const patchData)         (struct _RTDB_t *me, const char* path, const char* json_str);
     int (* const patchDataJson)     (struct _RTDB_t *me, const char* path, cJSON* data_json);
     int (* const deleteData)        (struct _RTDB_t *me, const char* path, const char* json_str);
+    int (* const patchDataIfMatch)  (struct _RTDB_t *me, const char* path, const char* etag, const char* json_str);
+    int (* const updateMulti)       (struct _RTDB_t *me, const rtdb_update_t* updates, size_t count);
+
+    int (* const getDataAsync)      (struct _RTDB_t *me, const char* path, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+    int (* const patchDataAsync)    (struct _RTDB_t *me, const char* path, const char* json_str, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+    int (* const patchDataJsonAsync)(struct _RTDB_t *me, const char* path, cJSON* data_json, rtdb_priority_t priority, rtdb_callback_t callback, void *arg);
+
+    void (* const setCacheTtl)      (struct _RTDB_t *me, uint32_t ttl_ms);
+    void (* const getCacheStats)    (struct _RTDB_t *me, rtdb_cache_stats_t *stats);
+
+    void (* const setRequestTimeout)(struct _RTDB_t *me, uint32_t timeout_ms);
+    void (* const getRequestStats)  (struct _RTDB_t *me, rtdb_request_stats_t *stats);
+    void (* const setCompression)   (struct _RTDB_t *me, bool enable);
 
     void * const obj;
 } RTDB_t;
 
 RTDB_t* RTDB_Create(const char * api_key, user_data_t account, const char* database_url);
 void RTDB_Destroy(RTDB_t *me);
+void RTDB_Suspend(RTDB_t *me);
+void RTDB_Resume(RTDB_t *me);
+void RTDB_Cancel(RTDB_t *me);
+void RTDB_PreresolveHosts(const char* database_url);
 
 #ifdef __cplusplus
 }
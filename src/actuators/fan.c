@@ -1,6 +1,8 @@
 /**
  * @file fan.c
- * @brief Implementation of a controller for the fan in a composting system.
+ * @brief Implementation of a driver for the fan in a composting system.
+ *
+ * Only switches the fan; when to switch it is decided by the controller.
  */
 
 #include <stdio.h>
@@ -11,8 +13,6 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
-#include "freertos/timers.h"
 #include "esp_log.h"
 
 // Inclusion of custom header files
@@ -23,8 +23,6 @@
 
 #define DEBUG false
 
-#define START_FAN_TIMER_MS 2 * 60 * 1000
-
 // Definition of events related to the fan
 ESP_EVENT_DEFINE_BASE(FAN_EVENT);
 
@@ -34,22 +32,13 @@ static const char *TAG = "AC_Fan";
 // Variable to store the current state of the fan (on/off)
 static bool fanOn;
 
-// Timer handler for the fan
-static TimerHandle_t fanTimer = NULL;
-
 // External reference to composting parameters
 extern ComposterParameters composterParameters;
 
-// Declaration of internal functions
-static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
-static esp_err_t turn_on();
-static esp_err_t turn_off();
-static void timer_callback_function(TimerHandle_t xTimer);
-
 /**
- * @brief Initializes the fan controller.
+ * @brief Initializes the fan driver.
  *
- * Configures the fan GPIO and registers necessary event handlers.
+ * Configures the fan GPIO, with the fan off.
  */
 void Fan_Start() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
@@ -65,43 +54,6 @@ void Fan_Start() {
         .pull_up_en = GPIO_PULLUP_DISABLE,
     };
     gpio_config(&io_conf);
-
-    // Creation of the fan timer
-    fanTimer = xTimerCreate("FanTimer", pdMS_TO_TICKS(START_FAN_TIMER_MS), pdTRUE, NULL, timer_callback_function);
-
-    // Registration of event handlers
-    ESP_ERROR_CHECK(esp_event_handler_register(COMMUNICATOR_EVENT, COMMUNICATOR_EVENT_FAN_MANUAL_ON, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(BUTTON_EVENT, BUTTON_EVENT_FAN_MANUAL_ON, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(PARAMETERS_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-}
-
-/**
- * @brief Event handler for the fan.
- *
- * Handles events related to manual fan control, button presses, and parameter changes.
- * Turns on or off the fan as needed.
- */
-static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
-    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
-
-    if (strcmp(event_base, COMMUNICATOR_EVENT) == 0) {
-        if (event_id == COMMUNICATOR_EVENT_FAN_MANUAL_ON) {
-            ESP_ERROR_CHECK(turn_on());
-            xTimerStart(fanTimer, portMAX_DELAY);
-        }
-    } else if (strcmp(event_base, BUTTON_EVENT) == 0) {
-        if (event_id == BUTTON_EVENT_FAN_MANUAL_ON) {
-            ESP_ERROR_CHECK(turn_on());
-            xTimerStart(fanTimer, portMAX_DELAY);
-        }
-    } else if (strcmp(event_base, PARAMETERS_EVENT) == 0) {
-        if (event_id == PARAMETERS_EVENT_STABLE) {
-            ESP_ERROR_CHECK(turn_off());
-        } else if (event_id == PARAMETERS_EVENT_UNSTABLE) {
-            ESP_ERROR_CHECK(turn_on());
-        }
-    }
 }
 
 /**
@@ -109,7 +61,7 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
  *
  * Updates the fan state, sets the GPIO level, and generates an event.
  */
-esp_err_t turn_on() {
+esp_err_t Fan_TurnOn() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     if (!fanOn) {
@@ -126,7 +78,7 @@ esp_err_t turn_on() {
  *
  * Updates the fan state, sets the GPIO level, and generates an event.
  */
-esp_err_t turn_off() {
+esp_err_t Fan_TurnOff() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     if (fanOn) {
@@ -137,19 +89,3 @@ esp_err_t turn_off() {
     }
     return ESP_OK;
 }
-
-/**
- * @brief Timer callback function for the fan.
- *
- * Turns off the fan if it is on and the composting parameters are stable.
- */
-static void timer_callback_function(TimerHandle_t xTimer) {
-    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-
-    if (fanOn
-        && ComposterParameters_GetHumidityState(&composterParameters)
-        && ComposterParameters_GetTemperatureState(&composterParameters)) {
-        ESP_ERROR_CHECK(turn_off());
-        xTimerStop(fanTimer, portMAX_DELAY);
-    }
-}
@@ -1,6 +1,8 @@
 /**
  * @file mixer.c
- * @brief Implementation of a controller for the compost mixer in a composting system.
+ * @brief Implementation of a driver for the compost mixer in a composting system.
+ *
+ * Only switches the mixer; when to switch it is decided by the controller.
  */
 
 #include <stdio.h>
@@ -11,8 +13,6 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
-#include "freertos/timers.h"
 #include "esp_log.h"
 
 // Inclusion of custom header files
@@ -23,10 +23,6 @@
 
 #define DEBUG false
 
-// Definitions for timer durations
-#define RUTINE_MIXING_TIMER_MS      6 * 60 * 60 * 1000 /* 21600000 ms */
-#define START_MIXER_TIMER_MS        2 * 60 * 1000
-
 // Definition of events related to the mixer
 ESP_EVENT_DEFINE_BASE(MIXER_EVENT);
 
@@ -36,25 +32,13 @@ static const char *TAG = "AC_Mixer";
 // Variable to store the current state of the mixer (on/off)
 static bool mixerOn;
 
-// Timer handles for routine mixing and starting the mixer
-static TimerHandle_t startMixerTimer = NULL;
-static TimerHandle_t rutineMixingTimer = NULL;
-
 // External reference to composting parameters
 extern ComposterParameters composterParameters;
 
-// Declaration of internal functions
-static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
-static esp_err_t turn_on();
-static esp_err_t turn_off();
-static void start_mixer_timer_callback(TimerHandle_t xTimer);
-static void rutine_mixing_timer_callback(TimerHandle_t xTimer);
-
 /**
- * @brief Initializes the mixer controller.
+ * @brief Initializes the mixer driver.
  *
- * Configures the mixer GPIO, creates timers, and registers necessary event handlers
- * for manual control, button presses, parameter changes, and crusher events.
+ * Configures the mixer GPIO, with the mixer off.
  */
 void Mixer_Start() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
@@ -70,53 +54,6 @@ void Mixer_Start() {
         .pull_up_en = GPIO_PULLUP_DISABLE,
     };
     gpio_config(&io_conf);
-
-    // Creation of timers
-    rutineMixingTimer = xTimerCreate("rutineMixingTimer", pdMS_TO_TICKS(RUTINE_MIXING_TIMER_MS), pdTRUE, NULL, rutine_mixing_timer_callback);
-    startMixerTimer = xTimerCreate("startMixerTimer", pdMS_TO_TICKS(START_MIXER_TIMER_MS), pdTRUE, NULL, start_mixer_timer_callback);
-
-    // Registration of event handlers
-    ESP_ERROR_CHECK(esp_event_handler_register(COMMUNICATOR_EVENT, COMMUNICATOR_EVENT_MIXER_MANUAL_ON, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(BUTTON_EVENT, BUTTON_EVENT_MIXER_MANUAL_ON, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(PARAMETERS_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(CRUSHER_EVENT, CRUSHER_EVENT_ON, &event_handler, NULL));
-
-    // Start the routine mixing timer
-    xTimerStart(rutineMixingTimer, portMAX_DELAY);
-}
-
-/**
- * @brief Event handler for the mixer.
- *
- * Handles events related to manual mixer control, button presses, parameter changes,
- * and crusher events. Turns the mixer on or off accordingly.
- */
-static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
-    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
-
-    if (strcmp(event_base, COMMUNICATOR_EVENT) == 0) {
-        if (event_id == COMMUNICATOR_EVENT_MIXER_MANUAL_ON) {
-            ESP_ERROR_CHECK(turn_on());
-            xTimerStart(startMixerTimer, portMAX_DELAY);
-        }
-    } else if (strcmp(event_base, BUTTON_EVENT) == 0) {
-        if (event_id == BUTTON_EVENT_MIXER_MANUAL_ON) {
-            ESP_ERROR_CHECK(turn_on());
-            xTimerStart(startMixerTimer, portMAX_DELAY);
-        }
-    } else if (strcmp(event_base, PARAMETERS_EVENT) == 0) {
-        if (event_id == PARAMETERS_EVENT_STABLE) {
-            ESP_ERROR_CHECK(turn_off());
-        } else if (event_id == PARAMETERS_EVENT_UNSTABLE) {
-            ESP_ERROR_CHECK(turn_on());
-        }
-    } else if (strcmp(event_base, CRUSHER_EVENT) == 0) {
-        if (event_id == CRUSHER_EVENT_ON) {
-            ESP_ERROR_CHECK(turn_on());
-            xTimerStart(startMixerTimer, portMAX_DELAY);
-        }
-    }
 }
 
 /**
@@ -125,7 +62,7 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
  * Checks if the mixer is not already on before turning it on.
  * Generates an event and updates the parameter state accordingly.
  */
-esp_err_t turn_on() {
+esp_err_t Mixer_TurnOn() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     if (!mixerOn) {
@@ -143,7 +80,7 @@ esp_err_t turn_on() {
  * Checks if the mixer is not already off before turning it off.
  * Generates an event and updates the parameter state accordingly.
  */
-esp_err_t turn_off() {
+esp_err_t Mixer_TurnOff() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     if (mixerOn) {
@@ -154,32 +91,3 @@ esp_err_t turn_off() {
     }
     return ESP_OK;
 }
-
-/**
- * @brief Timer callback function for starting the mixer.
- *
- * Checks conditions before starting the mixer.
- * Stops the timer if the mixer is started.
- */
-static void start_mixer_timer_callback(TimerHandle_t xTimer) {
-    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-
-    if (mixerOn
-            && ComposterParameters_GetHumidityState(&composterParameters)
-            && ComposterParameters_GetTemperatureState(&composterParameters)) {
-        ESP_ERROR_CHECK(turn_off());
-        xTimerStop(startMixerTimer, portMAX_DELAY);
-    }
-}
-
-/**
- * @brief Timer callback function for routine mixing.
- *
- * Turns on the mixer at regular intervals for routine mixing.
- */
-static void rutine_mixing_timer_callback(TimerHandle_t xTimer) {
-    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-
-    ESP_ERROR_CHECK(turn_on());
-    xTimerStart(startMixerTimer, portMAX_DELAY);
-}
@@ -16,6 +16,8 @@
 // Inclusion of custom header files
 #include "common/composter_parameters.h"
 #include "common/events.h"
+#include "common/event_log.h"
+#include "sensors/acquisition.h"
 
 #define DEBUG false
 
@@ -37,7 +39,7 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
  * @brief Initializes the composting system parameters.
  *
  * Initializes the structure with default values and creates a mutex for thread safety.
- * Registers event handlers for temperature and humidity events.
+ * Registers the event handler for the sensor readings.
  */
 void ComposterParameters_Init(ComposterParameters *params) {
     if (params == NULL) {
@@ -56,40 +58,35 @@ void ComposterParameters_Init(ComposterParameters *params) {
     params->fan = false;
     params->lock = false;
     params->lid = false;
+    params->full = false;
 
     // Creation of mutex for thread safety
     params->mutex = xSemaphoreCreateMutex();
 
-    // Registration of event handlers for temperature and humidity events
-    ESP_ERROR_CHECK(esp_event_handler_register(TEMPERATURE_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
-    ESP_ERROR_CHECK(esp_event_handler_register(HUMIDITY_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    // Registration of the event handler for the sensor readings
+    ESP_ERROR_CHECK(esp_event_handler_register(ACQUISITION_EVENT, ACQUISITION_EVENT_CYCLE, &event_handler, NULL));
 }
 
 /**
- * @brief Event handler for temperature and humidity events.
+ * @brief Event handler for the sensor readings.
  *
- * Handles events related to temperature and humidity stability changes.
+ * Takes the temperature and humidity stability from each batch of readings.
  * Updates the overall parameter stability and generates events accordingly.
  */
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
-
-    if (strcmp(event_base, TEMPERATURE_EVENT) == 0) {
-        if (event_id == TEMPERATURE_EVENT_STABLE) {
-            if (DEBUG) ESP_LOGI(TAG, "Temperature stable event received");
-            isCurrentTemperatureStable = true;
-        } else if (event_id == TEMPERATURE_EVENT_UNSTABLE) {
-            if (DEBUG) ESP_LOGI(TAG, "Temperature unstable event received");
-            isCurrentTemperatureStable = false;
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
+
+    if (strcmp(event_base, ACQUISITION_EVENT) == 0 && event_id == ACQUISITION_EVENT_CYCLE) {
+        const AcquisitionResults_t *results = (const AcquisitionResults_t *) event_data;
+
+        if (results->readings & ACQUISITION_READING_TEMPERATURE) {
+            if (DEBUG) ESP_LOGI(TAG, "Temperature %s", results->isTemperatureStable ? "stable" : "unstable");
+            isCurrentTemperatureStable = results->isTemperatureStable;
         }
-    } else if (strcmp(event_base, HUMIDITY_EVENT) == 0) {
-        if (event_id == HUMIDITY_EVENT_STABLE) {
-            if (DEBUG) ESP_LOGI(TAG, "Humidity stable event received");
-            isCurrentHumidityStable = true;
-        } else if (event_id == HUMIDITY_EVENT_UNSTABLE) {
-            if (DEBUG) ESP_LOGI(TAG, "Humidity unstable event received");
-            isCurrentHumidityStable = false;
+        if (results->readings & ACQUISITION_READING_HUMIDITY) {
+            if (DEBUG) ESP_LOGI(TAG, "Humidity %s", results->isHumidityStable ? "stable" : "unstable");
+            isCurrentHumidityStable = results->isHumidityStable;
         }
     }
 
@@ -270,6 +267,21 @@ bool ComposterParameters_GetLidState(const ComposterParameters* params) {
     return result;
 }
 
+bool ComposterParameters_GetFullState(const ComposterParameters* params) {
+    bool result = false;
+    
+    if (params == NULL || params->mutex == NULL) {
+        return result;
+    }
+
+    if (xSemaphoreTake(params->mutex, portMAX_DELAY) == pdTRUE) {
+        result = params->full;
+        xSemaphoreGive(params->mutex);
+    }
+
+    return result;
+}
+
 // Function implementations for setting parameters
 
 void ComposterParameters_SetComplete(ComposterParameters* params, double value) {
@@ -392,3 +404,14 @@ void ComposterParameters_SetLidState(ComposterParameters* params, bool value) {
         xSemaphoreGive(params->mutex);
     }
 }
+
+void ComposterParameters_SetFullState(ComposterParameters* params, bool value) {
+    if (params == NULL || params->mutex == NULL) {
+        return;
+    }
+
+    if (xSemaphoreTake(params->mutex, portMAX_DELAY) == pdTRUE) {
+        params->full = value;
+        xSemaphoreGive(params->mutex);
+    }
+}
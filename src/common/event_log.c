@@ -0,0 +1,305 @@
+/**
+ * @file event_log.c
+ * @brief Implementation of the deferred binary logging module.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Inclusion of FreeRTOS and ESP-IDF libraries
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Inclusion of custom header files
+#include "common/event_log.h"
+
+#define DEBUG false
+#define EVENT_LOG_BENCHMARK false       // Event loop latency against inline ESP_LOGI, once at start-up
+
+#define EVENT_LOG_RING_SIZE             64      /* Records, must be a power of two */
+#define EVENT_LOG_MESSAGE_SIZE          128
+#define EVENT_LOG_TASK_STACK_SIZE       3072
+#define EVENT_LOG_TASK_PRIORITY         1
+#define EVENT_LOG_BENCHMARK_ROUNDS      32
+
+// Slot sequences are stored relative to the slot index, so the zeroed ring is ready to use
+#define SLOT_SEQUENCE(record, position)         (atomic_load_explicit(&(record)->sequence, memory_order_acquire) + ((position) & (EVENT_LOG_RING_SIZE - 1)))
+#define SET_SLOT_SEQUENCE(record, position, value) atomic_store_explicit(&(record)->sequence, (value) - ((position) & (EVENT_LOG_RING_SIZE - 1)), memory_order_release)
+
+// One slot of the ring buffer
+typedef struct {
+    atomic_uint sequence;       // Slot state, see EventLog_Write
+    uint16_t id;
+    uint32_t timestamp_ms;
+    const char *tag;
+    uint32_t args[EVENT_LOG_MAX_ARGS];
+} EventLogRecord_t;
+
+// Level and format of each message, indexed by EventLogId_t
+static const struct {
+    esp_log_level_t level;
+    const char *format;
+} messages[EVENT_LOG_ID_MAX] = {
+#define EVENT_LOG_MESSAGE(id, level, format) [id] = {level, format},
+    EVENT_LOG_MESSAGES(EVENT_LOG_MESSAGE)
+#undef EVENT_LOG_MESSAGE
+};
+
+// Tag to identify log messages
+static const char *TAG = "AC_EventLog";
+
+static EventLogRecord_t ring[EVENT_LOG_RING_SIZE];
+static atomic_uint write_position;
+static uint32_t read_position;          // Only used by the drain task
+static atomic_uint written_count;
+static atomic_uint dropped_count;
+static atomic_bool drain_waiting;       // Set by the drain task before it blocks on an empty ring
+static uint32_t printed_count;
+
+static TaskHandle_t drainTask = NULL;
+
+static void event_log_drain_task(void* param);
+static void wake_drain_task();
+static void print_record(const EventLogRecord_t *record);
+#if EVENT_LOG_BENCHMARK
+static void run_benchmark();
+#endif
+
+/**
+ * @brief Starts the deferred log drain task.
+ *
+ * Creates the low-priority task that formats the records. Records written before
+ * the start are kept and printed first.
+ */
+void EventLog_Start() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (drainTask != NULL) {
+        return;
+    }
+
+    xTaskCreate(event_log_drain_task, "event_log_task", EVENT_LOG_TASK_STACK_SIZE, NULL, EVENT_LOG_TASK_PRIORITY, &drainTask);
+}
+
+/**
+ * @brief Records a deferred log message.
+ *
+ * Bounded multi-producer queue: a slot whose sequence equals the write position is
+ * free, one whose sequence is the position plus one holds a record ready to print.
+ * Producers claim a position with a compare-and-swap and publish the slot by bumping
+ * its sequence, so no lock is taken and ISRs may log too. When the ring is full the
+ * record is dropped and counted instead of blocking the caller.
+ */
+void EventLog_Write(const char *tag, EventLogId_t id, uint32_t a0, uint32_t a1) {
+    EventLogRecord_t *record;
+    uint32_t position = atomic_load_explicit(&write_position, memory_order_relaxed);
+
+    while (true) {
+        record = &ring[position & (EVENT_LOG_RING_SIZE - 1)];
+        uint32_t sequence = SLOT_SEQUENCE(record, position);
+        int32_t diff = (int32_t) (sequence - position);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&write_position, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&dropped_count, 1, memory_order_relaxed);
+            return;
+        } else {
+            position = atomic_load_explicit(&write_position, memory_order_relaxed);
+        }
+    }
+
+    record->id = id;
+    record->timestamp_ms = esp_log_timestamp();
+    record->tag = tag;
+    record->args[0] = a0;
+    record->args[1] = a1;
+    SET_SLOT_SEQUENCE(record, position, position + 1);
+    atomic_fetch_add_explicit(&written_count, 1, memory_order_relaxed);
+
+    // Only the write that finds the drain task asleep wakes it; the publish above
+    // must be ordered before the flag is read, see event_log_drain_task
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&drain_waiting, memory_order_relaxed)
+            && atomic_exchange_explicit(&drain_waiting, false, memory_order_relaxed)) {
+        wake_drain_task();
+    }
+}
+
+/**
+ * @brief Wakes the drain task from a task or an ISR.
+ */
+static void wake_drain_task() {
+    if (drainTask == NULL) {
+        return;
+    }
+
+    if (xPortInIsrContext()) {
+        BaseType_t high_task_wakeup = pdFALSE;
+        vTaskNotifyGiveFromISR(drainTask, &high_task_wakeup);
+        portYIELD_FROM_ISR(high_task_wakeup);
+    } else {
+        xTaskNotifyGive(drainTask);
+    }
+}
+
+/**
+ * @brief Gets a snapshot of the deferred log counters.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void EventLog_GetStats(EventLogStats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->written = atomic_load_explicit(&written_count, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&dropped_count, memory_order_relaxed);
+    stats->printed = printed_count;
+}
+
+/**
+ * @brief Formats and prints one record.
+ *
+ * Every argument is a 32-bit word on the ESP32, so the raw words are handed back
+ * to the format in place of the original integers and string pointers. They are
+ * widened to uintptr_t, a no-op there, so 64-bit host builds pass full registers.
+ *
+ * @param record Record to print.
+ */
+static void print_record(const EventLogRecord_t *record) {
+    char message[EVENT_LOG_MESSAGE_SIZE];
+
+    if (record->id >= EVENT_LOG_ID_MAX) {
+        ESP_LOGW(TAG, "Unknown log ID %u", record->id);
+        return;
+    }
+
+    snprintf(message, sizeof(message), messages[record->id].format, (uintptr_t) record->args[0], (uintptr_t) record->args[1]);
+    ESP_LOG_LEVEL(messages[record->id].level, record->tag, "(%lu) %s", record->timestamp_ms, message);
+}
+
+/**
+ * @brief Task that drains the ring buffer.
+ *
+ * Runs at the lowest application priority, so the formatting and UART cost is
+ * paid when nothing else needs the CPU. It blocks while the ring is empty and is
+ * notified by the first record written after that.
+ *
+ * @param param Pointer to additional data (not used).
+ */
+static void event_log_drain_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    uint32_t reported_drops = 0;
+
+#if EVENT_LOG_BENCHMARK
+    run_benchmark();
+#endif
+
+    while (true) {
+        while (true) {
+            EventLogRecord_t *record = &ring[read_position & (EVENT_LOG_RING_SIZE - 1)];
+            uint32_t sequence = SLOT_SEQUENCE(record, read_position);
+
+            if (sequence != read_position + 1) {
+                break;
+            }
+
+            // Copy out and release the slot before the slow formatting
+            EventLogRecord_t copy;
+            copy.id = record->id;
+            copy.timestamp_ms = record->timestamp_ms;
+            copy.tag = record->tag;
+            memcpy(copy.args, record->args, sizeof(copy.args));
+            SET_SLOT_SEQUENCE(record, read_position, read_position + EVENT_LOG_RING_SIZE);
+            read_position++;
+
+            print_record(&copy);
+            printed_count++;
+        }
+
+        uint32_t drops = atomic_load_explicit(&dropped_count, memory_order_relaxed);
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "%lu log records dropped, ring buffer full", drops - reported_drops);
+            reported_drops = drops;
+        }
+
+        // Announce the wait, then look again: a record published before the flag
+        // was visible would not have notified us
+        atomic_store_explicit(&drain_waiting, true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        EventLogRecord_t *next = &ring[read_position & (EVENT_LOG_RING_SIZE - 1)];
+        if (SLOT_SEQUENCE(next, read_position) == read_position + 1) {
+            atomic_store_explicit(&drain_waiting, false, memory_order_relaxed);
+            continue;
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    vTaskDelete(NULL);
+}
+
+#if EVENT_LOG_BENCHMARK
+ESP_EVENT_DEFINE_BASE(EVENT_LOG_BENCHMARK_EVENT);
+
+static SemaphoreHandle_t benchmarkDone = NULL;
+static int64_t benchmark_latency_us;
+
+/**
+ * @brief Benchmark event handler, logs the event like the application handlers do.
+ *
+ * The event ID selects inline (0) or deferred (1) logging; the data carries the
+ * time the event was posted.
+ */
+static void benchmark_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    if (event_id == 0) {
+        ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
+    } else {
+        EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
+    }
+
+    benchmark_latency_us += esp_timer_get_time() - *(int64_t *) event_data;
+    xSemaphoreGive(benchmarkDone);
+}
+
+/**
+ * @brief Measures how long inline and deferred logging hold up the event loop.
+ *
+ * Reports the time from posting an event until its handler has logged it. The
+ * cost of the log call itself is measured on the host, see test/host/bench_event_log.c.
+ */
+static void run_benchmark() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    int64_t latency_us[2];
+
+    benchmarkDone = xSemaphoreCreateBinary();
+    esp_event_handler_register(EVENT_LOG_BENCHMARK_EVENT, ESP_EVENT_ANY_ID, &benchmark_event_handler, NULL);
+
+    for (int32_t mode = 0; mode < 2; mode++) {
+        benchmark_latency_us = 0;
+        for (int i = 0; i < EVENT_LOG_BENCHMARK_ROUNDS; i++) {
+            int64_t posted_us = esp_timer_get_time();
+            esp_event_post(EVENT_LOG_BENCHMARK_EVENT, mode, &posted_us, sizeof(posted_us), portMAX_DELAY);
+            xSemaphoreTake(benchmarkDone, portMAX_DELAY);
+        }
+        latency_us[mode] = benchmark_latency_us;
+    }
+
+    esp_event_handler_unregister(EVENT_LOG_BENCHMARK_EVENT, ESP_EVENT_ANY_ID, &benchmark_event_handler);
+    vSemaphoreDelete(benchmarkDone);
+
+    ESP_LOGI(TAG, "Event loop latency: inline %lld us, deferred %lld us",
+             latency_us[0] / EVENT_LOG_BENCHMARK_ROUNDS, latency_us[1] / EVENT_LOG_BENCHMARK_ROUNDS);
+}
+#endif
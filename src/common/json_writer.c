@@ -0,0 +1,213 @@
+/**
+ * @file json_writer.c
+ * @brief Implementation of a streaming, allocation-free JSON writer.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Inclusion of custom header files
+#include "common/json_writer.h"
+
+// Declaration of internal functions
+static void write_raw(JsonWriter *writer, const char *data, size_t length);
+static void write_char(JsonWriter *writer, char c);
+static void write_string(JsonWriter *writer, const char *value);
+static void write_key(JsonWriter *writer, const char *key);
+
+/**
+ * @brief Initializes a writer that emits into the given buffer.
+ *
+ * The buffer always stays NUL-terminated while there is room for it.
+ */
+void JsonWriter_Init(JsonWriter *writer, char *buffer, size_t size) {
+    if (writer == NULL) {
+        return;
+    }
+
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->length = 0;
+    writer->depth = 0;
+    writer->needsComma = false;
+    writer->overflow = (buffer == NULL || size == 0);
+
+    if (!writer->overflow) {
+        buffer[0] = '\0';
+    }
+}
+
+/**
+ * @brief Opens an object, as a member named key or at the root when key is NULL.
+ */
+void JsonWriter_BeginObject(JsonWriter *writer, const char *key) {
+    write_key(writer, key);
+    write_char(writer, '{');
+    writer->depth++;
+    writer->needsComma = false;
+}
+
+/**
+ * @brief Closes the innermost open object.
+ */
+void JsonWriter_EndObject(JsonWriter *writer) {
+    if (writer->depth == 0) {
+        writer->overflow = true;
+        return;
+    }
+
+    write_char(writer, '}');
+    writer->depth--;
+    writer->needsComma = true;
+}
+
+/**
+ * @brief Adds an integer member without going through floating point formatting.
+ */
+void JsonWriter_AddInt(JsonWriter *writer, const char *key, int32_t value) {
+    char digits[12];
+    int length = snprintf(digits, sizeof(digits), "%ld", (long) value);
+
+    write_key(writer, key);
+    write_raw(writer, digits, length);
+    writer->needsComma = true;
+}
+
+/**
+ * @brief Adds a number member. Non-finite values are written as null, like cJSON does.
+ *
+ * Integral values in int32_t range are printed as integers; the range is checked
+ * first because converting a double outside it is undefined behavior.
+ */
+void JsonWriter_AddNumber(JsonWriter *writer, const char *key, double value) {
+    char digits[26];
+    int length;
+
+    if (isnan(value) || isinf(value)) {
+        length = snprintf(digits, sizeof(digits), "null");
+    } else if (value >= INT32_MIN && value <= INT32_MAX && value == (double)(int32_t) value) {
+        length = snprintf(digits, sizeof(digits), "%ld", (long)(int32_t) value);
+    } else {
+        length = snprintf(digits, sizeof(digits), "%1.15g", value);
+    }
+
+    write_key(writer, key);
+    write_raw(writer, digits, length);
+    writer->needsComma = true;
+}
+
+/**
+ * @brief Adds a boolean member.
+ */
+void JsonWriter_AddBool(JsonWriter *writer, const char *key, bool value) {
+    write_key(writer, key);
+    if (value) {
+        write_raw(writer, "true", 4);
+    } else {
+        write_raw(writer, "false", 5);
+    }
+    writer->needsComma = true;
+}
+
+/**
+ * @brief Adds a string member, escaping it as required by JSON.
+ */
+void JsonWriter_AddString(JsonWriter *writer, const char *key, const char *value) {
+    write_key(writer, key);
+    write_string(writer, value);
+    writer->needsComma = true;
+}
+
+/**
+ * @brief Returns the finished document.
+ *
+ * @param length If not NULL, receives the document length.
+ *
+ * @return The NUL-terminated document, or NULL if it overflowed the buffer or
+ *         an object was left open.
+ */
+const char *JsonWriter_Finish(JsonWriter *writer, size_t *length) {
+    if (writer == NULL || writer->overflow || writer->depth != 0) {
+        return NULL;
+    }
+
+    if (length != NULL) {
+        *length = writer->length;
+    }
+
+    return writer->buffer;
+}
+
+static void write_raw(JsonWriter *writer, const char *data, size_t length) {
+    if (writer->overflow) {
+        return;
+    }
+
+    // Keep one byte for the terminator
+    if (writer->length + length >= writer->size) {
+        writer->overflow = true;
+        return;
+    }
+
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+    writer->buffer[writer->length] = '\0';
+}
+
+static void write_char(JsonWriter *writer, char c) {
+    write_raw(writer, &c, 1);
+}
+
+static void write_string(JsonWriter *writer, const char *value) {
+    static const char hex[] = "0123456789abcdef";
+
+    if (value == NULL) {
+        write_raw(writer, "null", 4);
+        return;
+    }
+
+    write_char(writer, '"');
+
+    // Copy runs of plain characters at once, escape the rest
+    const char *run = value;
+    for (const char *p = value; *p != '\0'; p++) {
+        unsigned char c = (unsigned char) *p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        write_raw(writer, run, p - run);
+        run = p + 1;
+
+        switch (c) {
+            case '"':  write_raw(writer, "\\\"", 2); break;
+            case '\\': write_raw(writer, "\\\\", 2); break;
+            case '\b': write_raw(writer, "\\b", 2); break;
+            case '\f': write_raw(writer, "\\f", 2); break;
+            case '\n': write_raw(writer, "\\n", 2); break;
+            case '\r': write_raw(writer, "\\r", 2); break;
+            case '\t': write_raw(writer, "\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f]};
+                write_raw(writer, escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    write_raw(writer, run, strlen(run));
+
+    write_char(writer, '"');
+}
+
+static void write_key(JsonWriter *writer, const char *key) {
+    if (writer->needsComma) {
+        write_char(writer, ',');
+    }
+
+    if (key != NULL) {
+        write_string(writer, key);
+        write_char(writer, ':');
+    }
+}
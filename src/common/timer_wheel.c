@@ -0,0 +1,497 @@
+/**
+ * @file timer_wheel.c
+ * @brief Implementation of a hierarchical timing wheel.
+ *
+ * The wheel counts FreeRTOS ticks and has TIMER_WHEEL_LEVELS levels of
+ * TIMER_WHEEL_SLOTS slots, each level being one base-64 digit of the tick. A timer
+ * goes into the level of the highest digit in which its expiry differs from the
+ * current tick, in the slot of that digit. Whenever a level wraps around, the next
+ * slot of the level above is cascaded down, so level 0 slots hold the timers of
+ * exactly one tick.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+// Inclusion of FreeRTOS and ESP-IDF libraries
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Inclusion of custom header files
+#include "common/timer_wheel.h"
+
+#define DEBUG false
+
+#define TIMER_WHEEL_TASK_STACK_SIZE     3072
+#define TIMER_WHEEL_TASK_PRIORITY       6
+#define TIMER_WHEEL_LEVELS              4
+#define TIMER_WHEEL_SLOT_BITS           6
+#define TIMER_WHEEL_SLOTS               (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_SLOT_MASK           (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_RANGE_BITS          (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_MAX_TICKS           ((1UL << TIMER_WHEEL_RANGE_BITS) - (1UL << (TIMER_WHEEL_RANGE_BITS - TIMER_WHEEL_SLOT_BITS)) - 1)  /* ~44 h at 100 Hz */
+
+// Tag to identify log messages
+static const char *TAG = "AC_TimerWheel";
+
+static portMUX_TYPE wheelLock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t wheelTask = NULL;
+
+// Wheel state, protected by wheelLock
+static TimerWheelNode_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint64_t occupied[TIMER_WHEEL_LEVELS];   // Bit per non-empty slot
+static TimerWheelNode_t expired;                // Timers due in the current tick
+static uint32_t now;                            // Last tick processed
+static TickType_t wakeTick;                     // Tick the wheel task sleeps until
+static bool sleeping;
+static bool initialized;
+static TimerWheelStats_t stats;
+static uint64_t totalLatenessUs;
+
+static void timer_wheel_task(void* param);
+static void initialize_wheel();
+static void list_remove(TimerWheelNode_t *node);
+static void list_append(TimerWheelNode_t *head, TimerWheelNode_t *node);
+static void insert_timer(WheelTimer_t *timer);
+static bool arm_timer(WheelTimer_t *timer);
+static void cancel_timer(WheelTimer_t *timer);
+static void cascade(int level);
+static uint32_t ticks_to_next_slot();
+static uint32_t ticks_to_slot(int level);
+static void run_expired();
+
+/**
+ * @brief Starts the task that runs the timing wheel.
+ */
+void TimerWheel_Start() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (wheelTask != NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    initialize_wheel();
+    portEXIT_CRITICAL(&wheelLock);
+
+    xTaskCreate(timer_wheel_task, "timer_wheel_task", TIMER_WHEEL_TASK_STACK_SIZE, NULL, TIMER_WHEEL_TASK_PRIORITY, &wheelTask);
+}
+
+/**
+ * @brief Sets up a timer, it is left disarmed.
+ *
+ * @param timer     Timer to set up, must outlive its use.
+ * @param name      Name used in log messages.
+ * @param period_ms Period, or delay for a one-shot timer.
+ * @param periodic  Whether the timer re-arms itself after expiring.
+ * @param callback  Function called in the wheel task when the timer expires.
+ * @param arg       Argument passed to the callback.
+ */
+void TimerWheel_Init(WheelTimer_t *timer, const char *name, uint32_t period_ms, bool periodic,
+                     TimerWheelCallback_t callback, void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (timer == NULL) {
+        return;
+    }
+
+    memset(timer, 0, sizeof(WheelTimer_t));
+    timer->name = name;
+    timer->period = pdMS_TO_TICKS(period_ms);
+    timer->periodic = periodic;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+/**
+ * @brief Arms a timer for its period, restarting it if it is already armed.
+ */
+void TimerWheel_Arm(WheelTimer_t *timer) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (timer == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    bool wake = arm_timer(timer);
+    portEXIT_CRITICAL(&wheelLock);
+
+    if (wake) {
+        xTaskNotifyGive(wheelTask);
+    }
+}
+
+/**
+ * @brief Changes the period of a timer and arms it.
+ */
+void TimerWheel_ChangePeriod(WheelTimer_t *timer, uint32_t period_ms) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (timer == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    timer->period = pdMS_TO_TICKS(period_ms);
+    bool wake = arm_timer(timer);
+    portEXIT_CRITICAL(&wheelLock);
+
+    if (wake) {
+        xTaskNotifyGive(wheelTask);
+    }
+}
+
+/**
+ * @brief Disarms a timer, nothing happens if it is not armed.
+ */
+void TimerWheel_Cancel(WheelTimer_t *timer) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (timer == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    cancel_timer(timer);
+    portEXIT_CRITICAL(&wheelLock);
+}
+
+/**
+ * @brief Tells whether a timer is armed.
+ */
+bool TimerWheel_IsActive(const WheelTimer_t *timer) {
+    return timer != NULL && timer->active;
+}
+
+/**
+ * @brief Gets the time left until a timer expires.
+ *
+ * @return Milliseconds until expiry, 0 if the timer is not armed.
+ */
+uint32_t TimerWheel_GetRemainingMs(const WheelTimer_t *timer) {
+    uint32_t remaining = 0;
+
+    if (timer == NULL) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    if (timer->active) {
+        int32_t ticks = (int32_t) (timer->expiry - xTaskGetTickCount());
+        remaining = ticks > 0 ? pdTICKS_TO_MS(ticks) : 0;
+    }
+    portEXIT_CRITICAL(&wheelLock);
+
+    return remaining;
+}
+
+/**
+ * @brief Gets a snapshot of the wheel counters.
+ *
+ * @param wheelStats Structure that receives the counters.
+ */
+void TimerWheel_GetStats(TimerWheelStats_t *wheelStats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (wheelStats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&wheelLock);
+    memcpy(wheelStats, &stats, sizeof(TimerWheelStats_t));
+    wheelStats->avgLatenessUs = stats.fired ? (uint32_t) (totalLatenessUs / stats.fired) : 0;
+    portEXIT_CRITICAL(&wheelLock);
+}
+
+/**
+ * @brief Task that advances the wheel.
+ *
+ * Sleeps until the next occupied slot of any level comes due, and is woken early
+ * when a timer is armed before that. On waking it jumps straight from one occupied
+ * slot to the next, so the ticks in between cost nothing.
+ *
+ * @param param Pointer to additional data (not used).
+ */
+static void timer_wheel_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    while (true) {
+        TickType_t tick = xTaskGetTickCount();
+
+        // Process the occupied slots up to now, skipping the empty ticks in between
+        while (true) {
+            portENTER_CRITICAL(&wheelLock);
+            int32_t elapsed = (int32_t) (tick - now);
+            if (elapsed <= 0) {
+                portEXIT_CRITICAL(&wheelLock);
+                break;
+            }
+            uint32_t step = ticks_to_next_slot();
+            if (step > (uint32_t) elapsed) {
+                now = tick;
+                portEXIT_CRITICAL(&wheelLock);
+                break;
+            }
+            now += step;
+            if ((now & TIMER_WHEEL_SLOT_MASK) == 0) {
+                cascade(1);
+            }
+
+            // Move the timers due now to the expired list
+            TimerWheelNode_t *head = &slots[0][now & TIMER_WHEEL_SLOT_MASK];
+            while (head->next != head) {
+                TimerWheelNode_t *node = head->next;
+                list_remove(node);
+                list_append(&expired, node);
+            }
+            occupied[0] &= ~(1ULL << (now & TIMER_WHEEL_SLOT_MASK));
+            portEXIT_CRITICAL(&wheelLock);
+
+            run_expired();
+        }
+
+        portENTER_CRITICAL(&wheelLock);
+        uint32_t next = ticks_to_next_slot();
+        TickType_t wait = next != UINT32_MAX ? next : portMAX_DELAY;
+        wakeTick = now + wait;
+        sleeping = true;
+        portEXIT_CRITICAL(&wheelLock);
+
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        portENTER_CRITICAL(&wheelLock);
+        sleeping = false;
+        portEXIT_CRITICAL(&wheelLock);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Runs the callbacks of the expired timers.
+ *
+ * Periodic timers are re-armed from their expiry, so they do not drift. A timer
+ * cancelled or re-armed by an earlier callback leaves the expired list and is not run.
+ */
+static void run_expired() {
+    while (true) {
+        portENTER_CRITICAL(&wheelLock);
+        if (expired.next == &expired) {
+            portEXIT_CRITICAL(&wheelLock);
+            break;
+        }
+
+        WheelTimer_t *timer = (WheelTimer_t *) expired.next;
+        list_remove(&timer->node);
+        timer->active = false;
+        stats.active--;
+
+        int64_t lateness = esp_timer_get_time() - timer->due_us;
+        if (lateness < 0) {
+            lateness = 0;
+        }
+        stats.fired++;
+        totalLatenessUs += lateness;
+        if (lateness > stats.maxLatenessUs) {
+            stats.maxLatenessUs = (uint32_t) lateness;
+        }
+
+        if (timer->periodic && timer->period > 0) {
+            timer->expiry += timer->period;
+            timer->due_us += pdTICKS_TO_MS(timer->period) * 1000LL;
+            if ((int32_t) (timer->expiry - now) <= 0) {
+                timer->expiry = now + 1;
+            }
+            timer->active = true;
+            stats.active++;
+            insert_timer(timer);
+        }
+
+        TimerWheelCallback_t callback = timer->callback;
+        void *arg = timer->arg;
+        portEXIT_CRITICAL(&wheelLock);
+
+        if (callback != NULL) {
+            callback(arg);
+        }
+    }
+}
+
+/**
+ * @brief Initializes the slot lists, once. Called with the lock held.
+ */
+static void initialize_wheel() {
+    if (initialized) {
+        return;
+    }
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            slots[level][slot].next = &slots[level][slot];
+            slots[level][slot].prev = &slots[level][slot];
+        }
+    }
+    expired.next = &expired;
+    expired.prev = &expired;
+    now = xTaskGetTickCount();
+    initialized = true;
+}
+
+static void list_remove(TimerWheelNode_t *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node;
+    node->prev = node;
+}
+
+static void list_append(TimerWheelNode_t *head, TimerWheelNode_t *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+/**
+ * @brief Puts a timer in the slot for its expiry. Called with the lock held.
+ */
+static void insert_timer(WheelTimer_t *timer) {
+    int level = 0;
+
+    if (timer->expiry - now > TIMER_WHEEL_MAX_TICKS) {
+        timer->expiry = now + TIMER_WHEEL_MAX_TICKS;
+    }
+
+    // Digits above the range can only differ by a carry, the top level takes those
+    uint32_t differs = timer->expiry ^ now;
+    while (level < TIMER_WHEEL_LEVELS - 1 && (differs >> ((level + 1) * TIMER_WHEEL_SLOT_BITS)) != 0) {
+        level++;
+    }
+
+    uint32_t slot = (timer->expiry >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    list_append(&slots[level][slot], &timer->node);
+    occupied[level] |= 1ULL << slot;
+}
+
+/**
+ * @brief Arms a timer. Called with the lock held.
+ *
+ * @return Whether the timer expires before the wheel task wakes up, in which case
+ * the caller notifies the task once it has released the lock.
+ */
+static bool arm_timer(WheelTimer_t *timer) {
+    initialize_wheel();
+    cancel_timer(timer);
+
+    // An idle wheel stops counting, skip the ticks it missed
+    TickType_t tick = xTaskGetTickCount();
+    if (stats.active == 0 && (int32_t) (tick - now) > 0) {
+        now = tick;
+    }
+
+    // The wheel may lag behind while its task sleeps, count from the real tick
+    uint32_t period = timer->period > 0 ? timer->period : 1;
+    timer->expiry = tick + period;
+    timer->due_us = esp_timer_get_time() + pdTICKS_TO_MS(period) * 1000LL;
+    timer->active = true;
+    stats.active++;
+    insert_timer(timer);
+
+    if (sleeping && wheelTask != NULL && (int32_t) (timer->expiry - wakeTick) < 0) {
+        sleeping = false;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Takes a timer out of its slot, and marks the slot empty if it was the
+ * last timer there. Called with the lock held.
+ */
+static void cancel_timer(WheelTimer_t *timer) {
+    if (!timer->active) {
+        return;
+    }
+
+    // The only timer of a list sits between two links to the head
+    TimerWheelNode_t *head = timer->node.next;
+    if (head == timer->node.prev && head >= &slots[0][0] && head < &slots[0][0] + TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS) {
+        ptrdiff_t index = head - &slots[0][0];
+        occupied[index / TIMER_WHEEL_SLOTS] &= ~(1ULL << (index % TIMER_WHEEL_SLOTS));
+    }
+
+    list_remove(&timer->node);
+    timer->active = false;
+    stats.active--;
+}
+
+/**
+ * @brief Moves the timers of the current slot of a level down the wheel.
+ *
+ * Cascades the level above first when this level wraps around as well.
+ * Called with the lock held.
+ */
+static void cascade(int level) {
+    if (level >= TIMER_WHEEL_LEVELS) {
+        return;
+    }
+
+    uint32_t slot = (now >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK;
+    if (slot == 0) {
+        cascade(level + 1);
+    }
+
+    TimerWheelNode_t *head = &slots[level][slot];
+    while (head->next != head) {
+        TimerWheelNode_t *node = head->next;
+        list_remove(node);
+        insert_timer((WheelTimer_t *) node);
+    }
+    occupied[level] &= ~(1ULL << slot);
+}
+
+/**
+ * @brief Gets the ticks until the next occupied slot of any level comes due.
+ * Called with the lock held.
+ *
+ * @return Ticks from the current tick, UINT32_MAX if the wheel is empty.
+ */
+static uint32_t ticks_to_next_slot() {
+    uint32_t next = UINT32_MAX;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint32_t ticks = ticks_to_slot(level);
+        if (ticks < next) {
+            next = ticks;
+        }
+    }
+
+    return next;
+}
+
+/**
+ * @brief Gets the ticks until the next occupied slot of a level comes due, that is
+ * the first tick it holds. Level 0 slots are due at their expiry, the slots above at
+ * the tick they are cascaded down. Called with the lock held.
+ *
+ * @return Ticks from the current tick, UINT32_MAX if the level is empty.
+ */
+static uint32_t ticks_to_slot(int level) {
+    if (occupied[level] == 0) {
+        return UINT32_MAX;
+    }
+
+    int shift = level * TIMER_WHEEL_SLOT_BITS;
+    uint32_t index = (now >> shift) & TIMER_WHEEL_SLOT_MASK;
+    uint64_t ahead = index == TIMER_WHEEL_SLOT_MASK ? 0 : occupied[level] >> (index + 1);
+
+    // Slots behind the current one belong to the next turn of the level
+    uint32_t slot;
+    if (ahead != 0) {
+        slot = index + 1 + __builtin_ctzll(ahead);
+    } else {
+        slot = TIMER_WHEEL_SLOTS + __builtin_ctzll(occupied[level]);
+    }
+    uint32_t turn = now >> (shift + TIMER_WHEEL_SLOT_BITS) << (shift + TIMER_WHEEL_SLOT_BITS);
+
+    return turn + (slot << shift) - now;
+}
@@ -9,117 +9,293 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
-#include "freertos/timers.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "nvs.h"
 
 #include "cJSON.h"
 #include "rtdb_wrapper.h"
 
 #include "common/events.h"
 #include "common/composter_parameters.h"
+#include "common/json_writer.h"
+#include "common/event_log.h"
+#include "common/timer_wheel.h"
 #include "config/firebase_config.h"
 #include "communication/communicator.h"
 
 #define DEBUG false
 
 #define RUTINE_COMMUNICATOR_TIMER_MS      6 * 60 * 60 * 1000 /* 21600000 ms */
+#define COMPOSTER_ID_LENGTH               12 /* Hex-encoded 6-byte MAC */
 
 ESP_EVENT_DEFINE_BASE(COMMUNICATOR_EVENT);
 
 static const char *TAG = "AC_Communicator";
-static const char firebase_path[] = "/composters/000002";
-
-static bool wifi_connected = false;
-static bool firebase_active_session = false;
-static bool mixer_current_state;
-static bool crusher_current_state;
-static bool fan_current_state;
+static char composter_id[COMPOSTER_ID_LENGTH + 1];
+static char firebase_path[sizeof(COMPOSTERS_PATH) + COMPOSTER_ID_LENGTH];
+
+#define COMMUNICATOR_TASK_STACK_SIZE      8192
+#define READING_POLL_TIMER_MS             1000
+#define RETRY_TIMER_MS                    30 * 1000
+#define REQUEST_DEADLINE_MS               4000   /* Upper bound on any single Firebase call */
+#define PAYLOAD_BUFFER_SIZE               256
+
+// Remote command queue: <composter>/commands/<push id> = {"seq": n, "target": "..."}
+#define COMMANDS_NODE                     "/commands"
+#define COMMAND_ACK_FIELD                 "/command_ack"
+#define COMMAND_BATCH_MAX                 8    /* Commands consumed per poll */
+#define COMMAND_KEY_MAX                   32   /* Push IDs are 20 characters */
+#define COMMAND_PATH_MAX                  (sizeof(COMPOSTERS_PATH) + COMPOSTER_ID_LENGTH + sizeof(COMMANDS_NODE) + COMMAND_KEY_MAX)
+
+// Notification bits delivered to the communicator task
+#define NOTIFY_CONNECTION_CHANGED         BIT0
+#define NOTIFY_ACTUATOR_CHANGED           BIT1
+#define NOTIFY_POLL                       BIT2
+#define NOTIFY_ROUTINE_UPDATE             BIT3
+#define NOTIFY_RETRY                      BIT4
+#define NOTIFY_BUDGET_REFILLED            BIT5
+#define NOTIFY_GOT_IP                     BIT6
+
+// Token bucket budgets per traffic class: burst size and time to earn one request
+#define COMMAND_BUDGET_BURST              5
+#define COMMAND_BUDGET_REFILL_MS          1000
+#define STATE_BUDGET_BURST                5
+#define STATE_BUDGET_REFILL_MS            2000
+#define TELEMETRY_BUDGET_BURST            2
+#define TELEMETRY_BUDGET_REFILL_MS        60 * 1000
+
+// One entry of the remote command queue
+typedef struct {
+    char key[COMMAND_KEY_MAX];  // Push ID of the entry
+    uint32_t seq;               // Sequence number assigned by the app
+    int32_t event_id;           // Event to post, or -1 if the entry is malformed
+} RemoteCommand_t;
+
+// Command targets and the manual events they trigger
+static const struct {
+    const char *target;
+    int32_t event_id;
+} command_targets[] = {
+    {"mezcladora", COMMUNICATOR_EVENT_MIXER_MANUAL_ON},
+    {"trituradora", COMMUNICATOR_EVENT_CRUSHER_MANUAL_ON},
+    {"fan", COMMUNICATOR_EVENT_FAN_MANUAL_ON},
+};
+
+typedef struct {
+    uint32_t burst;             // Bucket capacity
+    uint32_t refill_ms;         // One token is added every refill_ms
+    uint32_t tokens;
+    int64_t last_refill_us;
+} TokenBucket_t;
+
+// States of the connection to Firebase
+typedef enum {
+    COMMUNICATOR_STATE_DISCONNECTED,    // No Wi-Fi
+    COMMUNICATOR_STATE_AUTHENTICATING,  // Wi-Fi up, logging in to Firebase
+    COMMUNICATOR_STATE_SYNCED,          // Polling and writing normally
+    COMMUNICATOR_STATE_DEGRADED         // Requests failing, waiting to retry
+} CommunicatorState_t;
+
+static const char *state_names[] = {"DISCONNECTED", "AUTHENTICATING", "SYNCED", "DEGRADED"};
+
+static CommunicatorState_t state = COMMUNICATOR_STATE_DISCONNECTED;
+
+// Highest command sequence number executed, persisted in NVS
+static uint32_t last_command_seq;
 
 extern ComposterParameters composterParameters;
 
-static TimerHandle_t communicatorTimer = NULL;
+static TaskHandle_t communicatorTask = NULL;
+static WheelTimer_t communicatorTimer;
+static WheelTimer_t pollTimer;
+static WheelTimer_t retryTimer;
+static WheelTimer_t budgetTimer;
 static EventGroupHandle_t s_communication_event_group;
 
 static RTDB_t * db;
 
-static void timer_callback_function(TimerHandle_t xTimer);
+// Outgoing payloads are only built from the communicator task
+static char payload_buffer[PAYLOAD_BUFFER_SIZE];
+
+// Rate budgets, indexed by CommunicatorTrafficClass_t and only used from the communicator task
+static TokenBucket_t budgets[COMMUNICATOR_TRAFFIC_MAX] = {
+    {COMMAND_BUDGET_BURST, COMMAND_BUDGET_REFILL_MS, COMMAND_BUDGET_BURST, 0},
+    {STATE_BUDGET_BURST, STATE_BUDGET_REFILL_MS, STATE_BUDGET_BURST, 0},
+    {TELEMETRY_BUDGET_BURST, TELEMETRY_BUDGET_REFILL_MS, TELEMETRY_BUDGET_BURST, 0},
+};
+static const uint32_t traffic_notify_bits[COMMUNICATOR_TRAFFIC_MAX] = {NOTIFY_POLL, NOTIFY_ACTUATOR_CHANGED, NOTIFY_ROUTINE_UPDATE};
+static CommunicatorTrafficStats_t traffic_stats;
+
+static void timer_callback_function(void *arg);
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
-static void writing_changes_task(void* param);
-static void reading_changes_task(void* param);
-static void connection_task(void* param);
-static cJSON * get_firebase_composter_data();
-static cJSON * create_firebase_composter();
+static void communicator_task(void* param);
+static void set_state(CommunicatorState_t new_state);
+static bool take_traffic_budget(CommunicatorTrafficClass_t traffic_class);
+static esp_err_t read_remote_commands();
+static esp_err_t write_actuator_changes(EventBits_t uxBits, EventBits_t prevBits);
+static int32_t parse_remote_command(cJSON *command_json, uint32_t *seq);
+static esp_err_t save_command_seq(uint32_t seq);
 static esp_err_t update_sensors_parameters_values();
-static void configure_firebase_connection();
+static esp_err_t configure_firebase_connection();
+static esp_err_t load_composter_id(char *id, size_t id_size);
+static uint32_t load_command_seq();
 
 /**
  * @brief Start the Communicator module.
  *
- * Initialize event handlers, tasks, and timers for communication.
+ * Initialize event handlers, the communicator task, and timers for communication.
  */
 void Communicator_Start() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
+    ESP_ERROR_CHECK(load_composter_id(composter_id, sizeof(composter_id)));
+    snprintf(firebase_path, sizeof(firebase_path), "%s%s", COMPOSTERS_PATH, composter_id);
+    ESP_LOGI(TAG, "Composter path: %s", firebase_path);
+
+    last_command_seq = load_command_seq();
+    ESP_LOGI(TAG, "Last executed command: %lu", last_command_seq);
+
     s_communication_event_group = xEventGroupCreate();
+
+    // Timers only notify the communicator task, which does the actual work
+    TimerWheel_Init(&communicatorTimer, "CommunicatorTimer", RUTINE_COMMUNICATOR_TIMER_MS, true, timer_callback_function, (void *) NOTIFY_ROUTINE_UPDATE);
+    TimerWheel_Init(&pollTimer, "PollTimer", READING_POLL_TIMER_MS, true, timer_callback_function, (void *) NOTIFY_POLL);
+    TimerWheel_Init(&retryTimer, "RetryTimer", RETRY_TIMER_MS, false, timer_callback_function, (void *) NOTIFY_RETRY);
+    TimerWheel_Init(&budgetTimer, "BudgetTimer", COMMAND_BUDGET_REFILL_MS, false, timer_callback_function, (void *) NOTIFY_BUDGET_REFILLED);
+
+    xTaskCreate(communicator_task, "communicator_task", COMMUNICATOR_TASK_STACK_SIZE, NULL, 3, &communicatorTask);
+
     ESP_ERROR_CHECK(esp_event_handler_register(MIXER_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(CRUSHER_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(FAN_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT_INTERNAL, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
+}
 
-    xTaskCreate(connection_task, "connection_task", 8192, NULL, 3, NULL); 
-    xTaskCreate(reading_changes_task, "reading_changes_task", 8192, NULL, 3, NULL);
-    xTaskCreate(writing_changes_task, "writing_changes_task", 8192, NULL, 3, NULL);
+/**
+ * @brief Get a snapshot of the outbound traffic counters.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void Communicator_GetTrafficStats(CommunicatorTrafficStats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (stats == NULL) {
+        return;
+    }
 
-    mixer_current_state = ComposterParameters_GetMixerState(&composterParameters);
-    crusher_current_state = ComposterParameters_GetCrusherState(&composterParameters);
-    fan_current_state = ComposterParameters_GetFanState(&composterParameters);
+    memcpy(stats, &traffic_stats, sizeof(CommunicatorTrafficStats_t));
 }
 
 /**
- * @brief Get the current data of the composter from Firebase.
+ * @brief Load the composter ID from NVS, deriving it from the eFuse MAC on first boot.
+ *
+ * The ID is only derived when none is stored; a stored ID that cannot be read
+ * is reported as an error instead of being overwritten.
+ *
+ * @param id        Buffer that receives the NUL-terminated ID.
+ * @param id_size   Size of the buffer, at least COMPOSTER_ID_LENGTH + 1.
  *
- * @return cJSON object containing the composter data.
+ * @return ESP_OK on success, or error code on failure.
  */
-static cJSON * get_firebase_composter_data() {
+static esp_err_t load_composter_id(char *id, size_t id_size) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    cJSON *data_json = db->getData(db, firebase_path);
-    if (DEBUG) ESP_LOGI(TAG, "%s: %s", __func__, cJSON_PrintUnformatted(data_json));
+    // Open NVS handle
+    nvs_handle_t my_handle;
+    esp_err_t err = nvs_open("composter", NVS_READWRITE, &my_handle);
+
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Use the persisted ID if there is one
+    size_t id_length = id_size;
+    err = nvs_get_str(my_handle, "id", id, &id_length);
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+        // Never replace a provisioned ID that cannot be read (e.g. longer than COMPOSTER_ID_LENGTH)
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot read the provisioned composter ID: %s", esp_err_to_name(err));
+        }
+        nvs_close(my_handle);
+        return err;
+    }
 
-    if (data_json == NULL) {
-        data_json = create_firebase_composter();
+    // Otherwise derive it from the factory-programmed MAC
+    uint8_t mac[6];
+    err = esp_efuse_mac_get_default(mac);
+    if (err != ESP_OK) {
+        nvs_close(my_handle);
+        return err;
     }
+    snprintf(id, id_size, "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    ESP_LOGI(TAG, "Derived composter ID %s from eFuse MAC", id);
 
-    return data_json;
+    // Persist it so the ID survives MAC changes (e.g. custom base MAC)
+    err = nvs_set_str(my_handle, "id", id);
+    if (err == ESP_OK) {
+        err = nvs_commit(my_handle);
+    }
+
+    // Close NVS handle
+    nvs_close(my_handle);
+
+    return err;
+}
+
+/**
+ * @brief Load the sequence number of the last executed remote command from NVS.
+ *
+ * @return The stored sequence number, or 0 if none was stored yet.
+ */
+static uint32_t load_command_seq() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    uint32_t seq = 0;
+    nvs_handle_t my_handle;
+
+    if (nvs_open("composter", NVS_READONLY, &my_handle) == ESP_OK) {
+        nvs_get_u32(my_handle, "cmd_seq", &seq);
+        nvs_close(my_handle);
+    }
+
+    return seq;
 }
 
 /**
- * @brief Create default composter data on Firebase.
+ * @brief Persist the sequence number of the last executed remote command.
  *
- * @return cJSON object representing the default composter data.
+ * @param seq Sequence number to store.
+ *
+ * @return ESP_OK on success, or error code on failure.
  */
-static cJSON * create_firebase_composter() {
+static esp_err_t save_command_seq(uint32_t seq) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    cJSON *data_json = cJSON_CreateObject();
-    cJSON_AddNumberToObject(data_json, "complete", 0);
-    cJSON_AddNumberToObject(data_json, "days", 0);
-    cJSON_AddNumberToObject(data_json, "humidity", 0);
-    cJSON_AddNumberToObject(data_json, "temperature", 0);
-    cJSON_AddBoolToObject(data_json, "mixer", false);
-    cJSON_AddBoolToObject(data_json, "crusher", false);
-    cJSON_AddBoolToObject(data_json, "fan", false);
-
-    if (db->putDataJson(db, firebase_path, data_json)) {
-        return NULL;
+    nvs_handle_t my_handle;
+    esp_err_t err = nvs_open("composter", NVS_READWRITE, &my_handle);
+
+    if (err != ESP_OK) {
+        return err;
     }
 
-    return data_json;
+    err = nvs_set_u32(my_handle, "cmd_seq", seq);
+    if (err == ESP_OK) {
+        err = nvs_commit(my_handle);
+    }
+
+    nvs_close(my_handle);
+
+    return err;
 }
 
 /**
  * @brief Update the values of sensors parameters in Firebase.
  *
+ * Only the sensor fields are patched, so there is no need to read the document first.
+ *
  * @return ESP_OK on success, ESP_FAIL on failure.
  */
 static esp_err_t update_sensors_parameters_values() {
@@ -133,280 +309,482 @@ static esp_err_t update_sensors_parameters_values() {
     if (DEBUG) ESP_LOGI(TAG, "humidity: %f", humidity);
     if (DEBUG) ESP_LOGI(TAG, "complete: %f", complete);
 
-    cJSON *data_json = get_firebase_composter_data();
-
-    cJSON *temperatureField = cJSON_GetObjectItem(data_json, "temperature");
-    cJSON *humidityField = cJSON_GetObjectItem(data_json, "humidity");
-    cJSON *completeField = cJSON_GetObjectItem(data_json, "complete");
+    JsonWriter writer;
+    JsonWriter_Init(&writer, payload_buffer, sizeof(payload_buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddInt(&writer, "temperature", (int) temperature);
+    JsonWriter_AddInt(&writer, "humidity", (int) humidity);
+    JsonWriter_AddInt(&writer, "complete", (int) complete);
+    JsonWriter_EndObject(&writer);
 
-    if (DEBUG) ESP_LOGI(TAG, "temperatureField: %f", cJSON_GetNumberValue(temperatureField));
-    if (DEBUG) ESP_LOGI(TAG, "humidityField: %f", cJSON_GetNumberValue(humidityField));
-    if (DEBUG) ESP_LOGI(TAG, "completeField: %f", cJSON_GetNumberValue(completeField));
-
-    if (cJSON_IsNumber(temperatureField) && cJSON_IsNumber(humidityField) && cJSON_IsNumber(completeField)) {
-        cJSON_SetNumberValue(temperatureField, (int) temperature);
-        cJSON_SetNumberValue(humidityField, (int) humidity);
-        cJSON_SetNumberValue(completeField, (int) complete);
-    } else {
+    const char *payload = JsonWriter_Finish(&writer, NULL);
+    if (payload == NULL) {
         return ESP_FAIL;
     }
 
-    if (DEBUG) ESP_LOGI(TAG, "%s: %s", __func__, cJSON_PrintUnformatted(data_json));
-
-    db->putDataJson(db, firebase_path, data_json);
+    if (DEBUG) ESP_LOGI(TAG, "%s: %s", __func__, payload);
 
-    cJSON_Delete(data_json);
-
-    return ESP_OK;
+    return db->patchData(db, firebase_path, payload);
 }
 
 /**
  * @brief Configure the Firebase connection with user credentials.
+ *
+ * The database client is created once and only resumed on later reconnections,
+ * so Wi-Fi flaps do not allocate a new client each time.
+ *
+ * @return ESP_OK if the client is ready, ESP_FAIL otherwise.
  */
-static void configure_firebase_connection() {
+static esp_err_t configure_firebase_connection() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
+    if (db != NULL) {
+        RTDB_Resume(db);
+        return ESP_OK;
+    }
+
     user_data_t account = {USER_EMAIL, USER_PASSWORD};
     db = RTDB_Create(API_KEY, account, DATABASE_URL);
-    firebase_active_session = true;
+    if (db == NULL) {
+        return ESP_FAIL;
+    }
+
+    db->setRequestTimeout(db, REQUEST_DEADLINE_MS);
+    return ESP_OK;
 }
 
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
 
     if (strcmp(event_base, WIFI_EVENT_INTERNAL) == 0) {
         if (event_id == WIFI_EVENT_CONNECTION_ON) {
             xEventGroupSetBits(s_communication_event_group, CONNECTION_STATE_BIT);
         } else if (event_id == WIFI_EVENT_CONNECTION_OFF) {
             xEventGroupClearBits(s_communication_event_group, CONNECTION_STATE_BIT);
+            // Fail the call in progress now instead of letting it run into its deadline
+            RTDB_Cancel(db);
         }
+        xTaskNotify(communicatorTask, NOTIFY_CONNECTION_CHANGED, eSetBits);
+    } else if (strcmp(event_base, IP_EVENT) == 0) {
+        xTaskNotify(communicatorTask, NOTIFY_GOT_IP, eSetBits);
     } else if (strcmp(event_base, MIXER_EVENT) == 0) {
         if (event_id == MIXER_EVENT_ON) {
             xEventGroupSetBits(s_communication_event_group, MIXER_STATE_BIT);
         } else if (event_id == MIXER_EVENT_OFF) {
             xEventGroupClearBits(s_communication_event_group, MIXER_STATE_BIT);
         }
+        xTaskNotify(communicatorTask, NOTIFY_ACTUATOR_CHANGED, eSetBits);
     } else if (strcmp(event_base, CRUSHER_EVENT) == 0) {
         if (event_id == CRUSHER_EVENT_ON) {
             xEventGroupSetBits(s_communication_event_group, CRUSHER_STATE_BIT);
         } else if (event_id == CRUSHER_EVENT_OFF) {
             xEventGroupClearBits(s_communication_event_group, CRUSHER_STATE_BIT);
         }
+        xTaskNotify(communicatorTask, NOTIFY_ACTUATOR_CHANGED, eSetBits);
     } else if (strcmp(event_base, FAN_EVENT) == 0) {
         if (event_id == FAN_EVENT_ON) {
             xEventGroupSetBits(s_communication_event_group, FAN_STATE_BIT);
         } else if (event_id == FAN_EVENT_OFF) {
             xEventGroupClearBits(s_communication_event_group, FAN_STATE_BIT);
         }
+        xTaskNotify(communicatorTask, NOTIFY_ACTUATOR_CHANGED, eSetBits);
+    }
+}
+
+/**
+ * @brief Timer callback function shared by all communicator timers.
+ *
+ * Forwards the notification bit passed as the timer argument to the communicator
+ * task, keeping network requests out of the timer wheel task.
+ */
+static void timer_callback_function(void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    xTaskNotify(communicatorTask, (uint32_t) (uintptr_t) arg, eSetBits);
+}
+
+/**
+ * @brief Move the communicator to a new state, logging the transition.
+ *
+ * @param new_state State to switch to.
+ */
+static void set_state(CommunicatorState_t new_state) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (new_state != state) {
+        ESP_LOGI(TAG, "State %s -> %s", state_names[state], state_names[new_state]);
+        state = new_state;
     }
 }
 
 /**
- * @brief Timer callback function for periodic communication with Firebase.
+ * @brief Take one request from the budget of a traffic class.
+ *
+ * Refills the token bucket for the time elapsed since the last call. When the
+ * bucket is empty the request is counted as throttled and the budget timer is
+ * armed to wake the communicator task once a token is available; the caller
+ * keeps its notification bit pending, so later triggers coalesce into it.
+ *
+ * @param traffic_class Class of the request about to be sent.
+ *
+ * @return true if the request may go out now, false if it must wait.
  */
-static void timer_callback_function(TimerHandle_t xTimer) {
+static bool take_traffic_budget(CommunicatorTrafficClass_t traffic_class) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    if (wifi_connected && firebase_active_session) {
-        update_sensors_parameters_values();
+    TokenBucket_t *bucket = &budgets[traffic_class];
+    int64_t now = esp_timer_get_time();
+    int64_t refill_us = bucket->refill_ms * 1000LL;
+
+    if (bucket->tokens >= bucket->burst) {
+        bucket->last_refill_us = now;
+    } else {
+        int64_t earned = (now - bucket->last_refill_us) / refill_us;
+        if (bucket->tokens + earned >= bucket->burst) {
+            bucket->tokens = bucket->burst;
+            bucket->last_refill_us = now;
+        } else {
+            bucket->tokens += earned;
+            bucket->last_refill_us += earned * refill_us;
+        }
+    }
+
+    if (bucket->tokens > 0) {
+        bucket->tokens--;
+        traffic_stats.sent[traffic_class]++;
+        return true;
     }
+
+    traffic_stats.throttled[traffic_class]++;
+    if (DEBUG) ESP_LOGW(TAG, "Traffic class %d over budget, deferring", traffic_class);
+
+    // Wake up when the next token is earned, unless an earlier wake-up is already armed
+    uint32_t wait_ms = (uint32_t) ((bucket->last_refill_us + refill_us - now) / 1000) + portTICK_PERIOD_MS;
+    if (!TimerWheel_IsActive(&budgetTimer) || TimerWheel_GetRemainingMs(&budgetTimer) > wait_ms) {
+        TimerWheel_ChangePeriod(&budgetTimer, wait_ms);
+    }
+
+    return false;
 }
 
 /**
- * @brief Task to handle the periodic connection status check.
+ * @brief Task that owns all communication with Firebase.
  *
- * This task monitors the Wi-Fi connection state and initiates or terminates the communication
- * timer accordingly. It also establishes or closes the connection to Firebase based on the Wi-Fi state.
+ * The task blocks on its notification value and only wakes up when Wi-Fi changes,
+ * an actuator changes, or one of the communicator timers fires. Work that cannot be
+ * done right away (e.g. while DEGRADED) is kept pending until the next retry.
  *
  * @param param Pointer to additional data (not used).
  */
-static void connection_task(void* param) {
+static void communicator_task(void* param) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    // Variables to track event bits and previous event bits
-    EventBits_t uxBits;
-    EventBits_t prevBits = xEventGroupGetBits(s_communication_event_group);
+    uint32_t notification;
+    uint32_t pending = 0;
 
-    // Flag to identify the first connection attempt
-    bool first_connection = true;
+    // Actuator bits as last written to Firebase
+    EventBits_t reportedBits = xEventGroupGetBits(s_communication_event_group);
 
     while (true) {
+        xTaskNotifyWait(0, UINT32_MAX, &notification, portMAX_DELAY);
+
+        // A trigger for a request that is still pending is merged into it
+        for (int i = 0; i < COMMUNICATOR_TRAFFIC_MAX; i++) {
+            if (notification & pending & traffic_notify_bits[i]) {
+                traffic_stats.coalesced[i]++;
+            }
+        }
+        pending |= notification & ~NOTIFY_BUDGET_REFILLED;
+
         UBaseType_t stackHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-        if (DEBUG) ESP_LOGD(TAG, "Connection Task Stack High Water Mark: %u bytes", stackHighWaterMark * sizeof(StackType_t));
-
-        // Retrieve the current event bits
-        uxBits = xEventGroupGetBits(s_communication_event_group);
-
-        // Check if there is a change in event bits
-        if (uxBits != prevBits) {
-            // Check Wi-Fi connection state
-            if ((uxBits & CONNECTION_STATE_BIT) != (prevBits & CONNECTION_STATE_BIT)) {
-                ESP_LOGI(TAG, "Wi-Fi connection state has changed");
-
-                // Wi-Fi is connected
-                if (uxBits & CONNECTION_STATE_BIT) {
-                    ESP_LOGI(TAG, "Wi-Fi connection active");
-                    wifi_connected = true;
-
-                    // Create the communicator timer on the first connection
-                    if (first_connection) {
-                        first_connection = false;
-                        communicatorTimer = xTimerCreate("CommunicatorTimer", pdMS_TO_TICKS(RUTINE_COMMUNICATOR_TIMER_MS), pdTRUE, NULL, timer_callback_function);
-                    }
-                    configure_firebase_connection();
-                    xTimerStart(communicatorTimer, portMAX_DELAY);
+        if (DEBUG) ESP_LOGD(TAG, "Communicator Task Stack High Water Mark: %u bytes", stackHighWaterMark * sizeof(StackType_t));
+
+        EventBits_t uxBits = xEventGroupGetBits(s_communication_event_group);
+
+        // Warm the DNS cache before anything connects, then retry right away if stuck
+        if (pending & NOTIFY_GOT_IP) {
+            pending &= ~NOTIFY_GOT_IP;
+            RTDB_PreresolveHosts(DATABASE_URL);
+            if (state == COMMUNICATOR_STATE_DEGRADED) {
+                pending |= NOTIFY_RETRY;
+            }
+        }
+
+        // Follow the Wi-Fi connection state
+        if (pending & NOTIFY_CONNECTION_CHANGED) {
+            pending &= ~NOTIFY_CONNECTION_CHANGED;
+
+            if ((uxBits & CONNECTION_STATE_BIT) && state == COMMUNICATOR_STATE_DISCONNECTED) {
+                ESP_LOGI(TAG, "Wi-Fi connection active");
+                set_state(COMMUNICATOR_STATE_AUTHENTICATING);
+                TimerWheel_Arm(&communicatorTimer);
+
+                if (configure_firebase_connection() == ESP_OK) {
+                    set_state(COMMUNICATOR_STATE_SYNCED);
+                    TimerWheel_Arm(&pollTimer);
+                } else {
+                    set_state(COMMUNICATOR_STATE_DEGRADED);
+                    TimerWheel_Arm(&retryTimer);
                 }
-                // Wi-Fi is disconnected
-                else {
-                    ESP_LOGI(TAG, "Wi-Fi connection inactive");
-                    wifi_connected = false;
-                    firebase_active_session = false;
-                    xTimerStop(communicatorTimer, portMAX_DELAY);
+
+                // Catch up with anything that changed while offline
+                pending |= NOTIFY_POLL | NOTIFY_ACTUATOR_CHANGED;
+            } else if (!(uxBits & CONNECTION_STATE_BIT) && state != COMMUNICATOR_STATE_DISCONNECTED) {
+                ESP_LOGI(TAG, "Wi-Fi connection inactive");
+                TimerWheel_Cancel(&communicatorTimer);
+                TimerWheel_Cancel(&pollTimer);
+                TimerWheel_Cancel(&retryTimer);
+                TimerWheel_Cancel(&budgetTimer);
+                RTDB_Suspend(db);
+                set_state(COMMUNICATOR_STATE_DISCONNECTED);
+            } else if ((uxBits & CONNECTION_STATE_BIT) && state != COMMUNICATOR_STATE_DISCONNECTED) {
+                // Dropped and back while a request was running, the drop was never seen here
+                ESP_LOGI(TAG, "Wi-Fi connection restored");
+                RTDB_Resume(db);
+                if (state == COMMUNICATOR_STATE_DEGRADED) {
+                    pending |= NOTIFY_RETRY;
                 }
             }
+        }
 
-            // Update previous event bits
-            prevBits = uxBits;
+        if (state == COMMUNICATOR_STATE_DISCONNECTED) {
+            pending = 0;
+            continue;
+        }
+
+        // While degraded nothing goes out until the retry timer fires
+        if (state == COMMUNICATOR_STATE_DEGRADED) {
+            if (!(pending & NOTIFY_RETRY)) {
+                continue;
+            }
+            // The client could not be created, e.g. login failed or low heap
+            if (db == NULL && configure_firebase_connection() != ESP_OK) {
+                pending &= ~NOTIFY_RETRY;
+                TimerWheel_Arm(&retryTimer);
+                continue;
+            }
+            pending |= NOTIFY_POLL;
+        }
+        pending &= ~NOTIFY_RETRY;
+
+        esp_err_t err = ESP_OK;
+
+        if (pending & NOTIFY_ACTUATOR_CHANGED) {
+            if ((uxBits & ~CONNECTION_STATE_BIT) == (reportedBits & ~CONNECTION_STATE_BIT)) {
+                pending &= ~NOTIFY_ACTUATOR_CHANGED;
+            } else if (take_traffic_budget(COMMUNICATOR_TRAFFIC_STATE)) {
+                err = write_actuator_changes(uxBits, reportedBits);
+                if (err == ESP_OK) {
+                    reportedBits = uxBits;
+                    pending &= ~NOTIFY_ACTUATOR_CHANGED;
+                }
+            }
+        }
+
+        if (err == ESP_OK && (pending & NOTIFY_POLL) && take_traffic_budget(COMMUNICATOR_TRAFFIC_COMMAND)) {
+            err = read_remote_commands();
+            if (err == ESP_OK) {
+                pending &= ~NOTIFY_POLL;
+            }
+        }
+
+        if (err == ESP_OK && (pending & NOTIFY_ROUTINE_UPDATE) && take_traffic_budget(COMMUNICATOR_TRAFFIC_TELEMETRY)) {
+            err = update_sensors_parameters_values();
+            if (err == ESP_OK) {
+                pending &= ~NOTIFY_ROUTINE_UPDATE;
+            }
+        }
+
+        if (err == ESP_OK && state == COMMUNICATOR_STATE_DEGRADED) {
+            set_state(COMMUNICATOR_STATE_SYNCED);
+            TimerWheel_Arm(&pollTimer);
+        } else if (err != ESP_OK) {
+            if (state == COMMUNICATOR_STATE_SYNCED) {
+                set_state(COMMUNICATOR_STATE_DEGRADED);
+                TimerWheel_Cancel(&pollTimer);
+            }
+            TimerWheel_Arm(&retryTimer);
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
     vTaskDelete(NULL);
 }
 
-
 /**
- * @brief Task to read changes from Firebase and trigger corresponding events.
+ * @brief Parse one entry of the remote command queue.
  *
- * This task continuously monitors changes in the Firebase database related to mixer, crusher, and fan states.
- * When changes are detected, it generates corresponding events to handle manual control actions.
+ * @param command_json  Entry of the commands node.
+ * @param seq           Receives the sequence number of the entry.
  *
- * @param param Pointer to additional data (not used).
+ * @return Event to post for the command, or -1 if the entry is malformed.
  */
-static void reading_changes_task(void* param) {
+static int32_t parse_remote_command(cJSON *command_json, uint32_t *seq) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    while (true) {
-        // Check if Wi-Fi is connected and there is an active Firebase session
-        if (wifi_connected && firebase_active_session) {
-            UBaseType_t stackHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (DEBUG) ESP_LOGD(TAG, "Reading Task Stack High Water Mark: %u bytes", stackHighWaterMark * sizeof(StackType_t));
-
-            // Retrieve the Firebase data
-            cJSON* data_json = get_firebase_composter_data();
-            cJSON* mixerField = cJSON_GetObjectItem(data_json, "mezcladora");
-            cJSON* crusherField = cJSON_GetObjectItem(data_json, "trituradora");
-            cJSON* fanField = cJSON_GetObjectItem(data_json, "fan");
-
-            // Check if the necessary fields exist and are of boolean type
-            if (cJSON_IsBool(mixerField) && cJSON_IsBool(crusherField) && cJSON_IsBool(fanField)) {
-                // Extract the boolean values
-                bool mixer = cJSON_IsTrue(mixerField);
-                bool crusher = cJSON_IsTrue(crusherField);
-                bool fan = cJSON_IsTrue(fanField);
-
-                // Check for changes in the mixer state
-                if (mixer != mixer_current_state) {
-                    // If mixer is turned on, generate a manual mixer start event
-                    if (mixer) {
-                        ESP_LOGI(TAG, "Manual mixer start detected");
-                        esp_event_post(COMMUNICATOR_EVENT, COMMUNICATOR_EVENT_MIXER_MANUAL_ON, NULL, 0, portMAX_DELAY);
-                    }
-                }
+    cJSON *seqField = cJSON_GetObjectItem(command_json, "seq");
+    cJSON *targetField = cJSON_GetObjectItem(command_json, "target");
 
-                // Check for changes in the crusher state
-                if (crusher != crusher_current_state) {
-                    // If crusher is turned on, generate a manual crusher start event
-                    if (crusher) {
-                        ESP_LOGI(TAG, "Manual crusher start detected");
-                        esp_event_post(COMMUNICATOR_EVENT, COMMUNICATOR_EVENT_CRUSHER_MANUAL_ON, NULL, 0, portMAX_DELAY);
-                    }
-                }
+    *seq = 0;
+    if (!cJSON_IsNumber(seqField) || seqField->valuedouble < 1 || !cJSON_IsString(targetField)) {
+        return -1;
+    }
+    *seq = (uint32_t) seqField->valuedouble;
 
-                // Check for changes in the fan state
-                if (fan != fan_current_state) {
-                    // If fan is turned on, generate a manual fan start event
-                    if (fan) {
-                        ESP_LOGI(TAG, "Manual fan start detected");
-                        esp_event_post(COMMUNICATOR_EVENT, COMMUNICATOR_EVENT_FAN_MANUAL_ON, NULL, 0, portMAX_DELAY);
-                    }
-                }
-            }
-            cJSON_Delete(data_json);
+    for (size_t i = 0; i < sizeof(command_targets) / sizeof(command_targets[0]); i++) {
+        if (strcmp(targetField->valuestring, command_targets[i].target) == 0) {
+            return command_targets[i].event_id;
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
-    vTaskDelete(NULL);
+
+    return -1;
 }
 
 /**
- * @brief Task to write changes to Firebase based on local events.
+ * @brief Read the remote command queue from Firebase and run new commands.
  *
- * This task monitors local events related to mixer, crusher, and fan states and updates the corresponding data
- * in the Firebase database when changes are detected. It utilizes patch requests to minimize data transmission.
+ * The app pushes commands under <composter>/commands, each with a sequence number
+ * higher than any it issued before. Commands above the last executed sequence number
+ * run once, in sequence order; the new high-water mark is saved to NVS before their
+ * events are posted, so a reboot never replays them. The consumed entries are then
+ * removed and the high-water mark acknowledged in <composter>/command_ack, both in a
+ * single update. If that update fails, the next poll finds the same entries, skips
+ * them as already executed and retries the removal.
  *
- * @param param Pointer to additional data (not used).
+ * @return ESP_OK on success, ESP_FAIL if the queue could not be read or acknowledged.
  */
-static void writing_changes_task(void* param) {
+static esp_err_t read_remote_commands() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    // Variables to track event bits and previous event bits
-    EventBits_t uxBits;
-    EventBits_t prevBits = xEventGroupGetBits(s_communication_event_group);
+    char commands_path[COMMAND_PATH_MAX];
+    snprintf(commands_path, sizeof(commands_path), "%s%s", firebase_path, COMMANDS_NODE);
 
-    while (true) {
-        // Check if Wi-Fi is connected and there is an active Firebase session
-        if (wifi_connected && firebase_active_session) {
-            UBaseType_t stackHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
-            if (DEBUG) ESP_LOGD(TAG, "Writing Task Stack High Water Mark: %u bytes", stackHighWaterMark * sizeof(StackType_t));
-
-            // Retrieve the current event bits
-            uxBits = xEventGroupGetBits(s_communication_event_group);
-            if (uxBits != prevBits) {
-                // Retrieve the current Firebase data
-                cJSON* data_json = get_firebase_composter_data();
-
-                // Check for changes in the mixer state
-                if ((uxBits & MIXER_STATE_BIT) != (prevBits & MIXER_STATE_BIT)) {
-                    ESP_LOGI(TAG, "Mixer state change detected");
-                    cJSON* mixerField = cJSON_GetObjectItem(data_json, "mezcladora");
-                    if (cJSON_IsBool(mixerField)) {
-                        cJSON_ReplaceItemInObject(data_json, "mezcladora", cJSON_CreateBool(uxBits & MIXER_STATE_BIT ? true : false));
-                    }
-                    // Perform a patch request to update the Firebase data
-                    db->patchDataJson(db, firebase_path, data_json);
-                    mixer_current_state = uxBits & MIXER_STATE_BIT ? true : false;
-                }
+    // An empty queue comes back as a JSON null
+    cJSON *commands_json = db->getData(db, commands_path);
+    if (commands_json == NULL) {
+        return ESP_FAIL;
+    }
 
-                // Check for changes in the crusher state
-                if ((uxBits & CRUSHER_STATE_BIT) != (prevBits & CRUSHER_STATE_BIT)) {
-                    ESP_LOGI(TAG, "Crusher state change detected");
-                    cJSON* crusherField = cJSON_GetObjectItem(data_json, "trituradora");
-                    if (cJSON_IsBool(crusherField)) {
-                        cJSON_ReplaceItemInObject(data_json, "trituradora", cJSON_CreateBool(uxBits & CRUSHER_STATE_BIT ? true : false));
-                    }
-                    // Perform a patch request to update the Firebase data
-                    db->patchDataJson(db, firebase_path, data_json);
-                    crusher_current_state = uxBits & CRUSHER_STATE_BIT ? true : false;
-                }
+    RemoteCommand_t batch[COMMAND_BATCH_MAX];
+    size_t count = 0;
+    cJSON *command_json;
 
-                // Check for changes in the fan state
-                if ((uxBits & FAN_STATE_BIT) != (prevBits & FAN_STATE_BIT)) {
-                    ESP_LOGI(TAG, "Fan state change detected");
-                    cJSON* fanField = cJSON_GetObjectItem(data_json, "fan");
-                    if (cJSON_IsBool(fanField)) {
-                        cJSON_ReplaceItemInObject(data_json, "fan", cJSON_CreateBool(uxBits & FAN_STATE_BIT ? true : false));
-                    }
-                    // Perform a patch request to update the Firebase data
-                    db->patchDataJson(db, firebase_path, data_json);
-                    fan_current_state = uxBits & FAN_STATE_BIT ? true : false;
-                }
+    cJSON_ArrayForEach(command_json, commands_json) {
+        if (count == COMMAND_BATCH_MAX) {
+            break;
+        }
+        if (command_json->string == NULL || strlen(command_json->string) >= COMMAND_KEY_MAX) {
+            ESP_LOGW(TAG, "Ignoring command with invalid key");
+            continue;
+        }
+
+        // Insert in sequence order
+        uint32_t seq;
+        int32_t event_id = parse_remote_command(command_json, &seq);
+        size_t i = count++;
+        while (i > 0 && batch[i - 1].seq > seq) {
+            batch[i] = batch[i - 1];
+            i--;
+        }
+        strcpy(batch[i].key, command_json->string);
+        batch[i].seq = seq;
+        batch[i].event_id = event_id;
+    }
+    cJSON_Delete(commands_json);
+
+    if (count == 0) {
+        return ESP_OK;
+    }
 
-                cJSON_Delete(data_json);
-                prevBits = uxBits;
+    // Decide what runs before doing anything, duplicates and replays are dropped
+    uint32_t executed_seq = last_command_seq;
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i].event_id < 0) {
+            ESP_LOGW(TAG, "Dropping malformed command %s", batch[i].key);
+        } else if (batch[i].seq <= executed_seq) {
+            ESP_LOGI(TAG, "Dropping already executed command %lu", batch[i].seq);
+            batch[i].event_id = -1;
+        } else {
+            executed_seq = batch[i].seq;
+        }
+    }
+
+    if (executed_seq != last_command_seq) {
+        if (save_command_seq(executed_seq) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to persist command sequence, not executing");
+            return ESP_OK;
+        }
+        last_command_seq = executed_seq;
+
+        for (size_t i = 0; i < count; i++) {
+            if (batch[i].event_id >= 0) {
+                ESP_LOGI(TAG, "Executing remote command %lu", batch[i].seq);
+                esp_event_post(COMMUNICATOR_EVENT, batch[i].event_id, NULL, 0, portMAX_DELAY);
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
-    vTaskDelete(NULL);
+
+    // Remove the consumed entries and acknowledge in one atomic update
+    char paths[COMMAND_BATCH_MAX + 1][COMMAND_PATH_MAX];
+    rtdb_update_t updates[COMMAND_BATCH_MAX + 1];
+    char ack_value[11];
+
+    for (size_t i = 0; i < count; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s", commands_path, batch[i].key);
+        updates[i].path = paths[i];
+        updates[i].json_value = "null";
+    }
+    snprintf(paths[count], sizeof(paths[count]), "%s%s", firebase_path, COMMAND_ACK_FIELD);
+    snprintf(ack_value, sizeof(ack_value), "%lu", last_command_seq);
+    updates[count].path = paths[count];
+    updates[count].json_value = ack_value;
+
+    return db->updateMulti(db, updates, count + 1) == ESP_OK ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Write local actuator changes to Firebase.
+ *
+ * Compares the current actuator bits with the ones last written and sends only the
+ * changed fields in a single patch. Remote requests go to the command queue, so
+ * nothing else writes these fields and the patch needs no precondition.
+ *
+ * @param uxBits    Current communicator event bits.
+ * @param prevBits  Event bits as last written to Firebase.
+ *
+ * @return ESP_OK on success, ESP_FAIL if the request failed.
+ */
+static esp_err_t write_actuator_changes(EventBits_t uxBits, EventBits_t prevBits) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    JsonWriter writer;
+    JsonWriter_Init(&writer, payload_buffer, sizeof(payload_buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+
+    // Check for changes in the mixer state
+    if ((uxBits & MIXER_STATE_BIT) != (prevBits & MIXER_STATE_BIT)) {
+        ESP_LOGI(TAG, "Mixer state change detected");
+        JsonWriter_AddBool(&writer, "mezcladora", (uxBits & MIXER_STATE_BIT) != 0);
+    }
+
+    // Check for changes in the crusher state
+    if ((uxBits & CRUSHER_STATE_BIT) != (prevBits & CRUSHER_STATE_BIT)) {
+        ESP_LOGI(TAG, "Crusher state change detected");
+        JsonWriter_AddBool(&writer, "trituradora", (uxBits & CRUSHER_STATE_BIT) != 0);
+    }
+
+    // Check for changes in the fan state
+    if ((uxBits & FAN_STATE_BIT) != (prevBits & FAN_STATE_BIT)) {
+        ESP_LOGI(TAG, "Fan state change detected");
+        JsonWriter_AddBool(&writer, "fan", (uxBits & FAN_STATE_BIT) != 0);
+    }
+
+    JsonWriter_EndObject(&writer);
+
+    const char *payload = JsonWriter_Finish(&writer, NULL);
+    if (payload == NULL) {
+        return ESP_FAIL;
+    }
+
+    // Perform a patch request to update the Firebase data
+    return db->patchData(db, firebase_path, payload);
 }
@@ -18,6 +18,7 @@
 #include "esp_smartconfig.h"
 
 #include "common/events.h"
+#include "common/event_log.h"
 #include "communication/wifi.h"
 
 #define DEBUG false
@@ -84,7 +85,7 @@ void Wifi_Start() {
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %lu", event_base, event_id);
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
 
     // Handle Wi-Fi start event
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
@@ -0,0 +1,46 @@
+/**
+ * @file control_rules.c
+ * @brief Rule table of the composter control policy.
+ *
+ * Rules are evaluated in order. Actions that change facts make the following
+ * rules see the new state in the same pass, e.g. a crusher request first locks
+ * the lid and then starts the crusher.
+ */
+
+#include <stddef.h>
+
+// Inclusion of custom header files
+#include "control/control_rules.h"
+
+const Rule_t controlRules[] = {
+    // Mixer: manual and routine runs, mixing along with the crusher, and following stability
+    {FACT_MIXER_REQUESTED, FACT_MIXER_REQUESTED, FACT_MIXER_ON, CONTROL_ACTION_MIXER_ON, FACT_MIXER_ON, 0},
+    {FACT_ROUTINE_MIX_DUE, FACT_ROUTINE_MIX_DUE, FACT_MIXER_ON, CONTROL_ACTION_MIXER_ON, FACT_MIXER_ON, 0},
+    {FACT_CRUSHER_ON, FACT_CRUSHER_ON, FACT_MIXER_ON, CONTROL_ACTION_MIXER_ON, FACT_MIXER_ON, 0},
+    {FACT_PARAMS_STABLE, 0, FACT_PARAMS_STABLE | FACT_MIXER_ON, CONTROL_ACTION_MIXER_ON, FACT_MIXER_ON, 0},
+    {FACT_PARAMS_STABLE, FACT_PARAMS_STABLE | FACT_MIXER_ON, 0, CONTROL_ACTION_MIXER_OFF, 0, FACT_MIXER_ON},
+    {FACT_MIXER_CHECK_DUE, FACT_MIXER_CHECK_DUE | FACT_MIXER_ON | FACT_PARAMS_STABLE, 0, CONTROL_ACTION_MIXER_OFF, 0, FACT_MIXER_ON},
+
+    // Fan: manual runs and following stability
+    {FACT_FAN_REQUESTED, FACT_FAN_REQUESTED, FACT_FAN_ON, CONTROL_ACTION_FAN_ON, FACT_FAN_ON, 0},
+    {FACT_PARAMS_STABLE, 0, FACT_PARAMS_STABLE | FACT_FAN_ON, CONTROL_ACTION_FAN_ON, FACT_FAN_ON, 0},
+    {FACT_PARAMS_STABLE, FACT_PARAMS_STABLE | FACT_FAN_ON, 0, CONTROL_ACTION_FAN_OFF, 0, FACT_FAN_ON},
+    {FACT_FAN_CHECK_DUE, FACT_FAN_CHECK_DUE | FACT_FAN_ON | FACT_PARAMS_STABLE, 0, CONTROL_ACTION_FAN_OFF, 0, FACT_FAN_ON},
+
+    // Crusher interlock: the crusher only runs with the lid closed and locked
+    {FACT_CRUSHER_REQUESTED, FACT_CRUSHER_REQUESTED, FACT_LID_CLOSED, CONTROL_ACTION_REQUEST_TO_CLOSE_LID, 0, 0},
+    {FACT_CRUSHER_REQUESTED, FACT_CRUSHER_REQUESTED | FACT_LID_CLOSED, FACT_LOCKED, CONTROL_ACTION_LOCK, FACT_LOCKED, 0},
+    {FACT_CRUSHER_REQUESTED, FACT_CRUSHER_REQUESTED | FACT_LOCKED, FACT_CRUSHER_ON, CONTROL_ACTION_CRUSHER_ON, FACT_CRUSHER_ON, 0},
+    {FACT_CRUSHER_TIME_UP, FACT_CRUSHER_TIME_UP | FACT_CRUSHER_ON, 0, CONTROL_ACTION_CRUSHER_OFF, 0, FACT_CRUSHER_ON},
+    {FACT_LID_CLOSED, FACT_CRUSHER_ON, FACT_LID_CLOSED, CONTROL_ACTION_CRUSHER_OFF, 0, FACT_CRUSHER_ON},
+
+    // Lock: opening the lid always unlocks, otherwise stay locked while full
+    {FACT_LID_CLOSED, FACT_LOCKED, FACT_LID_CLOSED, CONTROL_ACTION_UNLOCK, 0, FACT_LOCKED},
+    {FACT_CRUSHER_ON, FACT_LOCKED, FACT_CRUSHER_ON | FACT_FULL, CONTROL_ACTION_UNLOCK, 0, FACT_LOCKED},
+    {FACT_CRUSHER_ON, FACT_LOCKED | FACT_FULL, FACT_CRUSHER_ON, CONTROL_ACTION_REQUEST_TO_EMPTY_COMPOSTER, 0, 0},
+    {FACT_FULL, FACT_FULL, FACT_LID_CLOSED, CONTROL_ACTION_REQUEST_TO_CLOSE_LID, 0, 0},
+    {FACT_FULL, FACT_FULL | FACT_LID_CLOSED, FACT_LOCKED, CONTROL_ACTION_LOCK, FACT_LOCKED, 0},
+    {FACT_FULL, FACT_LOCKED, FACT_FULL | FACT_CRUSHER_ON, CONTROL_ACTION_UNLOCK, 0, FACT_LOCKED},
+};
+
+const size_t controlRulesCount = sizeof(controlRules) / sizeof(controlRules[0]);
@@ -0,0 +1,318 @@
+/**
+ * @file controller.c
+ * @brief Implementation of the controller that runs the actuator control policy.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Inclusion of FreeRTOS and ESP-IDF libraries
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Inclusion of custom header files
+#include "common/composter_parameters.h"
+#include "common/timer_wheel.h"
+#include "common/events.h"
+#include "common/event_log.h"
+#include "control/control_rules.h"
+#include "control/controller.h"
+#include "actuators/crusher.h"
+#include "actuators/fan.h"
+#include "actuators/lock.h"
+#include "actuators/mixer.h"
+
+#define DEBUG false
+
+#define CONTROL_TASK_STACK_SIZE     3072
+#define CONTROL_TASK_PRIORITY       4
+#define CONTROL_QUEUE_LENGTH        16
+
+// Definitions for timer durations
+#define RUTINE_MIXING_TIMER_MS      6 * 60 * 60 * 1000 /* 21600000 ms */
+#define MIXER_CHECK_TIMER_MS        2 * 60 * 1000
+#define FAN_CHECK_TIMER_MS          2 * 60 * 1000
+#define CRUSHER_RUN_TIMER_MS        2 * 60 * 1000
+
+// Fact changes queued for the control task
+typedef struct {
+    RuleFacts_t set;
+    RuleFacts_t clear;
+    int64_t queued_us;
+} ControlInput_t;
+
+// Tag to identify log messages
+static const char *TAG = "AC_Control";
+
+static QueueHandle_t inputQueue = NULL;
+static TaskHandle_t controlTask = NULL;
+
+// Rule engine, only used from the control task
+static RuleEngine engine;
+static ControlStats_t stats;
+
+// Timers that report pulse facts, the fact is passed as the timer argument
+static WheelTimer_t rutineMixingTimer;
+static WheelTimer_t mixerCheckTimer;
+static WheelTimer_t fanCheckTimer;
+static WheelTimer_t crusherTimer;
+
+// External reference to composting parameters
+extern ComposterParameters composterParameters;
+
+// Declaration of internal functions
+static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
+static void timer_callback_function(void *arg);
+static void control_task(void* param);
+static void send_input(RuleFacts_t set, RuleFacts_t clear);
+static bool perform_action(int action, void *context);
+
+/**
+ * @brief Starts the controller.
+ *
+ * Registers the handlers for every event the policy depends on, then seeds the
+ * facts from the current composter parameters. Events that arrive in between are
+ * queued and applied on top of the seed, so no state change is lost. Finally
+ * creates the timers and the evaluation task.
+ */
+void Control_Start() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    inputQueue = xQueueCreate(CONTROL_QUEUE_LENGTH, sizeof(ControlInput_t));
+
+    // Registration of event handlers
+    ESP_ERROR_CHECK(esp_event_handler_register(PARAMETERS_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(CAPACITY_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(LID_EVENT, LID_EVENT_OPENED, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(LID_EVENT, LID_EVENT_CLOSED, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(COMMUNICATOR_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(BUTTON_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+
+    RuleFacts_t facts = 0;
+    if (ComposterParameters_GetHumidityState(&composterParameters) && ComposterParameters_GetTemperatureState(&composterParameters)) {
+        facts |= FACT_PARAMS_STABLE;
+    }
+    if (ComposterParameters_GetLidState(&composterParameters)) {
+        facts |= FACT_LID_CLOSED;
+    }
+    if (ComposterParameters_GetFullState(&composterParameters)) {
+        facts |= FACT_FULL;
+    }
+    RuleEngine_Init(&engine, controlRules, controlRulesCount, CONTROL_PULSE_FACTS, facts, perform_action, NULL);
+
+    // Creation of timers
+    TimerWheel_Init(&rutineMixingTimer, "rutineMixingTimer", RUTINE_MIXING_TIMER_MS, true, timer_callback_function, (void *) FACT_ROUTINE_MIX_DUE);
+    TimerWheel_Init(&mixerCheckTimer, "mixerCheckTimer", MIXER_CHECK_TIMER_MS, true, timer_callback_function, (void *) FACT_MIXER_CHECK_DUE);
+    TimerWheel_Init(&fanCheckTimer, "fanCheckTimer", FAN_CHECK_TIMER_MS, true, timer_callback_function, (void *) FACT_FAN_CHECK_DUE);
+    TimerWheel_Init(&crusherTimer, "crusherTimer", CRUSHER_RUN_TIMER_MS, false, timer_callback_function, (void *) FACT_CRUSHER_TIME_UP);
+
+    xTaskCreate(control_task, "control_task", CONTROL_TASK_STACK_SIZE, NULL, CONTROL_TASK_PRIORITY, &controlTask);
+
+    // Start the routine mixing timer
+    TimerWheel_Arm(&rutineMixingTimer);
+}
+
+/**
+ * @brief Gets a snapshot of the controller counters.
+ *
+ * @param controlStats Structure that receives the counters.
+ */
+void Control_GetStats(ControlStats_t *controlStats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (controlStats == NULL) {
+        return;
+    }
+
+    memcpy(controlStats, &stats, sizeof(ControlStats_t));
+}
+
+/**
+ * @brief Event handler for the controller.
+ *
+ * Only translates events into fact changes; all decisions are taken by the
+ * control task.
+ */
+static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
+
+    if (strcmp(event_base, PARAMETERS_EVENT) == 0) {
+        if (event_id == PARAMETERS_EVENT_STABLE) {
+            send_input(FACT_PARAMS_STABLE, 0);
+        } else if (event_id == PARAMETERS_EVENT_UNSTABLE) {
+            send_input(0, FACT_PARAMS_STABLE);
+        }
+    } else if (strcmp(event_base, CAPACITY_EVENT) == 0) {
+        if (event_id == CAPACITY_EVENT_FULL) {
+            send_input(FACT_FULL, 0);
+        } else if (event_id == CAPACITY_EVENT_NOT_FULL) {
+            send_input(0, FACT_FULL);
+        }
+    } else if (strcmp(event_base, LID_EVENT) == 0) {
+        if (event_id == LID_EVENT_CLOSED) {
+            send_input(FACT_LID_CLOSED, 0);
+        } else if (event_id == LID_EVENT_OPENED) {
+            send_input(0, FACT_LID_CLOSED);
+        }
+    } else if (strcmp(event_base, COMMUNICATOR_EVENT) == 0) {
+        if (event_id == COMMUNICATOR_EVENT_MIXER_MANUAL_ON) {
+            send_input(FACT_MIXER_REQUESTED, 0);
+        } else if (event_id == COMMUNICATOR_EVENT_CRUSHER_MANUAL_ON) {
+            send_input(FACT_CRUSHER_REQUESTED, 0);
+        } else if (event_id == COMMUNICATOR_EVENT_FAN_MANUAL_ON) {
+            send_input(FACT_FAN_REQUESTED, 0);
+        }
+    } else if (strcmp(event_base, BUTTON_EVENT) == 0) {
+        if (event_id == BUTTON_EVENT_MIXER_MANUAL_ON) {
+            send_input(FACT_MIXER_REQUESTED, 0);
+        } else if (event_id == BUTTON_EVENT_CRUSHER_MANUAL_ON) {
+            send_input(FACT_CRUSHER_REQUESTED, 0);
+        } else if (event_id == BUTTON_EVENT_FAN_MANUAL_ON) {
+            send_input(FACT_FAN_REQUESTED, 0);
+        }
+    }
+}
+
+/**
+ * @brief Timer callback function shared by all controller timers.
+ *
+ * Reports the pulse fact passed as the timer argument.
+ */
+static void timer_callback_function(void *arg) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    send_input((RuleFacts_t) (uintptr_t) arg, 0);
+}
+
+/**
+ * @brief Queues a fact change for the control task.
+ *
+ * Never blocks, so it can be called from the event loop and the timer task.
+ *
+ * @param set   Facts to set.
+ * @param clear Facts to clear.
+ */
+static void send_input(RuleFacts_t set, RuleFacts_t clear) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    ControlInput_t input = {set, clear, esp_timer_get_time()};
+
+    if (xQueueSend(inputQueue, &input, 0) != pdTRUE) {
+        stats.dropped++;
+        ESP_LOGW(TAG, "Control queue full, input dropped");
+    }
+}
+
+/**
+ * @brief Task that evaluates the control rules.
+ *
+ * The only place where actuator decisions are taken. Each input is evaluated
+ * incrementally by the rule engine and its latency, from being queued until
+ * its actions are done, is recorded.
+ *
+ * @param param Pointer to additional data (not used).
+ */
+static void control_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    ControlInput_t input;
+    RuleEngineStats_t engineStats;
+
+    while (true) {
+        if (xQueueReceive(inputQueue, &input, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        uint32_t fired = RuleEngine_Update(&engine, input.set, input.clear);
+        uint32_t latency = (uint32_t) (esp_timer_get_time() - input.queued_us);
+
+        RuleEngine_GetStats(&engine, &engineStats);
+        stats.decisions++;
+        stats.lastLatencyUs = latency;
+        if (latency > stats.maxLatencyUs) {
+            stats.maxLatencyUs = latency;
+        }
+        stats.maxEvaluated = engineStats.maxEvaluated;
+
+        if (DEBUG) ESP_LOGI(TAG, "Input +%08lx -%08lx: %lu actions in %lu us", input.set, input.clear, fired, latency);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Performs an action of the control policy.
+ *
+ * Starts or stops the run timer that goes with each actuator. A failed action
+ * leaves the facts unchanged.
+ *
+ * @param action    Action to perform, a ControlAction_t.
+ * @param context   Pointer to additional data (not used).
+ *
+ * @return true if the action was performed.
+ */
+static bool perform_action(int action, void *context) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    esp_err_t err = ESP_OK;
+
+    switch (action) {
+        case CONTROL_ACTION_MIXER_ON:
+            err = Mixer_TurnOn();
+            if (err == ESP_OK) {
+                TimerWheel_Arm(&mixerCheckTimer);
+            }
+            break;
+        case CONTROL_ACTION_MIXER_OFF:
+            err = Mixer_TurnOff();
+            TimerWheel_Cancel(&mixerCheckTimer);
+            break;
+        case CONTROL_ACTION_FAN_ON:
+            err = Fan_TurnOn();
+            if (err == ESP_OK) {
+                TimerWheel_Arm(&fanCheckTimer);
+            }
+            break;
+        case CONTROL_ACTION_FAN_OFF:
+            err = Fan_TurnOff();
+            TimerWheel_Cancel(&fanCheckTimer);
+            break;
+        case CONTROL_ACTION_CRUSHER_ON:
+            err = Crusher_TurnOn();
+            if (err == ESP_OK) {
+                TimerWheel_Arm(&crusherTimer);
+            }
+            break;
+        case CONTROL_ACTION_CRUSHER_OFF:
+            err = Crusher_TurnOff();
+            TimerWheel_Cancel(&crusherTimer);
+            break;
+        case CONTROL_ACTION_LOCK:
+            err = Lock_Engage();
+            break;
+        case CONTROL_ACTION_UNLOCK:
+            err = Lock_Release();
+            break;
+        case CONTROL_ACTION_REQUEST_TO_CLOSE_LID:
+            ESP_LOGI(TAG, "Lid is opened, cannot lock composter");
+            err = esp_event_post(LOCK_EVENT, LOCK_EVENT_REQUEST_TO_CLOSE_LID, NULL, 0, portMAX_DELAY);
+            break;
+        case CONTROL_ACTION_REQUEST_TO_EMPTY_COMPOSTER:
+            ESP_LOGI(TAG, "Composter is full! Cannot unlock composter");
+            err = esp_event_post(LOCK_EVENT, LOCK_EVENT_REQUEST_TO_EMPTY_COMPOSTER, NULL, 0, portMAX_DELAY);
+            break;
+        default:
+            err = ESP_ERR_INVALID_ARG;
+            break;
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Action %d failed: %s", action, esp_err_to_name(err));
+        return false;
+    }
+
+    return true;
+}
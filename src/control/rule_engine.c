@@ -0,0 +1,125 @@
+/**
+ * @file rule_engine.c
+ * @brief Implementation of an incremental, table-driven rule engine.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Inclusion of custom header files
+#include "control/rule_engine.h"
+
+/**
+ * @brief Initializes an engine over a rule table.
+ *
+ * @param engine    Engine to initialize.
+ * @param rules     Rule table, evaluated in order. Must outlive the engine.
+ * @param count     Number of rules in the table.
+ * @param pulses    Facts that are cleared again at the end of every update.
+ * @param facts     Initial facts, no rule is run for them.
+ * @param handler   Function that performs the actions.
+ * @param context   Pointer passed to the handler.
+ */
+void RuleEngine_Init(RuleEngine *engine, const Rule_t *rules, size_t count, RuleFacts_t pulses,
+                     RuleFacts_t facts, RuleActionHandler_t handler, void *context) {
+    if (engine == NULL) {
+        return;
+    }
+
+    memset(engine, 0, sizeof(RuleEngine));
+    engine->rules = rules;
+    engine->count = count;
+    engine->pulses = pulses;
+    engine->facts = facts & ~pulses;
+    engine->handler = handler;
+    engine->context = context;
+}
+
+/**
+ * @brief Changes facts and runs the rules they trigger.
+ *
+ * A rule is evaluated only if one of its inputs changed, and fires if all of its
+ * required facts are set and none of its excluded facts are. The facts changed by
+ * an action are visible to the rules after it right away and trigger another pass
+ * over the table, up to RULE_ENGINE_MAX_PASSES, so one update never evaluates more
+ * than RULE_ENGINE_MAX_PASSES times the number of rules.
+ *
+ * @param engine    Engine to update.
+ * @param set       Facts to set.
+ * @param clear     Facts to clear.
+ *
+ * @return The number of actions performed.
+ */
+uint32_t RuleEngine_Update(RuleEngine *engine, RuleFacts_t set, RuleFacts_t clear) {
+    if (engine == NULL) {
+        return 0;
+    }
+
+    RuleFacts_t previous = engine->facts;
+    engine->facts = (engine->facts | set) & ~clear;
+
+    // Pulses are clear between updates, so setting one is always a change
+    RuleFacts_t changed = previous ^ engine->facts;
+    uint32_t evaluated = 0;
+    uint32_t fired = 0;
+
+    for (int pass = 0; changed != 0 && pass < RULE_ENGINE_MAX_PASSES; pass++) {
+        RuleFacts_t nextChanged = 0;
+
+        for (size_t i = 0; i < engine->count; i++) {
+            const Rule_t *rule = &engine->rules[i];
+
+            if ((rule->inputs & changed) == 0) {
+                continue;
+            }
+            evaluated++;
+
+            if ((engine->facts & rule->required) != rule->required || (engine->facts & rule->excluded) != 0) {
+                continue;
+            }
+
+            if (engine->handler == NULL || engine->handler(rule->action, engine->context)) {
+                RuleFacts_t before = engine->facts;
+                engine->facts = (engine->facts | rule->sets) & ~rule->clears;
+                nextChanged |= before ^ engine->facts;
+                fired++;
+            }
+        }
+
+        changed = nextChanged;
+    }
+
+    engine->facts &= ~engine->pulses;
+
+    engine->stats.updates++;
+    engine->stats.evaluated += evaluated;
+    engine->stats.fired += fired;
+    if (evaluated > engine->stats.maxEvaluated) {
+        engine->stats.maxEvaluated = evaluated;
+    }
+
+    return fired;
+}
+
+/**
+ * @brief Gets the current facts.
+ */
+RuleFacts_t RuleEngine_GetFacts(const RuleEngine *engine) {
+    if (engine == NULL) {
+        return 0;
+    }
+
+    return engine->facts;
+}
+
+/**
+ * @brief Gets a snapshot of the engine counters.
+ */
+void RuleEngine_GetStats(const RuleEngine *engine, RuleEngineStats_t *stats) {
+    if (engine == NULL || stats == NULL) {
+        return;
+    }
+
+    memcpy(stats, &engine->stats, sizeof(RuleEngineStats_t));
+}
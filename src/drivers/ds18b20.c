@@ -63,10 +63,9 @@ esp_err_t ds18b20_get_temperature(onewire_bus_handle_t handle, const uint8_t *ro
         tx_buffer_size = 2;
     }
 
-    ESP_RETURN_ON_ERROR(onewire_bus_write_bytes(handle, tx_buffer, tx_buffer_size),
-                        TAG, "error while sending read scratchpad command");
-    ESP_RETURN_ON_ERROR(onewire_bus_read_bytes(handle, (uint8_t *)&scratchpad, sizeof(scratchpad)),
-                        TAG, "error while reading scratchpad command");
+    // send read scratchpad command and read the scratchpad in the same transaction
+    ESP_RETURN_ON_ERROR(onewire_bus_write_read_bytes(handle, tx_buffer, tx_buffer_size, (uint8_t *)&scratchpad, sizeof(scratchpad)),
+                        TAG, "error while reading scratchpad");
 
     ESP_RETURN_ON_FALSE(onewire_check_crc8((uint8_t *)&scratchpad, 8) == scratchpad.crc_value, ESP_ERR_INVALID_CRC,
                         TAG, "crc error");
@@ -84,7 +83,7 @@ esp_err_t ds18b20_set_resolution(onewire_bus_handle_t handle, const uint8_t *rom
 
     ESP_RETURN_ON_ERROR(onewire_bus_reset(handle), TAG, "error while resetting bus"); // reset bus and check if the device is present
 
-    uint8_t tx_buffer[10];
+    uint8_t tx_buffer[13];
     uint8_t tx_buffer_size;
 
     if (rom_number) { // specify rom id
@@ -98,13 +97,11 @@ esp_err_t ds18b20_set_resolution(onewire_bus_handle_t handle, const uint8_t *rom
         tx_buffer_size = 2;
     }
 
+    // append the scratchpad (alarm high, alarm low, configuration) to send it in the same transaction
+    tx_buffer[tx_buffer_size ++] = 0;
+    tx_buffer[tx_buffer_size ++] = 0;
+    tx_buffer[tx_buffer_size ++] = resolution;
     ESP_RETURN_ON_ERROR(onewire_bus_write_bytes(handle, tx_buffer, tx_buffer_size),
-                        TAG, "error while sending read scratchpad command");
-
-    tx_buffer[0] = 0;
-    tx_buffer[1] = 0;
-    tx_buffer[2] = resolution;
-    ESP_RETURN_ON_ERROR(onewire_bus_write_bytes(handle, tx_buffer, 3),
                         TAG, "error while sending write scratchpad command");
 
     return ESP_OK;
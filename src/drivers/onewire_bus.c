@@ -90,18 +90,17 @@ esp_err_t onewire_rom_search(onewire_rom_search_context_handler_t context)
             return ESP_ERR_NOT_FOUND;
         }
 
-        // send rom search command and start search algorithm
-        ESP_RETURN_ON_ERROR(onewire_bus_write_bytes(context->bus_handle, (uint8_t[]){ONEWIRE_CMD_SEARCH_ROM}, 1),
+        // send rom search command and read the first rom bit and its complement in the same transaction
+        uint32_t rom_bits;
+        ESP_RETURN_ON_ERROR(onewire_bus_write_read_bits(context->bus_handle, ONEWIRE_CMD_SEARCH_ROM, 8, &rom_bits, 2),
                             TAG, "error while sending search rom command");
 
         for (uint16_t rom_bit_index = 0; rom_bit_index < 64; rom_bit_index ++) {
             uint8_t rom_byte_index = rom_bit_index / 8;
             uint8_t rom_bit_mask = 1 << (rom_bit_index % 8); // calculate byte index and bit mask in advance for convenience
 
-            uint8_t rom_bit, rom_bit_complement;
-            ESP_RETURN_ON_ERROR(onewire_bus_read_bit(context->bus_handle, &rom_bit), TAG, "error while reading rom bit"); // write 1 bit to read from the bus
-            ESP_RETURN_ON_ERROR(onewire_bus_read_bit(context->bus_handle, &rom_bit_complement),
-                                TAG, "error while reading rom bit"); // read a bit and its complement
+            uint8_t rom_bit = rom_bits & 0x01;
+            uint8_t rom_bit_complement = (rom_bits >> 1) & 0x01; // a bit and its complement
 
             uint8_t search_direction;
             if (rom_bit && rom_bit_complement) { // No devices participating in search.
@@ -128,8 +127,9 @@ esp_err_t onewire_rom_search(onewire_rom_search_context_handler_t context)
                     context->rom_number[rom_byte_index] &= ~rom_bit_mask;
                 }
 
-                ESP_RETURN_ON_ERROR(onewire_bus_write_bit(context->bus_handle, search_direction),
-                                    TAG, "error while writing direction bit"); // set search direction
+                // set search direction, and read the next rom bit and its complement in the same transaction
+                ESP_RETURN_ON_ERROR(onewire_bus_write_read_bits(context->bus_handle, search_direction, 1, &rom_bits, rom_bit_index < 63 ? 2 : 0),
+                                    TAG, "error while writing direction bit");
             }
         }
     } else {
@@ -12,7 +12,7 @@
 #include "driver/rmt_rx.h"
 #include "driver/rmt_types.h"
 #include "driver/rmt_encoder.h"
-#include "drivers/onewire_bus_rmt.h"
+#include "drivers/onewire_bus.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +41,10 @@ static const char *TAG = "onewire_rmt";
 #define ONEWIRE_SLOT_RECOVERY_DURATION 2  // recovery time between each bit, should be longer in parasite power mode
 #define ONEWIRE_SLOT_BIT_SAMPLE_TIME 15 // how long after bit start pulse should the master sample from the bus
 
+#define ONEWIRE_MAX_BITS_PER_TRANSACTION 32 // limit of onewire_bus_write_read_bits
+
+#define ONEWIRE_RECOVERY_MAX_DEVICES 8 // devices looked at by the rom search that checks a recovery step
+
 /*
 Reset Pulse:
 
@@ -115,6 +119,10 @@ struct onewire_bus_t {
     size_t max_rx_bytes; /*!< buffer size in byte for single receive transaction */
 
     QueueHandle_t receive_queue;
+
+    onewire_bus_power_cycle_cb_t power_cycle_cb; /*!< last step of a bus recovery, optional */
+    void *power_cycle_ctx;
+    onewire_bus_recovery_stats_t recovery_stats;
 };
 
 const static rmt_symbol_word_t onewire_bit0_symbol = {
@@ -359,6 +367,113 @@ esp_err_t onewire_bus_reset(onewire_bus_handle_t handle)
     return is_present ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
+static esp_err_t onewire_rmt_reinit_channels(onewire_bus_handle_t handle)
+{
+    // disabling the channels aborts the transactions left pending by the failure,
+    // a channel left disabled by an earlier failed re-initialization is enabled below
+    esp_err_t ret = rmt_disable(handle->tx_channel);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "disable rmt tx channel failed: %s", esp_err_to_name(ret));
+    }
+    ret = rmt_disable(handle->rx_channel);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "disable rmt rx channel failed: %s", esp_err_to_name(ret));
+    }
+    xQueueReset(handle->receive_queue);
+
+    ESP_RETURN_ON_ERROR(rmt_enable(handle->rx_channel), TAG, "enable rmt rx channel failed");
+    ESP_RETURN_ON_ERROR(rmt_enable(handle->tx_channel), TAG, "enable rmt tx channel failed");
+
+    return ESP_OK;
+}
+
+static esp_err_t onewire_rmt_check_bus(onewire_bus_handle_t handle, const uint8_t *rom_number)
+{
+    ESP_RETURN_ON_ERROR(onewire_bus_reset(handle), TAG, "no presence pulse after recovery step");
+
+    if (!rom_number) {
+        return ESP_OK;
+    }
+
+    // re-enumerate the devices and look for the expected one
+    onewire_rom_search_context_handler_t context = NULL;
+    ESP_RETURN_ON_ERROR(onewire_rom_search_context_create(handle, &context), TAG, "create rom search context failed");
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    uint8_t found_rom_number[8];
+    for (int i = 0; i < ONEWIRE_RECOVERY_MAX_DEVICES; i ++) {
+        esp_err_t search_result = onewire_rom_search(context);
+        if (search_result == ESP_ERR_INVALID_CRC) {
+            continue;
+        } else if (search_result != ESP_OK) { // last device reached or bus error
+            break;
+        }
+
+        onewire_rom_get_number(context, found_rom_number);
+        if (memcmp(found_rom_number, rom_number, sizeof(found_rom_number)) == 0) {
+            ret = ESP_OK;
+            break;
+        }
+    }
+    onewire_rom_search_context_delete(context);
+
+    return ret;
+}
+
+esp_err_t onewire_bus_recover(onewire_bus_handle_t handle, const uint8_t *rom_number)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
+
+    handle->recovery_stats.recoveries ++;
+
+    // a bus reset is enough for devices stuck in the middle of a transaction
+    if (onewire_rmt_check_bus(handle, rom_number) == ESP_OK) {
+        return ESP_OK;
+    }
+
+    // re-initialize the rmt channels in place
+    handle->recovery_stats.channel_reinits ++;
+    ESP_LOGW(TAG, "1-wire bus reset did not recover, re-initializing rmt channels");
+    if (onewire_rmt_reinit_channels(handle) == ESP_OK && onewire_rmt_check_bus(handle, rom_number) == ESP_OK) {
+        return ESP_OK;
+    }
+
+    // power cycle the devices
+    if (handle->power_cycle_cb) {
+        handle->recovery_stats.power_cycles ++;
+        ESP_LOGW(TAG, "1-wire channel re-initialization did not recover, power cycling devices");
+        if (handle->power_cycle_cb(handle->power_cycle_ctx) == ESP_OK &&
+                onewire_rmt_reinit_channels(handle) == ESP_OK && onewire_rmt_check_bus(handle, rom_number) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+
+    handle->recovery_stats.failures ++;
+    ESP_LOGE(TAG, "1-wire bus recovery failed");
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t onewire_bus_set_power_cycle_hook(onewire_bus_handle_t handle, onewire_bus_power_cycle_cb_t cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
+
+    handle->power_cycle_cb = cb;
+    handle->power_cycle_ctx = user_ctx;
+
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_get_recovery_stats(onewire_bus_handle_t handle, onewire_bus_recovery_stats_t *stats_out)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
+    ESP_RETURN_ON_FALSE(stats_out, ESP_ERR_INVALID_ARG, TAG, "invalid stats pointer");
+
+    *stats_out = handle->recovery_stats;
+
+    return ESP_OK;
+}
+
 esp_err_t onewire_bus_write_bytes(onewire_bus_handle_t handle, const uint8_t *tx_data, uint8_t tx_data_size)
 {
     ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
@@ -441,6 +556,86 @@ esp_err_t onewire_bus_read_bit(onewire_bus_handle_t handle, uint8_t *rx_bit)
     return ESP_OK;
 }
 
+esp_err_t onewire_bus_write_read_bytes(onewire_bus_handle_t handle, const uint8_t *tx_data, uint8_t tx_data_size, uint8_t *rx_data, size_t rx_data_size)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
+    ESP_RETURN_ON_FALSE(tx_data && tx_data_size != 0, ESP_ERR_INVALID_ARG, TAG, "invalid tx buffer or buffer size");
+    ESP_RETURN_ON_FALSE(rx_data && rx_data_size != 0, ESP_ERR_INVALID_ARG, TAG, "invalid rx buffer or buffer size");
+
+    // the rx symbol buffer also records the written bytes, split the transaction if it is too small
+    if (tx_data_size + rx_data_size > handle->max_rx_bytes) {
+        ESP_RETURN_ON_ERROR(onewire_bus_write_bytes(handle, tx_data, tx_data_size), TAG, "1-wire data write failed");
+        return onewire_bus_read_bytes(handle, rx_data, rx_data_size);
+    }
+
+    uint8_t tx_buffer[tx_data_size + rx_data_size];
+    memcpy(tx_buffer, tx_data, tx_data_size);
+    memset(&tx_buffer[tx_data_size], 0xFF, rx_data_size); // transmit one bits to generate read clock
+
+    // transmit data followed by 1 bits while receiving
+    ESP_RETURN_ON_ERROR(rmt_receive(handle->rx_channel, handle->rx_symbols, sizeof(tx_buffer) * 8 * sizeof(rmt_symbol_word_t), &onewire_rmt_rx_config),
+                        TAG, "1-wire data receive failed");
+    ESP_RETURN_ON_ERROR(rmt_transmit(handle->tx_channel, handle->tx_bytes_encoder, tx_buffer, sizeof(tx_buffer), &onewire_rmt_tx_config),
+                        TAG, "1-wire data transmit failed");
+
+    // wait the transmission finishes, skip the written bytes and decode data
+    rmt_rx_done_event_data_t rmt_rx_evt_data;
+    if (xQueueReceive(handle->receive_queue, &rmt_rx_evt_data, pdMS_TO_TICKS(1000)) != pdPASS) {
+        return ESP_ERR_TIMEOUT;
+    }
+    ESP_RETURN_ON_FALSE(rmt_rx_evt_data.num_symbols >= sizeof(tx_buffer) * 8, ESP_ERR_INVALID_RESPONSE,
+                        TAG, "1-wire transaction cut short");
+    onewire_rmt_decode_data(&rmt_rx_evt_data.received_symbols[tx_data_size * 8], rx_data_size * 8, rx_data);
+
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_write_read_bits(onewire_bus_handle_t handle, uint32_t tx_bits, uint8_t tx_bit_count, uint32_t *rx_bits, uint8_t rx_bit_count)
+{
+    ESP_RETURN_ON_FALSE(handle, ESP_ERR_INVALID_ARG, TAG, "invalid 1-wire handle");
+    ESP_RETURN_ON_FALSE(tx_bit_count + rx_bit_count != 0 && tx_bit_count + rx_bit_count <= ONEWIRE_MAX_BITS_PER_TRANSACTION,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid bit count");
+    ESP_RETURN_ON_FALSE(rx_bits || rx_bit_count == 0, ESP_ERR_INVALID_ARG, TAG, "invalid rx_bits pointer");
+    ESP_RETURN_ON_FALSE(!(tx_bit_count + rx_bit_count > handle->max_rx_bytes * 8), ESP_ERR_INVALID_ARG,
+                        TAG, "bit count too large for buffer to hold");
+
+    rmt_symbol_word_t tx_symbols[ONEWIRE_MAX_BITS_PER_TRANSACTION];
+    size_t symbol_num = 0;
+    for (uint8_t i = 0; i < tx_bit_count; i ++) {
+        tx_symbols[symbol_num ++] = ((tx_bits >> i) & 0x01) ? onewire_bit1_symbol : onewire_bit0_symbol; // LSB first
+    }
+    for (uint8_t i = 0; i < rx_bit_count; i ++) {
+        tx_symbols[symbol_num ++] = onewire_bit1_symbol; // transmit one bits to generate read clock
+    }
+
+    if (rx_bit_count == 0) {
+        ESP_RETURN_ON_ERROR(rmt_transmit(handle->tx_channel, handle->tx_copy_encoder, tx_symbols, symbol_num * sizeof(rmt_symbol_word_t), &onewire_rmt_tx_config),
+                            TAG, "1-wire bits transmit failed");
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(handle->tx_channel, 50), TAG, "wait for 1-wire bits transmit failed");
+        return ESP_OK;
+    }
+
+    // transmit bits while receiving
+    ESP_RETURN_ON_ERROR(rmt_receive(handle->rx_channel, handle->rx_symbols, symbol_num * sizeof(rmt_symbol_word_t), &onewire_rmt_rx_config),
+                        TAG, "1-wire bits receive failed");
+    ESP_RETURN_ON_ERROR(rmt_transmit(handle->tx_channel, handle->tx_copy_encoder, tx_symbols, symbol_num * sizeof(rmt_symbol_word_t), &onewire_rmt_tx_config),
+                        TAG, "1-wire bits transmit failed");
+
+    // wait the transmission finishes, skip the written bits and decode data
+    rmt_rx_done_event_data_t rmt_rx_evt_data;
+    if (xQueueReceive(handle->receive_queue, &rmt_rx_evt_data, pdMS_TO_TICKS(1000)) != pdPASS) {
+        return ESP_ERR_TIMEOUT;
+    }
+    ESP_RETURN_ON_FALSE(rmt_rx_evt_data.num_symbols >= symbol_num, ESP_ERR_INVALID_RESPONSE,
+                        TAG, "1-wire transaction cut short");
+
+    uint8_t rx_buffer[ONEWIRE_MAX_BITS_PER_TRANSACTION / 8] = {0};
+    onewire_rmt_decode_data(&rmt_rx_evt_data.received_symbols[tx_bit_count], rx_bit_count, rx_buffer);
+    *rx_bits = rx_buffer[0] | (rx_buffer[1] << 8) | (rx_buffer[2] << 16) | ((uint32_t)rx_buffer[3] << 24);
+
+    return ESP_OK;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@
 #include "common/events.h"
 #include "common/gpios.h"
 #include "common/composter_parameters.h"
+#include "common/event_log.h"
 #include "drivers/hd44780.h"
 #include "drivers/pcf8574.h"
 
@@ -94,7 +95,7 @@ void Display_Start() {
  */
 static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
 
     // Handle different events and set corresponding messages for display
     if (strcmp(event_base, WIFI_EVENT_INTERNAL) == 0) {
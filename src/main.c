@@ -9,6 +9,8 @@
 #include "esp_system.h"
 
 #include "common/composter_parameters.h"
+#include "common/event_log.h"
+#include "common/timer_wheel.h"
 #include "hmi/buttons.h"
 #include "hmi/display.h"
 #include "communication/communicator.h"
@@ -17,6 +19,8 @@
 #include "actuators/crusher.h"
 #include "actuators/mixer.h"
 #include "actuators/fan.h"
+#include "control/controller.h"
+#include "sensors/acquisition.h"
 #include "sensors/humidity_sensor.h"
 #include "sensors/temperature_sensor.h"
 #include "sensors/capacity_sensor.h"
@@ -34,6 +38,12 @@ int app_main(void)
     // Create the default event loop.
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
+    // Start the deferred logger used by the event handlers.
+    EventLog_Start();
+
+    // Start the timing wheel that runs the software timers of every module.
+    TimerWheel_Start();
+
     // Initialize and set default values for ComposterParameters.
     ComposterParameters_Init(&composterParameters);
 
@@ -41,7 +51,8 @@ int app_main(void)
     Buttons_Start();
     Display_Start();
 
-    // Start sensor modules.
+    // Start the acquisition task and the sensor modules that run on it.
+    Acquisition_Start();
     HumiditySensor_Start();
     TemperatureSensor_Start();
     LidSensor_Start();
@@ -57,6 +68,9 @@ int app_main(void)
     Crusher_Start();
     Fan_Start();
 
+    // Start the controller that drives the actuators.
+    Control_Start();
+
     // Main loop to keep the program running.
     while (true);
 
@@ -0,0 +1,178 @@
+/**
+ * @file acquisition.c
+ * @brief Implementation of the sensor acquisition module.
+ *
+ * Pending jobs are kept as bits of the task notification value, one per job, so
+ * requests made while the task is busy are merged into the next cycle. The task,
+ * its stack and the result set are statically allocated.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+
+// Inclusion of FreeRTOS and ESP-IDF libraries
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Inclusion of custom header files
+#include "common/events.h"
+#include "sensors/acquisition.h"
+
+#define DEBUG false
+
+#define ACQUISITION_TASK_STACK_SIZE     4096
+#define ACQUISITION_TASK_PRIORITY       5
+
+ESP_EVENT_DEFINE_BASE(ACQUISITION_EVENT);
+
+// Define the structure of a registered job
+typedef struct {
+    const char *name;
+    AcquisitionJobFunction_t function;
+} AcquisitionJob_t;
+
+// Tag to identify log messages
+static const char *TAG = "AC_Acquisition";
+
+static TaskHandle_t acquisitionTask = NULL;
+static StaticTask_t acquisitionTaskBuffer;
+static StackType_t acquisitionStack[ACQUISITION_TASK_STACK_SIZE];
+
+static AcquisitionJob_t jobs[ACQUISITION_MAX_JOBS];
+static int jobCount = 0;
+static AcquisitionResults_t results;
+static AcquisitionStats_t stats;
+
+static void acquisition_task(void* param);
+
+/**
+ * @brief Starts the acquisition task.
+ */
+void Acquisition_Start() {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (acquisitionTask != NULL) {
+        return;
+    }
+
+    acquisitionTask = xTaskCreateStatic(acquisition_task, "acquisition_task", ACQUISITION_TASK_STACK_SIZE, NULL,
+                                        ACQUISITION_TASK_PRIORITY, acquisitionStack, &acquisitionTaskBuffer);
+}
+
+/**
+ * @brief Registers a sensor job.
+ *
+ * Jobs are registered at start-up from the sensor modules, before they are requested.
+ *
+ * @param name  Name used in log messages.
+ * @param job   Function that runs the job.
+ * @return Job identifier, -1 if the job table is full.
+ */
+int Acquisition_Register(const char *name, AcquisitionJobFunction_t job) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (job == NULL || jobCount >= ACQUISITION_MAX_JOBS) {
+        ESP_LOGE(TAG, "Cannot register job %s", name ? name : "");
+        return -1;
+    }
+
+    jobs[jobCount].name = name;
+    jobs[jobCount].function = job;
+
+    return jobCount++;
+}
+
+/**
+ * @brief Requests a job to run in the next cycle.
+ *
+ * Never blocks, so it can be called from timer callbacks and event handlers.
+ *
+ * @param job Job identifier returned by Acquisition_Register.
+ */
+void Acquisition_Request(int job) {
+    if (job < 0 || job >= jobCount || acquisitionTask == NULL) {
+        return;
+    }
+
+    xTaskNotify(acquisitionTask, 1UL << job, eSetBits);
+}
+
+/**
+ * @brief Requests a job to run in the next cycle, from an interrupt.
+ *
+ * @param job Job identifier returned by Acquisition_Register.
+ */
+void IRAM_ATTR Acquisition_RequestFromISR(int job) {
+    BaseType_t high_task_wakeup = pdFALSE;
+
+    if (job < 0 || job >= jobCount || acquisitionTask == NULL) {
+        return;
+    }
+
+    xTaskNotifyFromISR(acquisitionTask, 1UL << job, eSetBits, &high_task_wakeup);
+    portYIELD_FROM_ISR(high_task_wakeup);
+}
+
+/**
+ * @brief Gets a snapshot of the acquisition counters.
+ *
+ * Jobs run minus cycles is the number of wake-ups saved by running jobs back to back.
+ *
+ * @param acquisitionStats Structure that receives the counters.
+ */
+void Acquisition_GetStats(AcquisitionStats_t *acquisitionStats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+    if (acquisitionStats == NULL) {
+        return;
+    }
+
+    memcpy(acquisitionStats, &stats, sizeof(AcquisitionStats_t));
+}
+
+/**
+ * @brief Task that runs the requested jobs.
+ *
+ * Runs every pending job in registration order, including the ones requested
+ * while the cycle is running, and then posts the readings of the cycle.
+ *
+ * @param param Pointer to additional data (not used).
+ */
+static void acquisition_task(void* param) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    uint32_t pending;
+
+    while (true) {
+        xTaskNotifyWait(0, UINT32_MAX, &pending, portMAX_DELAY);
+
+        int64_t start = esp_timer_get_time();
+        memset(&results, 0, sizeof(AcquisitionResults_t));
+
+        do {
+            for (int i = 0; i < jobCount; i++) {
+                if (pending & (1UL << i)) {
+                    if (DEBUG) ESP_LOGI(TAG, "Running job %s", jobs[i].name);
+                    jobs[i].function(&results);
+                    stats.jobs++;
+                }
+            }
+        } while (xTaskNotifyWait(0, UINT32_MAX, &pending, 0) == pdTRUE);
+
+        stats.cycles++;
+        uint32_t duration = (uint32_t) (esp_timer_get_time() - start);
+        if (duration > stats.maxCycleUs) {
+            stats.maxCycleUs = duration;
+        }
+
+        if (results.readings != 0) {
+            results.cycle = stats.cycles;
+            esp_event_post(ACQUISITION_EVENT, ACQUISITION_EVENT_CYCLE, &results, sizeof(AcquisitionResults_t), portMAX_DELAY);
+            stats.published++;
+        }
+    }
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file adaptive_sampler.c
+ * @brief Implementation of a rate-of-change driven sampling period.
+ *
+ * The period grows by half while readings are flat and halves as soon as they
+ * move. On top of that it is capped so that a reading heading for the threshold
+ * is taken at least twice before it could get there, and shrinks linearly to the
+ * minimum as the reading closes in on the threshold.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+// Inclusion of custom header files
+#include "sensors/adaptive_sampler.h"
+
+#define MS_PER_MINUTE   (60 * 1000)
+#define MS_PER_DAY      (24ULL * 60 * 60 * 1000)
+
+/**
+ * @brief Initializes a sampler.
+ *
+ * @param sampler   Sampler to initialize.
+ * @param config    Settings, copied into the sampler.
+ */
+void AdaptiveSampler_Init(AdaptiveSampler *sampler, const AdaptiveSamplerConfig_t *config) {
+    if (sampler == NULL || config == NULL) {
+        return;
+    }
+
+    memset(sampler, 0, sizeof(AdaptiveSampler));
+    memcpy(&sampler->config, config, sizeof(AdaptiveSamplerConfig_t));
+    sampler->periodMs = config->minPeriodMs;
+}
+
+/**
+ * @brief Accounts for a reading and chooses the period until the next one.
+ *
+ * @param sampler       Sampler to update.
+ * @param value         Reading taken.
+ * @param elapsed_ms    Time since the previous reading.
+ * @return Period until the next reading, in milliseconds.
+ */
+uint32_t AdaptiveSampler_Update(AdaptiveSampler *sampler, float value, uint32_t elapsed_ms) {
+    if (sampler == NULL) {
+        return 0;
+    }
+
+    const AdaptiveSamplerConfig_t *config = &sampler->config;
+    float distance = config->threshold - value;     // Positive while stable
+    float period = sampler->periodMs;
+
+    sampler->samples++;
+
+    if (sampler->hasLast && elapsed_ms > 0) {
+        // Keep count of what the fixed schedule would have read over the same time
+        uint32_t fixed = sampler->lastValue > config->threshold ? config->unstableFixedMs : config->stableFixedMs;
+        if (fixed > 0) {
+            sampler->fixedSamplesMilli += (uint64_t) elapsed_ms * 1000 / fixed;
+        }
+        sampler->elapsedMs += elapsed_ms;
+
+        float rate = (value - sampler->lastValue) * MS_PER_MINUTE / elapsed_ms;
+        if (fabsf(rate) < config->flatRate) {
+            period *= 1.5f;
+        } else {
+            period /= 2;
+        }
+
+        // Read at least twice before a trend reaches the threshold
+        if ((distance > 0 && rate > 0) || (distance < 0 && rate < 0)) {
+            float eta = fabsf(distance) / fabsf(rate) * MS_PER_MINUTE;
+            if (eta / 2 < period) {
+                period = eta / 2;
+            }
+        }
+    }
+
+    // Close to the threshold, shrink towards the minimum
+    if (config->margin > 0 && fabsf(distance) < config->margin) {
+        float near = config->minPeriodMs + (config->maxPeriodMs - config->minPeriodMs) * fabsf(distance) / config->margin;
+        if (near < period) {
+            period = near;
+        }
+    }
+
+    if (distance < 0 && period > config->unstableMaxMs) {
+        period = config->unstableMaxMs;
+    }
+    if (period < config->minPeriodMs) {
+        period = config->minPeriodMs;
+    }
+    if (period > config->maxPeriodMs) {
+        period = config->maxPeriodMs;
+    }
+
+    sampler->periodMs = (uint32_t) period;
+    sampler->lastValue = value;
+    sampler->hasLast = true;
+
+    return sampler->periodMs;
+}
+
+/**
+ * @brief Gets a snapshot of the sampler counters.
+ *
+ * The per-day rates are extrapolated from the time covered so far, and are 0
+ * until two readings have been taken.
+ *
+ * @param sampler   Sampler to query.
+ * @param stats     Structure that receives the counters.
+ */
+void AdaptiveSampler_GetStats(const AdaptiveSampler *sampler, AdaptiveSamplerStats_t *stats) {
+    if (sampler == NULL || stats == NULL) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(AdaptiveSamplerStats_t));
+    stats->samples = sampler->samples;
+    stats->periodMs = sampler->periodMs;
+
+    if (sampler->elapsedMs > 0) {
+        stats->samplesPerDay = (uint32_t) ((sampler->samples - 1) * MS_PER_DAY / sampler->elapsedMs);
+        stats->fixedSamplesPerDay = (uint32_t) (sampler->fixedSamplesMilli * MS_PER_DAY / 1000 / sampler->elapsedMs);
+    }
+}
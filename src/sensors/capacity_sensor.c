@@ -8,13 +8,13 @@
 
 #include "common/composter_parameters.h"
 #include "common/events.h"
+#include "common/event_log.h"
 #include "sensors/capacity_sensor.h"
 
 #define DEBUG false
 
-#define TIMER_EXPIRED_BIT           BIT0
-#define MIXER_OFF_BIT               BIT1
 #define FULL_CAPACITY_TIMER_MS      1 * 60 * 1000
+#define ECHO_TIMEOUT_MS             50          /* Longer pulses than 35 ms are discarded anyway */
 
 ESP_EVENT_DEFINE_BASE(CAPACITY_EVENT);
 
@@ -36,27 +36,28 @@ typedef enum {
 } capacity_state_t;
 
 static capacity_state_t current_capacity_state = NOT_FULL;
+static capacity_state_t prev_capacity_state = NOT_FULL;
 
-static void timer_callback(TimerHandle_t pxTimer);
+static void timer_callback(void *arg);
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
 static bool hc_sr04_echo_callback(mcpwm_cap_channel_handle_t cap_chan, const mcpwm_capture_event_data_t *edata, void *user_data);
 static void gen_trig_output(void);
-static void capacity_measurement_task(void *pvParameters);
+static void measurement_job(AcquisitionResults_t *results);
 
-static void timer_callback(TimerHandle_t pxTimer) {
+static void timer_callback(void *arg) {
     // Check if mixer is on
     if (ComposterParameters_GetMixerState(&composterParameters)) {
-        xEventGroupSetBits(sensor.eventGroup, TIMER_EXPIRED_BIT);
+        Acquisition_Request(sensor.job);
     }
 }
 
 static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
-    ESP_LOGI(TAG, "Event received: %s, %ld", event_base, event_id);
+    EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, event_id);
 
     if (strcmp(event_base, MIXER_EVENT) == 0) {
         if (event_id == MIXER_EVENT_OFF) {
-            xEventGroupSetBits(sensor.eventGroup, MIXER_OFF_BIT);
+            Acquisition_Request(sensor.job);
         }
     }
 }
@@ -65,13 +66,12 @@ static void event_handler(void* arg, esp_event_base_t event_base, int32_t event_
  * @brief Ultrasonic sensor echo callback implementation.
  * @param cap_chan The MCPWM capture channel handle.
  * @param edata Data related to the capture event.
- * @param user_data User data (task handle to notify).
+ * @param user_data User data (not used).
  * @return Whether the task should be woken up.
  */
 static bool hc_sr04_echo_callback(mcpwm_cap_channel_handle_t cap_chan, const mcpwm_capture_event_data_t *edata, void *user_data) {
     static uint32_t cap_val_begin_of_sample = 0;
     static uint32_t cap_val_end_of_sample = 0;
-    TaskHandle_t task_to_notify = (TaskHandle_t)user_data;
     BaseType_t high_task_wakeup = pdFALSE;
 
     //calculate the interval in the ISR,
@@ -82,10 +82,10 @@ static bool hc_sr04_echo_callback(mcpwm_cap_channel_handle_t cap_chan, const mcp
         cap_val_end_of_sample = cap_val_begin_of_sample;
     } else {
         cap_val_end_of_sample = edata->cap_value;
-        uint32_t tof_ticks = cap_val_end_of_sample - cap_val_begin_of_sample;
+        sensor.tof_ticks = cap_val_end_of_sample - cap_val_begin_of_sample;
 
-        // notify the task to calculate the distance
-        xTaskNotifyFromISR(task_to_notify, tof_ticks, eSetValueWithOverwrite, &high_task_wakeup);
+        // wake up the measurement job to calculate the distance
+        xSemaphoreGiveFromISR(sensor.echoDone, &high_task_wakeup);
     }
 
     return high_task_wakeup == pdTRUE;
@@ -101,91 +101,74 @@ static void gen_trig_output(void) {
 }
 
 /**
- * @brief Task for capacity measurement.
- * @param pvParameters Task parameters (unused).
+ * @brief Acquisition job that measures the capacity.
+ * @param results Result set of the acquisition cycle.
  */
-static void capacity_measurement_task(void *pvParameters) {
+static void measurement_job(AcquisitionResults_t *results) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    EventBits_t uxBits;
-    capacity_state_t prev_capacity_state = current_capacity_state;
     float capacity_value;
 
-    // Register the callback function for the ultrasonic sensor's echo signal
-    if (DEBUG) ESP_LOGI(TAG, "Register capture callback");
-    sensor.task_to_notify = xTaskGetCurrentTaskHandle();
-    sensor.cbs.on_cap = hc_sr04_echo_callback;
-    ESP_ERROR_CHECK(mcpwm_capture_channel_register_event_callbacks(sensor.cap_chan, &sensor.cbs, sensor.task_to_notify));
+    // Drop a stale echo and generate a trigger output for the ultrasonic sensor
+    xSemaphoreTake(sensor.echoDone, 0);
+    gen_trig_output();
 
-    // Enable the capture channel for the ultrasonic sensor
-    if (DEBUG) ESP_LOGI(TAG, "Enable capture channel");
-    ESP_ERROR_CHECK(mcpwm_capture_channel_enable(sensor.cap_chan));
+    // Wait for the ultrasonic sensor's echo callback
+    if (xSemaphoreTake(sensor.echoDone, pdMS_TO_TICKS(ECHO_TIMEOUT_MS)) != pdTRUE) {
+        return;
+    }
 
-    // Enable and start the capture timer for the ultrasonic sensor
-    if (DEBUG) ESP_LOGI(TAG, "Enable and start capture timer");
-    ESP_ERROR_CHECK(mcpwm_capture_timer_enable(sensor.cap_timer));
-    ESP_ERROR_CHECK(mcpwm_capture_timer_start(sensor.cap_timer));
+    // Calculate pulse width in microseconds from time-of-flight ticks
+    float pulse_width_us = sensor.tof_ticks * (1000000.0 / esp_clk_apb_freq());
+
+    // Check if pulse width is within a valid range
+    if (pulse_width_us > 35000) {
+        return;
+    }
+
+    // Calculate capacity value based on pulse width (modify for actual capacity calculation)
+    capacity_value = (float)pulse_width_us / 58;
+    if (DEBUG) ESP_LOGI(TAG, "Measured capacity: %.2f", capacity_value);
 
-    uint32_t tof_ticks;
-    while (true) {
-        // Wait for events related to timer expiration or mixer being turned off
-        uxBits = xEventGroupWaitBits(sensor.eventGroup, TIMER_EXPIRED_BIT | MIXER_OFF_BIT, pdTRUE, pdFALSE, portMAX_DELAY);
-
-        if (uxBits & TIMER_EXPIRED_BIT || uxBits & MIXER_OFF_BIT) {
-            // Generate a trigger output for the ultrasonic sensor
-            gen_trig_output();
-
-            // Wait for notification from the ultrasonic sensor's echo callback
-            if (xTaskNotifyWait(0x00, ULONG_MAX, &tof_ticks, pdMS_TO_TICKS(1000)) == pdTRUE) {
-                // Calculate pulse width in microseconds from time-of-flight ticks
-                float pulse_width_us = tof_ticks * (1000000.0 / esp_clk_apb_freq());
-
-                // Check if pulse width is within a valid range
-                if (pulse_width_us > 35000) {
-                    continue;
-                }
-
-                // Calculate capacity value based on pulse width (modify for actual capacity calculation)
-                capacity_value = (float)pulse_width_us / 58;
-                if (DEBUG) ESP_LOGI(TAG, "Measured capacity: %.2f", capacity_value);
-
-                // Determine the capacity state based on the measured value
-                if (capacity_value < MAX_CAPACITY_FLOAT) {
-                    current_capacity_state = FULL;
-                } else {
-                    current_capacity_state = NOT_FULL;
-                }
-
-                // Handle state changes and trigger events accordingly
-                if (prev_capacity_state != current_capacity_state) {
-                    prev_capacity_state = current_capacity_state;
-                    switch (current_capacity_state) {
-                        case NOT_FULL:
-                            xTimerStop(sensor.fullTimer, 0);
-                            esp_event_post(CAPACITY_EVENT, CAPACITY_EVENT_NOT_FULL, NULL, 0, portMAX_DELAY);
-                            break;
-                        case FULL:
-                            xTimerStart(sensor.fullTimer, 0);
-                            esp_event_post(CAPACITY_EVENT, CAPACITY_EVENT_FULL, NULL, 0, portMAX_DELAY);
-                            break;
-                        default:
-                            break;
-                    }
-                }
-
-                // Calculate percentage and update ComposterParameters
-                float percentage = 100 * capacity_value / 32;
-                if (percentage < 0) {
-                    percentage = 0;
-                } else if (percentage > 100) {
-                    percentage = 100;
-                }
-
-                ComposterParameters_SetComplete(&composterParameters, percentage);
-            }
+    // Determine the capacity state based on the measured value
+    if (capacity_value < MAX_CAPACITY_FLOAT) {
+        current_capacity_state = FULL;
+    } else {
+        current_capacity_state = NOT_FULL;
+    }
+
+    // Handle state changes and trigger events accordingly
+    if (prev_capacity_state != current_capacity_state) {
+        prev_capacity_state = current_capacity_state;
+        ComposterParameters_SetFullState(&composterParameters, current_capacity_state == FULL);
+        switch (current_capacity_state) {
+            case NOT_FULL:
+                TimerWheel_Cancel(&sensor.fullTimer);
+                esp_event_post(CAPACITY_EVENT, CAPACITY_EVENT_NOT_FULL, NULL, 0, portMAX_DELAY);
+                break;
+            case FULL:
+                TimerWheel_Arm(&sensor.fullTimer);
+                esp_event_post(CAPACITY_EVENT, CAPACITY_EVENT_FULL, NULL, 0, portMAX_DELAY);
+                break;
+            default:
+                break;
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
     }
+
+    // Calculate percentage and update ComposterParameters
+    float percentage = 100 * capacity_value / 32;
+    if (percentage < 0) {
+        percentage = 0;
+    } else if (percentage > 100) {
+        percentage = 100;
+    }
+
+    ComposterParameters_SetComplete(&composterParameters, percentage);
+
+    // Add the reading to the cycle results
+    results->complete = percentage;
+    results->isFull = current_capacity_state == FULL;
+    results->readings |= ACQUISITION_READING_CAPACITY;
 }
 
 /**
@@ -224,11 +207,24 @@ void CapacitySensor_Start() {
     ESP_ERROR_CHECK(gpio_config(&sensor.io_conf));
     ESP_ERROR_CHECK(gpio_set_level(SENSOR_TRIG_GPIO, 0));
 
-    ESP_ERROR_CHECK(esp_event_handler_register(MIXER_EVENT, MIXER_EVENT_OFF, &event_handler, NULL));
+    // Register the callback function for the ultrasonic sensor's echo signal
+    if (DEBUG) ESP_LOGI(TAG, "Register capture callback");
+    sensor.echoDone = xSemaphoreCreateBinaryStatic(&sensor.echoDoneBuffer);
+    sensor.cbs.on_cap = hc_sr04_echo_callback;
+    ESP_ERROR_CHECK(mcpwm_capture_channel_register_event_callbacks(sensor.cap_chan, &sensor.cbs, NULL));
 
-    sensor.eventGroup = xEventGroupCreate(); 
-    sensor.fullTimer = xTimerCreate("CapacitySensor_Timer", pdMS_TO_TICKS(FULL_CAPACITY_TIMER_MS), true, NULL, timer_callback);
+    // Enable the capture channel for the ultrasonic sensor
+    if (DEBUG) ESP_LOGI(TAG, "Enable capture channel");
+    ESP_ERROR_CHECK(mcpwm_capture_channel_enable(sensor.cap_chan));
+
+    // Enable and start the capture timer for the ultrasonic sensor
+    if (DEBUG) ESP_LOGI(TAG, "Enable and start capture timer");
+    ESP_ERROR_CHECK(mcpwm_capture_timer_enable(sensor.cap_timer));
+    ESP_ERROR_CHECK(mcpwm_capture_timer_start(sensor.cap_timer));
 
-    xTaskCreate(capacity_measurement_task, "capacity_task", 4096, NULL, 5, NULL);
+    sensor.job = Acquisition_Register("capacity", measurement_job);
+    TimerWheel_Init(&sensor.fullTimer, "CapacitySensor_Timer", FULL_CAPACITY_TIMER_MS, true, timer_callback, NULL);
+
+    ESP_ERROR_CHECK(esp_event_handler_register(MIXER_EVENT, MIXER_EVENT_OFF, &event_handler, NULL));
 }
 
@@ -8,76 +8,82 @@
 
 #define DEBUG false
 
-#define TIMER_EXPIRED_BIT               (1 << 0)
 #define STABLE_HUMIDITY_TIMER_MS        10 * 60 * 1000
 #define UNSTABLE_HUMIDITY_TIMER_MS      2 * 60 * 1000
 #define ERROR_READ_SENSOR_TIMER_MS      60 * 1000
+#define MIN_SAMPLING_PERIOD_MS          60 * 1000
+#define MAX_SAMPLING_PERIOD_MS          30 * 60 * 1000
+#define THRESHOLD_MARGIN                5.0f        /* %RH */
+#define FLAT_RATE                       0.1f        /* %RH per minute */
 #define MAX_HUMIDITY                    60
 
-ESP_EVENT_DEFINE_BASE(HUMIDITY_EVENT);
-
 static const char *TAG = "AC_HumiditySensor";
 
 static HumiditySensor_t sensor;
 extern ComposterParameters composterParameters;
 
 static int sensor_failures = 0;
-
-static void timer_callback(TimerHandle_t pxTimer);
-static void reader_task(void *pvParameter);
-int read_humidity_sensor();
+static int64_t last_sample_us = 0;
+
+static const AdaptiveSamplerConfig_t samplerConfig = {
+    .minPeriodMs = MIN_SAMPLING_PERIOD_MS,
+    .maxPeriodMs = MAX_SAMPLING_PERIOD_MS,
+    .unstableMaxMs = UNSTABLE_HUMIDITY_TIMER_MS,
+    .threshold = MAX_HUMIDITY,
+    .margin = THRESHOLD_MARGIN,
+    .flatRate = FLAT_RATE,
+    .stableFixedMs = STABLE_HUMIDITY_TIMER_MS,
+    .unstableFixedMs = UNSTABLE_HUMIDITY_TIMER_MS,
+};
+
+static void timer_callback(void *arg);
+static void reader_job(AcquisitionResults_t *results);
+int read_humidity_sensor(AcquisitionResults_t *results);
 void reset_humidity_sensor();
 
 /**
  * @brief Callback function for the humidity sensor timer.
- * @param pxTimer Timer handle.
+ * @param arg Timer argument (unused).
  */
-static void timer_callback(TimerHandle_t pxTimer) {
-    xEventGroupSetBits(sensor.eventGroup, TIMER_EXPIRED_BIT);
+static void timer_callback(void *arg) {
+    Acquisition_Request(sensor.job);
 }
 
 /**
- * @brief Task for reading humidity sensor values.
- * @param pvParameter Task parameters (unused).
+ * @brief Acquisition job that reads the humidity sensor.
+ * @param results Result set of the acquisition cycle.
  */
-static void reader_task(void *pvParameter) {
+static void reader_job(AcquisitionResults_t *results) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    EventBits_t uxBits;
-
-    // Initial reading of the humidity sensor
-    read_humidity_sensor();
-
-    while (true) {
-        // Wait for the timer expiration event
-        uxBits = xEventGroupWaitBits(sensor.eventGroup, TIMER_EXPIRED_BIT, true, false, portMAX_DELAY);
-
-        // Perform a new reading when the timer expires
-        if (uxBits & TIMER_EXPIRED_BIT) {
-            read_humidity_sensor();
-        }
-
-        // Delay the task by 1000 milliseconds
-        vTaskDelay(pdMS_TO_TICKS(1000));
-    }
-
-    // This line will not be reached, as the task runs in an infinite loop
-    vTaskDelete(NULL);
+    read_humidity_sensor(results);
 }
 
 void HumiditySensor_Start() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    // Create an event group and a stable timer for the humidity sensor
-    sensor.eventGroup = xEventGroupCreate(); 
-    sensor.stableTimer = xTimerCreate("HumiditySensor_Timer", pdMS_TO_TICKS(STABLE_HUMIDITY_TIMER_MS), true, NULL, timer_callback);
+    // Register the reading job and create the sampling timer for the humidity sensor
+    sensor.job = Acquisition_Register("humidity", reader_job);
+    AdaptiveSampler_Init(&sensor.sampler, &samplerConfig);
+    TimerWheel_Init(&sensor.stableTimer, "HumiditySensor_Timer", MIN_SAMPLING_PERIOD_MS, true, timer_callback, NULL);
 
     // Set the GPIO pin for the humidity sensor
     setDHTgpio(HUMIDITY_SENSOR_GPIO);
 
-    // Create and start the reader task
-    xTaskCreate(reader_task, "HumiditySensor_ReaderTask", 2048, NULL, 4, NULL);
-    xTimerStart(sensor.stableTimer, 0);
+    // Take the initial reading and start the timer
+    Acquisition_Request(sensor.job);
+    TimerWheel_Arm(&sensor.stableTimer);
+}
+
+/**
+ * @brief Gets the sampling counters of the humidity sensor.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void HumiditySensor_GetSamplingStats(AdaptiveSamplerStats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    AdaptiveSampler_GetStats(&sensor.sampler, stats);
 }
 
 /**
@@ -91,9 +97,10 @@ void reset_humidity_sensor() {
 
 /**
  * @brief Read values from the humidity sensor.
+ * @param results Result set that receives the reading.
  * @return Result of the sensor reading operation.
  */
-int read_humidity_sensor() {
+int read_humidity_sensor(AcquisitionResults_t *results) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     if (DEBUG) ESP_LOGI(TAG, "Reading values:");
@@ -107,7 +114,7 @@ int read_humidity_sensor() {
         // If failures exceed a threshold, reset the sensor and adjust timer period
         if (sensor_failures >= 5) {
             reset_humidity_sensor();
-            xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(ERROR_READ_SENSOR_TIMER_MS), portMAX_DELAY);
+            TimerWheel_ChangePeriod(&sensor.stableTimer, ERROR_READ_SENSOR_TIMER_MS);
         }
 
         return ret;
@@ -120,16 +127,20 @@ int read_humidity_sensor() {
     // Update ComposterParameters with the humidity value
     ComposterParameters_SetHumidity(&composterParameters, humidity);
 
-    // Check humidity state and trigger events accordingly
-    if (humidity > MAX_HUMIDITY) {
-        ComposterParameters_SetHumidityState(&composterParameters, false);
-        esp_event_post(HUMIDITY_EVENT, HUMIDITY_EVENT_UNSTABLE, NULL, 0, portMAX_DELAY);
-        xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(UNSTABLE_HUMIDITY_TIMER_MS), portMAX_DELAY);
-    } else {
-        ComposterParameters_SetHumidityState(&composterParameters, true);
-        esp_event_post(HUMIDITY_EVENT, HUMIDITY_EVENT_STABLE, NULL, 0, portMAX_DELAY);
-        xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(STABLE_HUMIDITY_TIMER_MS), portMAX_DELAY);
-    }
+    // Check humidity state and add the reading to the cycle results
+    bool stable = humidity <= MAX_HUMIDITY;
+    ComposterParameters_SetHumidityState(&composterParameters, stable);
+    results->humidity = humidity;
+    results->isHumidityStable = stable;
+    results->readings |= ACQUISITION_READING_HUMIDITY;
+
+    // Choose when to read next from the trend of the readings
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = last_sample_us ? (uint32_t) ((now - last_sample_us) / 1000) : 0;
+    last_sample_us = now;
+    uint32_t period = AdaptiveSampler_Update(&sensor.sampler, humidity, elapsed_ms);
+    TimerWheel_ChangePeriod(&sensor.stableTimer, period);
+    if (DEBUG) ESP_LOGI(TAG, "Next reading in %lu s", period / 1000);
 
     return ret;
 }
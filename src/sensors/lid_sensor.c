@@ -9,14 +9,15 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/event_groups.h"
-#include "freertos/timers.h"
 #include "driver/gpio.h"
+#include "esp_log.h"
 
 #include "common/composter_parameters.h"
 #include "common/gpios.h"
 #include "common/events.h"
+#include "common/timer_wheel.h"
+#include "sensors/acquisition.h"
 #include "sensors/lid_sensor.h"
 
 #define DEBUG false
@@ -30,54 +31,58 @@ ESP_EVENT_DEFINE_BASE(LID_EVENT);
 
 static const char *TAG = "AC_LidSensor";
 
-static QueueHandle_t gpio_evt_queue = NULL;
-static TimerHandle_t lidTimer = NULL;
+static int lidJob = -1;
+static WheelTimer_t lidTimer;
 extern ComposterParameters composterParameters;
 
 static int current_gpio_state;
 
-static void lid_sensor_task(void* arg);
-static void timer_callback_function(TimerHandle_t xTimer);
+static void lid_job(AcquisitionResults_t *results);
+static void timer_callback_function(void *arg);
 
 static void IRAM_ATTR gpio_isr_handler(void* arg) {
-    uint32_t gpio_num = (uint32_t) arg;
-    xQueueSendFromISR(gpio_evt_queue, &gpio_num, NULL);
+    Acquisition_RequestFromISR(lidJob);
 }
 
 /**
  * @brief Callback function for Lid Sensor timer.
- * @param xTimer Timer handle.
+ * @param arg Timer argument (unused).
+ *
+ * Runs in the timer wheel task, so the request is dropped rather than blocking
+ * when the event queue is full; the timer repeats it on the next period.
  */
-static void timer_callback_function(TimerHandle_t xTimer) {
+static void timer_callback_function(void *arg) {
     if (ComposterParameters_GetLidState(&composterParameters)) {
-        ESP_ERROR_CHECK(esp_event_post(LID_EVENT, LID_EVENT_REQUEST_TO_CLOSE_LID, NULL, 0, portMAX_DELAY));
+        if (esp_event_post(LID_EVENT, LID_EVENT_REQUEST_TO_CLOSE_LID, NULL, 0, 0) != ESP_OK) {
+            ESP_LOGW(TAG, "Event queue full, request to close lid dropped");
+        }
     }
 }
 
 /**
- * @brief Task to handle Lid Sensor events.
- * @param arg Task parameters (unused).
+ * @brief Acquisition job to handle Lid Sensor edges.
+ * @param results Result set of the acquisition cycle.
  */
-static void lid_sensor_task(void* arg) {
-    uint32_t io_num;
-    while (true) {
-        if (xQueueReceive(gpio_evt_queue, &io_num, portMAX_DELAY)) {
-            if (current_gpio_state != gpio_get_level(io_num)) {
-                current_gpio_state = gpio_get_level(io_num);
-                if (DEBUG) printf("%s: GPIO[%"PRIu32"] intr, val: %d\n", TAG, io_num, gpio_get_level(io_num));
-                if (gpio_get_level(io_num)) {
-                    if (DEBUG) printf("LID OPENED\n");
-                    ComposterParameters_SetLidState(&composterParameters, false);
-                    ESP_ERROR_CHECK(esp_event_post(LID_EVENT, LID_EVENT_OPENED, NULL, 0, portMAX_DELAY));
-                    xTimerStart(lidTimer, portMAX_DELAY);
-                } else {
-                    if (DEBUG) printf("LID CLOSED\n");
-                    ComposterParameters_SetLidState(&composterParameters, true);
-                    ESP_ERROR_CHECK(esp_event_post(LID_EVENT, LID_EVENT_CLOSED, NULL, 0, portMAX_DELAY));
-                    xTimerStop(lidTimer, portMAX_DELAY);
-                }
-            }
+static void lid_job(AcquisitionResults_t *results) {
+    int level = gpio_get_level(GPIO_INPUT_IO_0);
+
+    if (current_gpio_state != level) {
+        current_gpio_state = level;
+        if (DEBUG) printf("%s: GPIO[%d] intr, val: %d\n", TAG, GPIO_INPUT_IO_0, level);
+        if (level) {
+            if (DEBUG) printf("LID OPENED\n");
+            ComposterParameters_SetLidState(&composterParameters, false);
+            ESP_ERROR_CHECK(esp_event_post(LID_EVENT, LID_EVENT_OPENED, NULL, 0, portMAX_DELAY));
+            TimerWheel_Arm(&lidTimer);
+        } else {
+            if (DEBUG) printf("LID CLOSED\n");
+            ComposterParameters_SetLidState(&composterParameters, true);
+            ESP_ERROR_CHECK(esp_event_post(LID_EVENT, LID_EVENT_CLOSED, NULL, 0, portMAX_DELAY));
+            TimerWheel_Cancel(&lidTimer);
         }
+
+        results->isLidClosed = !level;
+        results->readings |= ACQUISITION_READING_LID;
     }
 }
 
@@ -103,15 +108,13 @@ void LidSensor_Start() {
         ComposterParameters_SetLidState(&composterParameters, false);
     }
 
-    // Create a queue to handle gpio event from isr.
-    gpio_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    // Start gpio task.
-    xTaskCreate(lid_sensor_task, "lid_sensor_task", 2048, NULL, 3, NULL);
+    TimerWheel_Init(&lidTimer, "lidTimer", LID_OPENED_TIMEOUT_MS, true, timer_callback_function, NULL);
+
+    // Register the job that handles the gpio events from isr.
+    lidJob = Acquisition_Register("lid", lid_job);
 
     // Install gpio isr service.
     gpio_install_isr_service(ESP_INTR_FLAG_DEFAULT);
     // Hook isr handler for specific gpio pin.
     gpio_isr_handler_add(GPIO_INPUT_IO_0, gpio_isr_handler, (void*) GPIO_INPUT_IO_0);
-
-    lidTimer = xTimerCreate("lidTimer", pdMS_TO_TICKS(LID_OPENED_TIMEOUT_MS), pdTRUE, NULL, timer_callback_function);
 }
@@ -8,12 +8,14 @@
 
 #define DEBUG false
 
-ESP_EVENT_DEFINE_BASE(TEMPERATURE_EVENT);
-
-#define TIMER_EXPIRED_BIT               (1 << 0)
 #define STABLE_HUMIDITY_TIMER_MS        10 * 60 * 1000
 #define UNSTABLE_HUMIDITY_TIMER_MS      2 * 60 * 1000
 #define ERROR_READ_SENSOR_TIMER_MS      60 * 1000
+#define CONVERSION_TIME_MS              800
+#define MIN_SAMPLING_PERIOD_MS          60 * 1000
+#define MAX_SAMPLING_PERIOD_MS          30 * 60 * 1000
+#define THRESHOLD_MARGIN                2.0f        /* degrees C */
+#define FLAT_RATE                       0.05f       /* degrees C per minute */
 #define MAX_TEMPERATURE                 30
 
 static const char *TAG = "AC_TemperatureSensor";
@@ -22,47 +24,60 @@ static TemperatureSensor_t sensor;
 extern ComposterParameters composterParameters;
 
 static int sensor_failures = 0;
-
-static void timer_callback(TimerHandle_t pxTimer);
-static void reader_task(void *pvParameter);
+static int64_t last_sample_us = 0;
+
+static const AdaptiveSamplerConfig_t samplerConfig = {
+    .minPeriodMs = MIN_SAMPLING_PERIOD_MS,
+    .maxPeriodMs = MAX_SAMPLING_PERIOD_MS,
+    .unstableMaxMs = UNSTABLE_HUMIDITY_TIMER_MS,
+    .threshold = MAX_TEMPERATURE,
+    .margin = THRESHOLD_MARGIN,
+    .flatRate = FLAT_RATE,
+    .stableFixedMs = STABLE_HUMIDITY_TIMER_MS,
+    .unstableFixedMs = UNSTABLE_HUMIDITY_TIMER_MS,
+};
+
+static void timer_callback(void *arg);
+static void convert_job(AcquisitionResults_t *results);
+static void reader_job(AcquisitionResults_t *results);
 esp_err_t initialize_onewire_sensor();
-int read_temperature_sensor();
+esp_err_t start_temperature_conversion();
+int read_temperature_sensor(AcquisitionResults_t *results);
 void reset_temperature_sensor();
+static void handle_sensor_error(esp_err_t err);
 
 /**
- * @brief Callback function for the temperature sensor timer.
- * @param pxTimer Timer handle.
+ * @brief Callback function for the temperature sensor timers.
+ * @param arg Pointer to the acquisition job to request.
  */
-static void timer_callback(TimerHandle_t pxTimer) {
-    xEventGroupSetBits(sensor.eventGroup, TIMER_EXPIRED_BIT);
+static void timer_callback(void *arg) {
+    Acquisition_Request(*(int *) arg);
 }
 
 /**
- * @brief Task to handle temperature sensor reading.
- * @param pvParameter Task parameters (unused).
+ * @brief Acquisition job that starts a temperature conversion.
+ *
+ * The conversion takes CONVERSION_TIME_MS; instead of waiting for it, the
+ * reading job is requested by the conversion timer once it is done.
+ *
+ * @param results Result set of the acquisition cycle (not used).
  */
-static void reader_task(void *pvParameter) {
+static void convert_job(AcquisitionResults_t *results) {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    EventBits_t uxBits;
-
-    read_temperature_sensor();
-
-    while (true) {
-        uxBits = xEventGroupWaitBits(sensor.eventGroup, TIMER_EXPIRED_BIT, true, false, portMAX_DELAY);
-
-        if (uxBits & TIMER_EXPIRED_BIT) {
-            read_temperature_sensor();
-        }
-
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    if (start_temperature_conversion() == ESP_OK) {
+        TimerWheel_Arm(&sensor.conversionTimer);
     }
+}
 
-    // Clean up resources when the task is deleted.
-    ESP_ERROR_CHECK(onewire_del_bus(sensor.handle));
-    if (DEBUG) ESP_LOGI(TAG, "1-wire bus deleted");
+/**
+ * @brief Acquisition job that reads the converted temperature.
+ * @param results Result set of the acquisition cycle.
+ */
+static void reader_job(AcquisitionResults_t *results) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
-    vTaskDelete(NULL);
+    read_temperature_sensor(results);
 }
 
 void TemperatureSensor_Start() {
@@ -70,12 +85,28 @@ void TemperatureSensor_Start() {
 
     // Initialize the 1-Wire sensor bus.
     ESP_ERROR_CHECK(initialize_onewire_sensor());
-    sensor.eventGroup = xEventGroupCreate(); 
-    sensor.stableTimer = xTimerCreate("TemperatureSensor_Timer", pdMS_TO_TICKS(STABLE_HUMIDITY_TIMER_MS), true, NULL, timer_callback);
 
-    // Start the temperature sensor reader task.
-    xTaskCreate(reader_task, "TemperatureSensor_ReaderTask", 2048, NULL, 5, NULL);
-    xTimerStart(sensor.stableTimer, 0);
+    // Register the conversion and reading jobs, and the timers that request them.
+    sensor.convertJob = Acquisition_Register("temperature_convert", convert_job);
+    sensor.readJob = Acquisition_Register("temperature_read", reader_job);
+    AdaptiveSampler_Init(&sensor.sampler, &samplerConfig);
+    TimerWheel_Init(&sensor.stableTimer, "TemperatureSensor_Timer", MIN_SAMPLING_PERIOD_MS, true, timer_callback, &sensor.convertJob);
+    TimerWheel_Init(&sensor.conversionTimer, "TemperatureSensor_Conversion", CONVERSION_TIME_MS, false, timer_callback, &sensor.readJob);
+
+    // Take the initial reading and start the timer.
+    Acquisition_Request(sensor.convertJob);
+    TimerWheel_Arm(&sensor.stableTimer);
+}
+
+/**
+ * @brief Gets the sampling counters of the temperature sensor.
+ *
+ * @param stats Structure that receives the counters.
+ */
+void TemperatureSensor_GetSamplingStats(AdaptiveSamplerStats_t *stats) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    AdaptiveSampler_GetStats(&sensor.sampler, stats);
 }
 
 /**
@@ -88,7 +119,7 @@ esp_err_t initialize_onewire_sensor() {
     // Configuration for the 1-Wire sensor bus.
     sensor.config = (onewire_rmt_config_t){
         .gpio_pin = TEMPERATURE_SENSOR_GPIO,
-        .max_rx_bytes = 10,
+        .max_rx_bytes = 19,     // Match ROM command, ROM, read scratchpad command and scratchpad in one transaction
     };
 
     // Initialize the 1-Wire sensor bus with RMT.
@@ -119,23 +150,28 @@ esp_err_t initialize_onewire_sensor() {
 
 
 /**
- * @brief Reset the temperature sensor by reinitializing the 1-Wire sensor bus.
+ * @brief Reset the temperature sensor by recovering the 1-Wire sensor bus in place.
+ *
+ * The bus keeps its RMT channels; the recovery escalates from a bus reset to a
+ * re-initialization of the channels and checks that the sensor is found again.
  */
 void reset_temperature_sensor() {
-    // Reset the temperature sensor by reinitializing the 1-Wire sensor bus.
-    ESP_ERROR_CHECK(initialize_onewire_sensor());
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    if (onewire_bus_recover(sensor.handle, sensor.device_rom_id) != ESP_OK) {
+        ESP_LOGW(TAG, "Temperature sensor not found after bus recovery");
+    }
     sensor_failures = 0;
 }
 
 /**
- * @brief Read the temperature from the sensor.
+ * @brief Start a temperature conversion on the sensor.
  * @return ESP_OK on success, else an error code.
  */
-int read_temperature_sensor() {
+esp_err_t start_temperature_conversion() {
     if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
 
     esp_err_t err;
-    float temperature;
 
     // Set the resolution of the DS18B20 sensor.
     err = ds18b20_set_resolution(sensor.handle, NULL, DS18B20_RESOLUTION_12B);
@@ -149,8 +185,23 @@ int read_temperature_sensor() {
         goto error;
     }
 
-    // Wait for the DS18B20 sensor to complete the conversion.
-    vTaskDelay(pdMS_TO_TICKS(800));
+    return ESP_OK;
+
+error:
+    handle_sensor_error(err);
+    return err;
+}
+
+/**
+ * @brief Read the temperature from the sensor, once the conversion is done.
+ * @param results Result set that receives the reading.
+ * @return ESP_OK on success, else an error code.
+ */
+int read_temperature_sensor(AcquisitionResults_t *results) {
+    if (DEBUG) ESP_LOGI(TAG, "on %s", __func__);
+
+    esp_err_t err;
+    float temperature;
 
     // Read the temperature from the DS18B20 sensor.
     err = ds18b20_get_temperature(sensor.handle, sensor.device_rom_id, &temperature);
@@ -163,28 +214,38 @@ int read_temperature_sensor() {
     // Set the temperature parameter in the ComposterParameters.
     ComposterParameters_SetTemperature(&composterParameters, temperature);
 
-    // Check for unstable temperature conditions.
-    if (temperature > MAX_TEMPERATURE) {
-        ComposterParameters_SetTemperatureState(&composterParameters, false);
-        esp_event_post(TEMPERATURE_EVENT, TEMPERATURE_EVENT_UNSTABLE, NULL, 0, portMAX_DELAY);
-        xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(UNSTABLE_HUMIDITY_TIMER_MS), portMAX_DELAY);
-    } else {
-        ComposterParameters_SetTemperatureState(&composterParameters, true);
-        esp_event_post(TEMPERATURE_EVENT, TEMPERATURE_EVENT_STABLE, NULL, 0, portMAX_DELAY);
-        xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(STABLE_HUMIDITY_TIMER_MS), portMAX_DELAY);
-    }
+    // Check for unstable temperature conditions and add the reading to the cycle results.
+    bool stable = temperature <= MAX_TEMPERATURE;
+    ComposterParameters_SetTemperatureState(&composterParameters, stable);
+    results->temperature = temperature;
+    results->isTemperatureStable = stable;
+    results->readings |= ACQUISITION_READING_TEMPERATURE;
+
+    // Choose when to read next from the trend of the readings
+    int64_t now = esp_timer_get_time();
+    uint32_t elapsed_ms = last_sample_us ? (uint32_t) ((now - last_sample_us) / 1000) : 0;
+    last_sample_us = now;
+    uint32_t period = AdaptiveSampler_Update(&sensor.sampler, temperature, elapsed_ms);
+    TimerWheel_ChangePeriod(&sensor.stableTimer, period);
+    if (DEBUG) ESP_LOGI(TAG, "Next reading in %lu s", period / 1000);
 
     return ESP_OK;
 
 error:
-    // Handle errors and reset the sensor on multiple failures.
+    handle_sensor_error(err);
+    return err;
+}
+
+/**
+ * @brief Handle errors and reset the sensor on multiple failures.
+ * @param err Error returned by the sensor.
+ */
+static void handle_sensor_error(esp_err_t err) {
     if (err != ESP_OK) {
         sensor_failures++;
         if (sensor_failures >= 5) {
             reset_temperature_sensor();
-            xTimerChangePeriod(sensor.stableTimer, pdMS_TO_TICKS(ERROR_READ_SENSOR_TIMER_MS), portMAX_DELAY);
+            TimerWheel_ChangePeriod(&sensor.stableTimer, ERROR_READ_SENSOR_TIMER_MS);
         }
     }
-    
-    return err;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "alloc_count.h"
+
+size_t alloc_calls;
+size_t alloc_bytes;
+long alloc_live_bytes;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+char* __real_strdup(const char* str);
+
+void* __wrap_malloc(size_t size) {
+    void* ptr = __real_malloc(size);
+    alloc_calls++;
+    alloc_bytes += size;
+    alloc_live_bytes += malloc_usable_size(ptr);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* ptr = __real_calloc(count, size);
+    alloc_calls++;
+    alloc_bytes += count * size;
+    alloc_live_bytes += malloc_usable_size(ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    alloc_live_bytes -= malloc_usable_size(ptr);
+    ptr = __real_realloc(ptr, size);
+    alloc_calls++;
+    alloc_bytes += size;
+    alloc_live_bytes += malloc_usable_size(ptr);
+    return ptr;
+}
+
+void __wrap_free(void* ptr) {
+    alloc_live_bytes -= malloc_usable_size(ptr);
+    __real_free(ptr);
+}
+
+// glibc allocates strdup's copy internally, out of reach of the malloc wrapper
+char* __wrap_strdup(const char* str) {
+    char* copy = __real_strdup(str);
+    alloc_calls++;
+    alloc_bytes += strlen(str) + 1;
+    alloc_live_bytes += malloc_usable_size(copy);
+    return copy;
+}
@@ -0,0 +1,19 @@
+#ifndef ALLOC_COUNT_H_
+#define ALLOC_COUNT_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Heap calls made by objects linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free,--wrap=strdup
+extern size_t alloc_calls;
+extern size_t alloc_bytes;
+extern long alloc_live_bytes;           // Usable size of the blocks not freed yet
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
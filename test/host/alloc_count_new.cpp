@@ -0,0 +1,20 @@
+#include <stdlib.h>
+#include <new>
+
+// Route operator new through the wrapped malloc so C++ allocations are counted too
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
@@ -0,0 +1,109 @@
+// Samples per day and threshold detection delay of the humidity sensor, fixed
+// schedule against AdaptiveSampler, over a synthetic 7-day humidity trace. The
+// sampler settings are those of humidity_sensor.c.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sensors/adaptive_sampler.h"
+
+#define DAYS 7
+#define THRESHOLD 60.0f             // MAX_HUMIDITY, %RH
+#define STABLE_FIXED_MS 600000      // STABLE_HUMIDITY_TIMER_MS
+#define UNSTABLE_FIXED_MS 120000    // UNSTABLE_HUMIDITY_TIMER_MS
+
+static const AdaptiveSamplerConfig_t config = {
+    .minPeriodMs = 60000,
+    .maxPeriodMs = 1800000,
+    .unstableMaxMs = UNSTABLE_FIXED_MS,
+    .threshold = THRESHOLD,
+    .margin = 5.0f,
+    .flatRate = 0.1f,
+    .stableFixedMs = STABLE_FIXED_MS,
+    .unstableFixedMs = UNSTABLE_FIXED_MS,
+};
+
+static uint32_t noise_state;
+
+// Uniform noise in [-0.1, 0.1) %RH, from a fixed LCG so every libc gives the same trace
+static double noise(void) {
+    noise_state = noise_state * 1103515245u + 12345u;
+    return ((noise_state >> 16) % 100 / 100.0 - 0.5) * 0.2;
+}
+
+// Humidity at second t: flat at 52 %RH, and every other day a 2 h rise to 65 %RH
+// followed by a 2 h fall back once mixing starts, crossing 60 %RH both ways
+static float humidity(uint32_t t) {
+    uint32_t d = t % (2 * 86400);
+    double base = 52;
+
+    if (d > 30000 && d < 37200) {
+        base = 52 + (d - 30000) / 7200.0 * 13;
+    } else if (d >= 37200 && d < 44400) {
+        base = 65 - (d - 37200) / 7200.0 * 13;
+    }
+    return base + noise();
+}
+
+static void run(const char *name, bool adaptive) {
+    AdaptiveSampler sampler;
+    AdaptiveSampler_Init(&sampler, &config);
+    noise_state = 1;
+
+    uint32_t next = 0, last = 0, period = config.minPeriodMs;
+    uint32_t samples = 0, crossings = 0;
+    uint64_t delay_sum = 0;
+    int64_t crossed_at = -1;    // Second the trace went over the threshold unnoticed
+    bool over = false;          // Over the threshold at the last reading
+
+    for (uint32_t t = 0; t < DAYS * 86400; t++) {
+        float value = humidity(t);
+        if (!over) {
+            if (value > THRESHOLD && crossed_at < 0) {
+                crossed_at = t;
+            } else if (value <= THRESHOLD) {
+                crossed_at = -1;
+            }
+        }
+
+        if (t < next) {
+            continue;
+        }
+
+        samples++;
+        bool now_over = value > THRESHOLD;
+        if (now_over && !over && crossed_at >= 0) {
+            delay_sum += t - crossed_at;
+            crossings++;
+            crossed_at = -1;
+        }
+        over = now_over;
+
+        if (adaptive) {
+            period = AdaptiveSampler_Update(&sampler, value, (t - last) * 1000);
+        } else {
+            period = over ? UNSTABLE_FIXED_MS : STABLE_FIXED_MS;
+        }
+        last = t;
+        next = t + period / 1000;
+    }
+
+    printf("  %-9s %6.1f samples/day   %6.1f s mean detection delay over %u crossings\n",
+           name, samples / (double) DAYS, crossings ? delay_sum / (double) crossings : 0.0, crossings);
+
+    if (adaptive) {
+        AdaptiveSamplerStats_t stats;
+        AdaptiveSampler_GetStats(&sampler, &stats);
+        printf("  %-9s %6u samples/day, %u for the fixed schedule (AdaptiveSampler_GetStats)\n",
+               "", stats.samplesPerDay, stats.fixedSamplesPerDay);
+    }
+}
+
+int main(void) {
+    printf("Humidity sensor, %d-day trace crossing %.0f %%RH every other day\n", DAYS, THRESHOLD);
+    run("fixed", false);
+    run("adaptive", true);
+    return 0;
+}
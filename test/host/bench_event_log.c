@@ -0,0 +1,135 @@
+// Cost of a log call in an event handler, inline formatting against the
+// deferred ring of event_log.c. Inline is what ESP_LOGI does up to the UART:
+// format the line and hand it to stdio, here a /dev/null stream. Deferred is
+// EVENT_LOG; the formatting it moves to the drain task is timed separately.
+// Host times only: cycles on the ESP32, the UART and the event loop latency
+// are not measured here, see EVENT_LOG_BENCHMARK in event_log.c for the last.
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common/event_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define ROUNDS 2000
+#define BURST 32                    // Records between drains, half the ring
+#define UART_BAUD 115200            // CONFIG_ESP_CONSOLE_UART_BAUDRATE, 10 bits per byte
+
+// esp_log's LOG_FORMAT without colors, around the EVENT_LOG_EVENT_RECEIVED message
+#define INLINE_FORMAT "I (%lu) %s: Event received: %s, %ld\n"
+
+static const char *TAG = "AC_Communicator";
+
+// Arguments are 32-bit words, so the event base must sit below 4 GB; the
+// benchmark is linked without PIE for that
+static const char event_base[] = "WIFI_EVENT_INTERNAL";
+
+static TaskFunction_t drain_code;
+static jmp_buf drain_idle;
+static uint32_t wakes;
+
+// The drain task only runs when the benchmark drains the ring, and leaves
+// through ulTaskNotifyTake once it is empty
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, TaskHandle_t *handle) {
+    drain_code = code;
+    *handle = (TaskHandle_t) &drain_code;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    wakes++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+    wakes++;
+}
+
+BaseType_t xPortInIsrContext(void) {
+    return pdFALSE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    longjmp(drain_idle, 1);
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t esp_log_timestamp(void) {
+    return (uint32_t) (now_ns() / 1000000);
+}
+
+static void drain(void) {
+    if (setjmp(drain_idle) == 0) {
+        drain_code(NULL);
+        // Never reached; keeps the call from becoming a tail call that leaves this frame
+        abort();
+    }
+}
+
+int main(void) {
+    FILE *console = fopen("/dev/null", "w");
+    int64_t inline_ns = 0, deferred_ns = 0, drain_ns = 0;
+    int failures = 0;
+
+    if (console == NULL || (uintptr_t) event_base > UINT32_MAX) {
+        printf("FAIL: no /dev/null, or event base above 4 GB\n");
+        return EXIT_FAILURE;
+    }
+
+    EventLog_Start();
+    drain();
+
+    for (int round = 0; round < ROUNDS; round++) {
+        int64_t start = now_ns();
+        for (int32_t i = 0; i < BURST; i++) {
+            fprintf(console, INLINE_FORMAT, (unsigned long) esp_log_timestamp(), TAG, event_base, (long) i);
+        }
+        inline_ns += now_ns() - start;
+
+        start = now_ns();
+        for (int32_t i = 0; i < BURST; i++) {
+            EVENT_LOG(TAG, EVENT_LOG_EVENT_RECEIVED, event_base, i);
+        }
+        deferred_ns += now_ns() - start;
+
+        start = now_ns();
+        drain();
+        drain_ns += now_ns() - start;
+    }
+    fclose(console);
+
+    EventLogStats_t stats;
+    EventLog_GetStats(&stats);
+    if (stats.written != ROUNDS * BURST || stats.printed != stats.written || stats.dropped != 0) {
+        printf("FAIL: %lu written, %lu printed, %lu dropped\n",
+               (unsigned long) stats.written, (unsigned long) stats.printed, (unsigned long) stats.dropped);
+        failures++;
+    }
+
+    char line[128];
+    int line_len = snprintf(line, sizeof(line), INLINE_FORMAT, 1234567ul, TAG, event_base, 1l);
+    int calls = ROUNDS * BURST;
+
+    printf("per log call, bursts of %d:\n", BURST);
+    printf("  inline ESP_LOGI      %6.0f ns in the handler\n", (double) inline_ns / calls);
+    printf("  deferred EVENT_LOG   %6.0f ns in the handler, %lu drain wake-ups\n", (double) deferred_ns / calls, (unsigned long) wakes);
+    printf("  drain task           %6.0f ns per record, off the handler\n", (double) drain_ns / calls);
+    printf("  UART, not timed      %6.0f us for the %d-byte inline line at %d baud\n",
+           line_len * 10 * 1e6 / UART_BAUD, line_len, UART_BAUD);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
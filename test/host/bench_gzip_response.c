@@ -0,0 +1,127 @@
+// Compression ratio and inflate time of gzip responses, for RTDB documents the
+// firmware reads: the empty command queue, a full batch of commands, one
+// composter, and the composters node of a 20-unit fleet, about as large as fits
+// in the response buffer. Compressed with zlib at level 6 as a stand-in for
+// what the Google front end sends, and inflated with zlib on the host; the
+// device inflates with the ROM's tinfl, whose time firebase.cpp logs per
+// response.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#define ITERATIONS 20000
+#define BUFFER_SIZE 4096                // HTTP_RECV_BUFFER_SIZE
+
+// Accept-Encoding: gzip\r\n, and " (gzip)" appended to the User-Agent
+#define REQUEST_OVERHEAD (23 + 7)
+
+static char document[BUFFER_SIZE];
+static char commands[BUFFER_SIZE];
+static char fleet[BUFFER_SIZE];
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int composter_json(char *out, size_t size, unsigned id) {
+    return snprintf(out, size, "{\"complete\":%u,\"days\":%u,\"humidity\":%u,\"temperature\":%u,"
+                    "\"mezcladora\":%s,\"trituradora\":false,\"fan\":%s,\"command_ack\":%u}",
+                    id * 7 % 100, id % 40, 50 + id % 15, 45 + id % 20,
+                    id % 3 ? "false" : "true", id % 2 ? "true" : "false", 100 + id);
+}
+
+static void build_payloads(void) {
+    static const char *targets[] = {"mezcladora", "trituradora", "fan"};
+    int len;
+
+    composter_json(document, sizeof(document), 2);
+
+    len = snprintf(commands, sizeof(commands), "{");
+    for (unsigned i = 0; i < 8; i++) {
+        len += snprintf(commands + len, sizeof(commands) - len, "%s\"-O%02uaB3kLm9QxZ7pWvT\":{\"seq\":%u,\"target\":\"%s\"}",
+                        i ? "," : "", i, 41 + i, targets[i % 3]);
+    }
+    snprintf(commands + len, sizeof(commands) - len, "}");
+
+    len = snprintf(fleet, sizeof(fleet), "{");
+    for (unsigned i = 0; i < 20; i++) {
+        len += snprintf(fleet + len, sizeof(fleet) - len, "%s\"3c71bf4a%04x\":", i ? "," : "", 0x2d10 + i);
+        len += composter_json(fleet + len, sizeof(fleet) - len, i);
+    }
+    snprintf(fleet + len, sizeof(fleet) - len, "}");
+}
+
+static size_t gzip(const char *in, unsigned char *out, size_t out_size) {
+    z_stream stream = {0};
+    deflateInit2(&stream, 6, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+    stream.next_in = (unsigned char *) in;
+    stream.avail_in = strlen(in);
+    stream.next_out = out;
+    stream.avail_out = out_size;
+    deflate(&stream, Z_FINISH);
+    size_t len = stream.total_out;
+    deflateEnd(&stream);
+    return len;
+}
+
+static size_t gunzip(z_stream *stream, const unsigned char *in, size_t len, char *out) {
+    inflateReset(stream);
+    stream->next_in = (unsigned char *) in;
+    stream->avail_in = len;
+    stream->next_out = (unsigned char *) out;
+    stream->avail_out = BUFFER_SIZE;
+    inflate(stream, Z_FINISH);
+    return stream->total_out;
+}
+
+int main(void) {
+    const struct {
+        const char *name;
+        const char *body;
+    } payloads[] = {
+        {"empty queue", "null"},
+        {"one composter", document},
+        {"8 commands", commands},
+        {"20 composters", fleet},
+    };
+    static unsigned char compressed[BUFFER_SIZE];
+    static char inflated[BUFFER_SIZE];
+    z_stream stream = {0};
+    int failures = 0;
+
+    build_payloads();
+    inflateInit2(&stream, MAX_WBITS + 16);
+
+    printf("%-14s %6s %6s %7s %14s %11s\n", "response", "bytes", "gzip", "ratio", "saved on wire", "inflate ns");
+    for (size_t i = 0; i < sizeof(payloads) / sizeof(payloads[0]); i++) {
+        size_t raw = strlen(payloads[i].body);
+        size_t packed = gzip(payloads[i].body, compressed, sizeof(compressed));
+
+        size_t out = gunzip(&stream, compressed, packed, inflated);
+        if (out != raw || memcmp(inflated, payloads[i].body, raw) != 0) {
+            printf("FAIL: %s does not inflate back\n", payloads[i].name);
+            failures++;
+        }
+
+        int64_t start = now_ns();
+        for (int k = 0; k < ITERATIONS; k++) {
+            gunzip(&stream, compressed, packed, inflated);
+        }
+        int64_t inflate_ns = (now_ns() - start) / ITERATIONS;
+
+        // Content-Encoding: gzip\r\n comes back with every compressed response
+        long saved = (long) raw - (long) packed - 24 - REQUEST_OVERHEAD;
+        printf("%-14s %6zu %6zu %6.0f%% %14ld %11lld\n", payloads[i].name, raw, packed,
+               100.0 * packed / raw, saved, (long long) inflate_ns);
+    }
+
+    inflateEnd(&stream);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
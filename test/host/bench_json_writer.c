@@ -0,0 +1,129 @@
+// JsonWriter against building a cJSON tree and printing it, for the payloads
+// the communicator sends: the periodic sensor update and the default
+// composter document.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "alloc_count.h"
+#include "cJSON.h"
+#include "common/json_writer.h"
+
+#define ITERATIONS 100000
+
+static char payload_buffer[256];
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static size_t sensors_cjson(int i) {
+    cJSON *data_json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data_json, "temperature", 40 + i % 30);
+    cJSON_AddNumberToObject(data_json, "humidity", 50 + i % 40);
+    cJSON_AddNumberToObject(data_json, "complete", i % 2);
+    char *payload = cJSON_PrintUnformatted(data_json);
+    size_t length = strlen(payload);
+    cJSON_free(payload);
+    cJSON_Delete(data_json);
+    return length;
+}
+
+static size_t sensors_writer(int i) {
+    JsonWriter writer;
+    JsonWriter_Init(&writer, payload_buffer, sizeof(payload_buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddInt(&writer, "temperature", 40 + i % 30);
+    JsonWriter_AddInt(&writer, "humidity", 50 + i % 40);
+    JsonWriter_AddInt(&writer, "complete", i % 2);
+    JsonWriter_EndObject(&writer);
+    size_t length = 0;
+    JsonWriter_Finish(&writer, &length);
+    return length;
+}
+
+static size_t composter_cjson(int i) {
+    cJSON *data_json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(data_json, "complete", 0);
+    cJSON_AddNumberToObject(data_json, "days", i % 90);
+    cJSON_AddNumberToObject(data_json, "humidity", 0);
+    cJSON_AddNumberToObject(data_json, "temperature", 0);
+    cJSON_AddBoolToObject(data_json, "mixer", false);
+    cJSON_AddBoolToObject(data_json, "crusher", false);
+    cJSON_AddBoolToObject(data_json, "fan", false);
+    char *payload = cJSON_PrintUnformatted(data_json);
+    size_t length = strlen(payload);
+    cJSON_free(payload);
+    cJSON_Delete(data_json);
+    return length;
+}
+
+static size_t composter_writer(int i) {
+    JsonWriter writer;
+    JsonWriter_Init(&writer, payload_buffer, sizeof(payload_buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddInt(&writer, "complete", 0);
+    JsonWriter_AddInt(&writer, "days", i % 90);
+    JsonWriter_AddInt(&writer, "humidity", 0);
+    JsonWriter_AddInt(&writer, "temperature", 0);
+    JsonWriter_AddBool(&writer, "mixer", false);
+    JsonWriter_AddBool(&writer, "crusher", false);
+    JsonWriter_AddBool(&writer, "fan", false);
+    JsonWriter_EndObject(&writer);
+    size_t length = 0;
+    JsonWriter_Finish(&writer, &length);
+    return length;
+}
+
+static size_t run(const char *name, size_t (*build)(int)) {
+    size_t total = 0;
+
+    alloc_calls = 0;
+    alloc_bytes = 0;
+    int64_t start = now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        total += build(i);
+    }
+    int64_t elapsed = now_ns() - start;
+
+    printf("  %-22s %6.1f ns %6.2f allocations %7.1f bytes per payload\n", name,
+           (double)elapsed / ITERATIONS, (double)alloc_calls / ITERATIONS, (double)alloc_bytes / ITERATIONS);
+    return alloc_calls;
+}
+
+int main(void) {
+    int failures = 0;
+
+    // Both builders must produce the same documents
+    for (int i = 0; i < 100; i++) {
+        char expected[256];
+        cJSON *data_json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(data_json, "temperature", 40 + i % 30);
+        cJSON_AddNumberToObject(data_json, "humidity", 50 + i % 40);
+        cJSON_AddNumberToObject(data_json, "complete", i % 2);
+        char *payload = cJSON_PrintUnformatted(data_json);
+        snprintf(expected, sizeof(expected), "%s", payload);
+        cJSON_free(payload);
+        cJSON_Delete(data_json);
+
+        sensors_writer(i);
+        if (strcmp(expected, payload_buffer) != 0) {
+            printf("FAIL: %s != %s\n", payload_buffer, expected);
+            failures++;
+        }
+    }
+
+    printf("Sensor update, %d payloads of %zu bytes\n", ITERATIONS, sensors_writer(0));
+    run("cJSON + PrintUnformatted", sensors_cjson);
+    failures += run("JsonWriter", sensors_writer) != 0;
+
+    printf("Default composter document, %d payloads of %zu bytes\n", ITERATIONS, composter_writer(0));
+    run("cJSON + PrintUnformatted", composter_cjson);
+    failures += run("JsonWriter", composter_writer) != 0;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+// RMT transactions and bus time of the DS18B20 operations, against the RMT and
+// device model of fake_onewire.c. MAX_RX_BYTES is the max_rx_bytes
+// temperature_sensor.c gives the bus. The numbers before user-050 are in the
+// README.
+//
+//   bench_onewire [devices]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/ds18b20.h"
+#include "fake_onewire.h"
+
+#define MAX_RX_BYTES 19
+
+#define READINGS 100
+
+static int errors;
+
+static void report(const char *what, int count) {
+    printf("  %-20s %6.1f transactions (%5.1f with rx) %8.0f us bus time\n", what,
+           (double) fake_rmt_transactions / count, (double) fake_rmt_rx_transactions / count,
+           (double) fake_bus_time_us / count);
+}
+
+static void bench_search(onewire_bus_handle_t bus) {
+    onewire_rom_search_context_handler_t context;
+    uint8_t rom[8];
+    int found = 0;
+
+    fake_bus_reset_counters();
+    onewire_rom_search_context_create(bus, &context);
+    while (onewire_rom_search(context) == ESP_OK) {
+        onewire_rom_get_number(context, rom);
+        for (int i = 0; i < fake_bus_device_count; i++) {
+            found += memcmp(rom, fake_bus_devices[i].rom, 8) == 0;
+        }
+    }
+    onewire_rom_search_context_delete(context);
+
+    if (found != fake_bus_device_count) {
+        printf("FAIL: search found %d of %d devices\n", found, fake_bus_device_count);
+        errors++;
+    }
+    report("full search", 1);
+    report("  per device", fake_bus_device_count);
+}
+
+// What temperature_sensor.c does per reading: resolution, conversion, scratchpad
+static void bench_reading(onewire_bus_handle_t bus, const fake_device_t *device) {
+    float expected = (int16_t) (device->scratchpad[1] << 8 | device->scratchpad[0]) / 16.0f;
+    float temperature;
+
+    fake_bus_reset_counters();
+    for (int i = 0; i < READINGS; i++) {
+        errors += ds18b20_set_resolution(bus, device->rom, DS18B20_RESOLUTION_12B) != ESP_OK;
+        errors += ds18b20_trigger_temperature_conversion(bus, device->rom) != ESP_OK;
+        errors += ds18b20_get_temperature(bus, device->rom, &temperature) != ESP_OK;
+        if (temperature != expected) {
+            printf("FAIL: read %.4f C, expected %.4f C\n", temperature, expected);
+            errors++;
+            break;
+        }
+    }
+    report("sensor reading", READINGS);
+
+    fake_bus_reset_counters();
+    for (int i = 0; i < READINGS; i++) {
+        errors += ds18b20_get_temperature(bus, device->rom, &temperature) != ESP_OK;
+    }
+    report("  get_temperature", READINGS);
+
+    fake_bus_reset_counters();
+    for (int i = 0; i < READINGS; i++) {
+        errors += ds18b20_set_resolution(bus, device->rom, DS18B20_RESOLUTION_12B) != ESP_OK;
+    }
+    report("  set_resolution", READINGS);
+}
+
+int main(int argc, char **argv) {
+    int devices = argc > 1 ? atoi(argv[1]) : 1;
+    if (devices < 1 || devices > FAKE_BUS_DEVICES) {
+        printf("devices: 1 to %d\n", FAKE_BUS_DEVICES);
+        return 2;
+    }
+
+    // Random ROM numbers of the DS18B20 family, scratchpads reading 25.0625 C and up
+    srand(1);
+    for (int i = 0; i < devices; i++) {
+        uint8_t rom[7] = { 0x28 };
+        uint8_t scratchpad[8] = { 0x91 + i, 0x01, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10 };
+        for (int k = 1; k < 7; k++) {
+            rom[k] = rand();
+        }
+        fake_bus_add_device(rom, scratchpad);
+    }
+
+    onewire_rmt_config_t config = { .gpio_pin = 4, .max_rx_bytes = MAX_RX_BYTES };
+    onewire_bus_handle_t bus;
+    if (onewire_new_bus_rmt(&config, &bus) != ESP_OK) {
+        printf("FAIL: no 1-Wire bus\n");
+        return 1;
+    }
+
+    printf("%d device(s), max_rx_bytes %d\n", devices, MAX_RX_BYTES);
+    bench_search(bus);
+    bench_reading(bus, &fake_bus_devices[0]);
+    onewire_del_bus(bus);
+
+    return errors != 0;
+}
@@ -0,0 +1,621 @@
+// Firebase load of a fleet: N simulated composters, each running the request
+// schedule of communicator.c through its own RTDB object, against a stand-in
+// for the RTDB REST API in this file. Time is virtual, so a simulated day runs
+// in well under a second. Reports the request rate at the server, p50 and p99
+// latency as the devices see it, requests that hit the deadline, and bytes on
+// the wire per device per day.
+//
+//   bench_rtdb_load [workers] [service_us] [rtt_ms]
+//
+// The stand-in serves requests on `workers` parallel workers taking
+// `service_us` each, behind a network round trip of `rtt_ms`. The defaults
+// (8, 1000, 50) are a guess at a small backend, not measured from Firebase.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "cJSON.h"
+#include "config/firebase_config.h"
+#include "esp_timer.h"
+#include "firebase.hpp"
+#include "rtdb.h"
+
+#define DAY_US (86400 * 1000000LL)
+#define NEVER INT64_MAX
+
+// communicator.c
+#define ROUTINE_US (6 * 3600 * 1000000LL)       // RUTINE_COMMUNICATOR_TIMER_MS
+#define POLL_US 1000000LL                       // READING_POLL_TIMER_MS
+#define RETRY_US 30000000LL                     // RETRY_TIMER_MS
+#define REQUEST_DEADLINE_MS 4000
+#define COMMAND_BATCH_MAX 8
+
+// rtdb_wrapper.cpp: the ID token lives an hour and is refreshed 300 s early
+#define TOKEN_REFRESH_US ((3600 - AUTH_TOKEN_REFRESH_MARGIN_S) * 1000000LL)
+#define TOKEN_RETRY_US 30000000LL               // TOKEN_REFRESH_RETRY_MS
+
+// Assumed use: commands sent from the app, and actuator changes made by the
+// control rules, per composter and day
+#define REMOTE_COMMANDS_PER_DAY 8
+#define ACTUATOR_CHANGES_PER_DAY 24
+
+// Token refreshes go to securetoken.googleapis.com, not to the stand-in
+#define TOKEN_SERVICE_US 30000
+
+// Wire overhead counted on top of each request and response: an AES-GCM TLS
+// record header, explicit nonce and tag. The connection is kept alive, so no
+// handshakes are counted.
+#define TLS_RECORD_OVERHEAD 29
+
+// Response headers as RTDB sends them, less Content-Length and ETag
+static const char response_headers[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Server: nginx\r\n"
+    "Date: Sun, 18 Oct 2026 10:00:00 GMT\r\n"
+    "Content-Type: application/json; charset=utf-8\r\n"
+    "Connection: keep-alive\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Strict-Transport-Security: max-age=31556926; includeSubDomains; preload\r\n";
+
+enum {
+    TRAFFIC_POLL,
+    TRAFFIC_ACK,
+    TRAFFIC_STATE,
+    TRAFFIC_TELEMETRY,
+    TRAFFIC_TOKEN,
+    TRAFFIC_MAX,
+};
+
+static const char* traffic_names[TRAFFIC_MAX] = {"command poll", "command ack", "actuator state", "sensor values", "token refresh"};
+
+enum {
+    NOTIFY_POLL = 1,
+    NOTIFY_ROUTINE = 2,
+    NOTIFY_ACTUATOR = 4,
+    NOTIFY_RETRY = 8,
+};
+
+struct composter_t {
+    RTDB* db;
+    char path[sizeof(COMPOSTERS_PATH) + 12];
+    char commands_path[sizeof(COMPOSTERS_PATH) + 12 + sizeof("/commands")];
+
+    // communicator_task
+    bool degraded;
+    uint32_t pending;
+    uint32_t actuators;                 // Actuator bits, and as last written
+    uint32_t reported;
+    uint32_t last_seq;
+    int64_t next_poll;
+    int64_t next_routine;
+    int64_t next_actuator;
+    int64_t next_retry;
+    int64_t next_token;
+    int64_t busy_until;
+    int64_t wake;                       // Time of its live entry in the event queue
+
+    // Its node on the stand-in
+    int64_t next_command;
+    uint32_t issued_seq;
+    uint32_t acked_seq;
+    uint32_t commands_version;
+    std::string commands;
+    std::string headers;                // Set on the client, as "name: value\r\n" lines
+};
+
+struct run_t {
+    uint64_t requests;
+    uint64_t timeouts;
+    uint64_t bytes[TRAFFIC_MAX];
+    uint64_t executed;
+    std::vector<float> latency_ms;
+};
+
+static int64_t now_us;
+static uint32_t rng_state = 1;
+
+static int workers = 8;
+static int64_t service_us = 1000;
+static int64_t rtt_us = 50000;
+
+// Times at which each worker of the stand-in is free again
+static std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> worker_free;
+
+// What the requests go to: the composter whose call is running, the window
+// being measured and the kind of traffic
+static composter_t* current;
+static run_t* run;
+static int64_t window_us;
+static int traffic;
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+// Fixed xorshift so every libc gives the same schedule
+static double uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (rng_state >> 8) / 16777216.0;
+}
+
+static int64_t exponential_us(double mean_us) {
+    return (int64_t) (-mean_us * log(1.0 - uniform()));
+}
+
+// REST stand-in
+
+// One request through the workers; returns when its response is back at the
+// device, or NEVER if that is past the timeout
+static int64_t serve(int64_t sent_us, int64_t timeout_us) {
+    int64_t start = std::max(sent_us + rtt_us / 2, worker_free.top());
+    worker_free.pop();
+    worker_free.push(start + service_us);
+    int64_t done = start + service_us + rtt_us / 2;
+    return done - sent_us > timeout_us ? NEVER : done;
+}
+
+static void set_response(FirebaseApp* app, const char* body, const char* etag) {
+    snprintf(app->local_response_buffer, HTTP_RECV_BUFFER_SIZE, "%s", body);
+    snprintf(app->response_etag, ETAG_BUFFER_SIZE, "%s", etag);
+}
+
+// A queued command appears at its time, and is gone once acknowledged
+static void answer_commands(FirebaseApp* app, composter_t* c) {
+    if (c->commands.empty() && now_us >= c->next_command) {
+        static const char* targets[] = {"mezcladora", "trituradora", "fan"};
+        char entry[96];
+        snprintf(entry, sizeof(entry), "{\"-O%018u\":{\"seq\":%u,\"target\":\"%s\"}}",
+                 c->issued_seq + 1, c->issued_seq + 1, targets[c->issued_seq % 3]);
+        c->commands = entry;
+        c->issued_seq++;
+        c->commands_version++;
+        c->next_command = now_us + exponential_us((double) DAY_US / REMOTE_COMMANDS_PER_DAY);
+    }
+
+    char etag[ETAG_BUFFER_SIZE];
+    snprintf(etag, sizeof(etag), "%027u=", c->commands_version);
+    set_response(app, c->commands.empty() ? "null" : c->commands.c_str(), etag);
+}
+
+// The multi-location update of read_remote_commands
+static void answer_update(FirebaseApp* app, composter_t* c, const char* body) {
+    const char* ack = strstr(body, "command_ack\":");
+    if (ack != NULL) {
+        c->acked_seq = strtoul(ack + strlen("command_ack\":"), NULL, 10);
+    }
+    if (!c->commands.empty() && strstr(body, "/commands/") != NULL) {
+        c->commands.clear();
+        c->commands_version++;
+    }
+    set_response(app, body, "");
+}
+
+static size_t request_bytes(const char* url, esp_http_client_method_t method, const char* body, bool gzip) {
+    static const char* methods[] = {"GET", "POST", "PUT", "PATCH", "DELETE"};
+    const char* host = strstr(url, "://") + 3;
+    const char* target = strchr(host, '/');
+    size_t body_len = body ? strlen(body) : 0;
+    char line[64];
+
+    size_t bytes = strlen(methods[method]) + 1 + strlen(target) + strlen(" HTTP/1.1\r\n");
+    bytes += strlen("Host: \r\n") + (target - host);
+    bytes += strlen("User-Agent: \r\n") + strlen(gzip ? HTTP_USER_AGENT_GZIP : HTTP_USER_AGENT);
+    bytes += strlen("content-type: application/json\r\nX-Firebase-ETag: true\r\n");
+    if (gzip) {
+        bytes += strlen("Accept-Encoding: gzip\r\n");
+    }
+    bytes += current->headers.size();
+    if (body_len) {
+        bytes += snprintf(line, sizeof(line), "Content-Length: %zu\r\n", body_len) + body_len;
+    }
+    return bytes + 2 + TLS_RECORD_OVERHEAD;
+}
+
+static size_t response_bytes(const char* body, const char* etag) {
+    char line[64];
+    size_t bytes = strlen(response_headers) + snprintf(line, sizeof(line), "Content-Length: %zu\r\n", strlen(body));
+    if (etag[0]) {
+        bytes += strlen("ETag: \r\n") + strlen(etag);
+    }
+    return bytes + 2 + strlen(body) + TLS_RECORD_OVERHEAD;
+}
+
+static void record(int64_t sent_us, int64_t done_us, size_t bytes) {
+    if (sent_us >= window_us) {
+        return;
+    }
+    run->requests++;
+    run->bytes[traffic] += bytes;
+    run->latency_ms.push_back((done_us - sent_us) / 1000.0f);
+}
+
+FirebaseApp::FirebaseApp(const char* api_key) {
+    local_response_buffer = (char *)calloc(1, HTTP_RECV_BUFFER_SIZE);
+    auth_query = (char *)calloc(1, AUTH_QUERY_BUFFER_SIZE);
+
+    // A token as long as a real ID token (~1 KB JWT)
+    int len = snprintf(auth_query, AUTH_QUERY_BUFFER_SIZE, AUTH_QUERY_PREFIX);
+    for (; len < 1000; len++) {
+        auth_query[len] = 'a' + len % 26;
+    }
+    auth_query[len] = '\0';
+    auth_query_len = len;
+    response_etag[0] = '\0';
+}
+
+FirebaseApp::~FirebaseApp() {
+    free(local_response_buffer);
+    free(auth_query);
+}
+
+http_ret_t FirebaseApp::performRequest(const char* url, esp_http_client_method_t method, const char* post_field) {
+    response_etag[0] = '\0';
+
+    int64_t timeout_us = HTTP_DEFAULT_TIMEOUT_MS * 1000LL;
+    if (request_deadline_us != 0) {
+        if (request_deadline_us <= now_us) {
+            return {ESP_ERR_TIMEOUT, 0};
+        }
+        timeout_us = std::min(timeout_us, request_deadline_us - now_us);
+    }
+
+    int64_t sent_us = now_us;
+    size_t bytes = request_bytes(url, method, post_field, accept_gzip);
+    int64_t done_us = serve(sent_us, timeout_us);
+    if (done_us == NEVER) {
+        now_us += timeout_us;
+        record(sent_us, now_us, bytes);
+        if (sent_us < window_us) {
+            run->timeouts++;
+        }
+        return {ESP_ERR_TIMEOUT, 0};
+    }
+    now_us = done_us;
+
+    if (method == HTTP_METHOD_GET) {
+        answer_commands(this, current);
+    } else if (method == HTTP_METHOD_PATCH && strstr(url, current->path) == NULL) {
+        answer_update(this, current, post_field);
+    } else {
+        set_response(this, post_field ? post_field : "null", "");
+    }
+    record(sent_us, done_us, bytes + response_bytes(local_response_buffer, response_etag));
+
+    return {ESP_OK, 200};
+}
+
+esp_err_t FirebaseApp::setHeader(const char* header, const char* value) {
+    current->headers.append(header).append(": ").append(value).append("\r\n");
+    return ESP_OK;
+}
+
+esp_err_t FirebaseApp::deleteHeader(const char* header) {
+    size_t at = current->headers.find(std::string(header) + ": ");
+    if (at != std::string::npos) {
+        current->headers.erase(at, current->headers.find("\r\n", at) + 2 - at);
+    }
+    return ESP_OK;
+}
+
+esp_err_t FirebaseApp::setAcceptGzip(bool enable) {
+    accept_gzip = enable;
+    return ESP_OK;
+}
+
+void FirebaseApp::clearHTTPBuffer(void) {
+    local_response_buffer[0] = '\0';
+    response_etag[0] = '\0';
+}
+
+const char* FirebaseApp::getAuthQuery(size_t* len) {
+    *len = auth_query_len;
+    return auth_query;
+}
+
+// Kept fresh by the composter's own refresh schedule
+bool FirebaseApp::isAuthTokenExpiring(void) {
+    return false;
+}
+
+// The refresh_token grant of getAuthToken, answered with a new ID and refresh token
+esp_err_t FirebaseApp::refreshAuthToken(void) {
+    std::string token(260, 'r');
+    std::string id_token(auth_query_len - strlen(AUTH_QUERY_PREFIX), 'i');
+    std::string url = std::string("https://" FIREBASE_SECURETOKEN_HOST "/v1/token?key=") + API_KEY;
+    std::string body = "{\"grant_type\":\"refresh_token\",\"refresh_token\":\"" + token + "\"}";
+    std::string answer = "{\"access_token\":\"" + id_token + "\",\"expires_in\":\"3600\",\"token_type\":\"Bearer\","
+                         "\"refresh_token\":\"" + token + "\",\"id_token\":\"" + id_token + "\","
+                         "\"user_id\":\"tPWMmOU5WLVTvzT0wRdj3AXYlU83\",\"project_id\":\"870412301736\"}";
+
+    int64_t sent_us = now_us;
+    now_us += rtt_us + TOKEN_SERVICE_US;
+    record(sent_us, now_us, request_bytes(url.c_str(), HTTP_METHOD_POST, body.c_str(), false) + response_bytes(answer.c_str(), ""));
+    return ESP_OK;
+}
+
+void FirebaseApp::beginCall(int64_t deadline_us) {
+    request_deadline_us = deadline_us;
+}
+
+void FirebaseApp::endCall(void) {
+    request_deadline_us = 0;
+}
+
+// Composters
+
+// read_remote_commands: run what is new, then remove it and acknowledge
+static esp_err_t read_remote_commands(composter_t* c) {
+    cJSON* commands_json = c->db->getData(c->commands_path);
+    if (commands_json == NULL) {
+        return ESP_FAIL;
+    }
+
+    char paths[COMMAND_BATCH_MAX + 1][96];
+    rtdb_update_t updates[COMMAND_BATCH_MAX + 1];
+    char ack_value[11];
+    size_t count = 0;
+    cJSON* command_json;
+
+    cJSON_ArrayForEach(command_json, commands_json) {
+        if (count == COMMAND_BATCH_MAX) {
+            break;
+        }
+        uint32_t seq = (uint32_t) cJSON_GetObjectItem(command_json, "seq")->valuedouble;
+        if (seq > c->last_seq) {
+            c->last_seq = seq;
+            c->actuators |= 1u << (seq % 3);
+            c->pending |= NOTIFY_ACTUATOR;
+            if (now_us < window_us) {
+                run->executed++;
+            }
+        }
+        snprintf(paths[count], sizeof(paths[count]), "%s/%s", c->commands_path, command_json->string);
+        updates[count].path = paths[count];
+        updates[count].json_value = "null";
+        count++;
+    }
+    cJSON_Delete(commands_json);
+
+    if (count == 0) {
+        return ESP_OK;
+    }
+
+    snprintf(paths[count], sizeof(paths[count]), "%s/command_ack", c->path);
+    snprintf(ack_value, sizeof(ack_value), "%u", c->last_seq);
+    updates[count].path = paths[count];
+    updates[count].json_value = ack_value;
+
+    traffic = TRAFFIC_ACK;
+    return c->db->updateMulti(updates, count + 1);
+}
+
+static esp_err_t write_actuator_changes(composter_t* c) {
+    static const char* fields[] = {"mezcladora", "trituradora", "fan"};
+    char payload[64];
+    int len = snprintf(payload, sizeof(payload), "{");
+
+    for (int i = 0; i < 3; i++) {
+        if ((c->actuators ^ c->reported) & (1u << i)) {
+            len += snprintf(payload + len, sizeof(payload) - len, "%s\"%s\":%s", len > 1 ? "," : "",
+                            fields[i], c->actuators & (1u << i) ? "true" : "false");
+        }
+    }
+    snprintf(payload + len, sizeof(payload) - len, "}");
+
+    return c->db->patchData(c->path, payload);
+}
+
+// One wake of communicator_task, plus the token refresh task if it is due
+static void composter_wake(FirebaseApp* app, composter_t* c, int64_t t) {
+    now_us = std::max(t, c->busy_until);
+
+    if (t >= c->next_token) {
+        traffic = TRAFFIC_TOKEN;
+        app->beginCall(0);
+        c->next_token = app->refreshAuthToken() == ESP_OK ? now_us + TOKEN_REFRESH_US : now_us + TOKEN_RETRY_US;
+        app->endCall();
+    }
+
+    // Timers that fired while the task was busy are merged into one wake
+    if (t >= c->next_poll) {
+        c->pending |= NOTIFY_POLL;
+        c->next_poll += ((t - c->next_poll) / POLL_US + 1) * POLL_US;
+    }
+    if (t >= c->next_routine) {
+        c->pending |= NOTIFY_ROUTINE;
+        c->next_routine += ((t - c->next_routine) / ROUTINE_US + 1) * ROUTINE_US;
+    }
+    if (t >= c->next_actuator) {
+        c->actuators ^= 1u << (int) (uniform() * 3);
+        c->pending |= NOTIFY_ACTUATOR;
+        c->next_actuator = t + exponential_us((double) DAY_US / ACTUATOR_CHANGES_PER_DAY);
+    }
+    if (t >= c->next_retry) {
+        c->pending |= NOTIFY_RETRY;
+        c->next_retry = NEVER;
+    }
+
+    if (c->degraded) {
+        if (!(c->pending & NOTIFY_RETRY)) {
+            c->busy_until = now_us;
+            return;
+        }
+        c->pending |= NOTIFY_POLL;
+    }
+    c->pending &= ~NOTIFY_RETRY;
+
+    // Each request is one call, bounded by the communicator's deadline
+    esp_err_t err = ESP_OK;
+    if (c->pending & NOTIFY_ACTUATOR) {
+        if (c->actuators == c->reported) {
+            c->pending &= ~NOTIFY_ACTUATOR;
+        } else {
+            traffic = TRAFFIC_STATE;
+            app->beginCall(now_us + REQUEST_DEADLINE_MS * 1000LL);
+            err = write_actuator_changes(c);
+            app->endCall();
+            if (err == ESP_OK) {
+                c->reported = c->actuators;
+                c->pending &= ~NOTIFY_ACTUATOR;
+            }
+        }
+    }
+    if (err == ESP_OK && (c->pending & NOTIFY_POLL)) {
+        traffic = TRAFFIC_POLL;
+        app->beginCall(now_us + REQUEST_DEADLINE_MS * 1000LL);
+        err = read_remote_commands(c);
+        app->endCall();
+        if (err == ESP_OK) {
+            c->pending &= ~NOTIFY_POLL;
+        }
+    }
+    if (err == ESP_OK && (c->pending & NOTIFY_ROUTINE)) {
+        traffic = TRAFFIC_TELEMETRY;
+        app->beginCall(now_us + REQUEST_DEADLINE_MS * 1000LL);
+        err = c->db->patchData(c->path, "{\"temperature\":54,\"humidity\":61,\"complete\":40}");
+        app->endCall();
+        if (err == ESP_OK) {
+            c->pending &= ~NOTIFY_ROUTINE;
+        }
+    }
+
+    if (err == ESP_OK && c->degraded) {
+        c->degraded = false;
+        c->next_poll = now_us + POLL_US;
+    } else if (err != ESP_OK) {
+        if (!c->degraded) {
+            c->degraded = true;
+            c->next_poll = NEVER;
+        }
+        c->next_retry = now_us + RETRY_US;
+    }
+    c->busy_until = now_us;
+}
+
+static int64_t next_wake(const composter_t* c) {
+    int64_t t = std::min({c->next_poll, c->next_routine, c->next_actuator, c->next_retry, c->next_token});
+    // Anything already due runs as soon as the current call is over
+    return std::max(t, c->busy_until);
+}
+
+static float percentile(std::vector<float>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t k = (size_t) (p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Runs n composters from random phases for long enough to cover a device-day
+static void simulate(FirebaseApp* app, int n, run_t* result) {
+    std::vector<composter_t> composters(n);
+    std::priority_queue<std::pair<int64_t, int>, std::vector<std::pair<int64_t, int>>, std::greater<std::pair<int64_t, int>>> events;
+
+    worker_free = {};
+    for (int i = 0; i < workers; i++) {
+        worker_free.push(0);
+    }
+    run = result;
+    window_us = std::max(60 * 1000000LL, DAY_US / n);
+
+    for (int i = 0; i < n; i++) {
+        composter_t* c = &composters[i];
+        c->db = new RTDB(app, DATABASE_URL);
+        snprintf(c->path, sizeof(c->path), "%s%012llx", COMPOSTERS_PATH, 0x3c71bf000000ULL + i);
+        snprintf(c->commands_path, sizeof(c->commands_path), "%s/commands", c->path);
+        c->next_poll = (int64_t) (uniform() * POLL_US);
+        c->next_routine = (int64_t) (uniform() * ROUTINE_US);
+        c->next_token = (int64_t) (uniform() * TOKEN_REFRESH_US);
+        c->next_actuator = exponential_us((double) DAY_US / ACTUATOR_CHANGES_PER_DAY);
+        c->next_retry = NEVER;
+        c->next_command = exponential_us((double) DAY_US / REMOTE_COMMANDS_PER_DAY);
+        c->wake = next_wake(c);
+        events.push({c->wake, i});
+    }
+
+    while (!events.empty() && events.top().first < window_us) {
+        auto [t, i] = events.top();
+        events.pop();
+        composter_t* c = &composters[i];
+        if (t != c->wake) {
+            continue;
+        }
+        current = c;
+        composter_wake(app, c, t);
+        c->wake = next_wake(c);
+        events.push({c->wake, i});
+    }
+
+    for (composter_t& c : composters) {
+        delete c.db;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        workers = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        service_us = atoll(argv[2]);
+    }
+    if (argc > 3) {
+        rtt_us = atoll(argv[3]) * 1000;
+    }
+    if (workers < 1 || service_us < 1 || rtt_us < 0) {
+        printf("usage: bench_rtdb_load [workers] [service_us] [rtt_ms]\n");
+        return 2;
+    }
+
+    FirebaseApp* app = new FirebaseApp(API_KEY);
+    static const int fleet[] = {1, 10, 100, 1000, 5000, 10000};
+    run_t single = {};
+    int failures = 0;
+
+    printf("stand-in: %d workers x %lld us per request, %lld ms round trip\n", workers, (long long) service_us, (long long) (rtt_us / 1000));
+    printf("%8s %9s %9s %9s %9s %9s %17s\n", "devices", "window s", "req/s", "p50 ms", "p99 ms", "timeouts", "bytes/device/day");
+    for (int n : fleet) {
+        run_t result = {};
+        simulate(app, n, &result);
+
+        double window_s = window_us / 1e6;
+        uint64_t bytes = 0;
+        for (int k = 0; k < TRAFFIC_MAX; k++) {
+            bytes += result.bytes[k];
+        }
+        printf("%8d %9.0f %9.1f %9.1f %9.1f %9llu %17.0f\n", n, window_s, result.requests / window_s,
+               percentile(result.latency_ms, 0.50), percentile(result.latency_ms, 0.99),
+               (unsigned long long) result.timeouts, bytes * 86400.0 / (window_s * n));
+        if (n == 1) {
+            single = result;
+        }
+    }
+
+    printf("one composter over a day, by traffic:\n");
+    for (int k = 0; k < TRAFFIC_MAX; k++) {
+        printf("  %-16s %9llu bytes\n", traffic_names[k], (unsigned long long) single.bytes[k]);
+    }
+    printf("  %-16s %9llu\n", "commands run", (unsigned long long) single.executed);
+
+    // A lone composter never waits on the stand-in, and sees the commands sent to it
+    if (single.timeouts != 0 || single.executed == 0) {
+        printf("FAIL: %llu timeouts and %llu commands run for one composter\n",
+               (unsigned long long) single.timeouts, (unsigned long long) single.executed);
+        failures++;
+    }
+
+    delete app;
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+// Heap traffic of building RTDB request URLs.
+//
+// Compares the std::string concatenation RTDB used before user-030 with the
+// current path, driven through RTDB::deleteData against the fake FirebaseApp.
+// Fails if the current path allocates or builds a different URL.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "alloc_count.h"
+#include "esp_timer.h"
+#include "fake_firebase.h"
+#include "rtdb.h"
+
+#define ITERATIONS 10000
+#define DATABASE_URL "https://autocompost-default-rtdb.europe-west1.firebasedatabase.app/"
+
+int64_t esp_timer_get_time(void) {
+    return 0;
+}
+
+static const char* paths[] = {
+    "/composters/3C71BF4A2D10/sensors",
+    "/composters/3C71BF4A2D10/actuators",
+    "/composters/3C71BF4A2D10/commands/17",
+    "",
+};
+
+// What every request did before: base URL + path + ".json?auth=" + token
+static size_t old_build_url(const std::string& base, const char* path, const std::string& token) {
+    std::string url = base;
+    url += path;
+    url += ".json?auth=" + token;
+    return url.length();
+}
+
+int main(void) {
+    fake_server_reset();
+    FirebaseApp* app = new FirebaseApp("api-key");
+    RTDB* db = new RTDB(app, DATABASE_URL);
+
+    size_t auth_len;
+    const char* auth_query = app->getAuthQuery(&auth_len);
+    std::string base = DATABASE_URL;
+    std::string token = auth_query + strlen(AUTH_QUERY_PREFIX);
+    size_t path_count = sizeof(paths) / sizeof(paths[0]);
+
+    // Before: one fresh string per request
+    size_t url_len = 0;
+    alloc_calls = 0;
+    alloc_bytes = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        url_len += old_build_url(base, paths[i % path_count], token);
+    }
+    size_t old_calls = alloc_calls;
+    size_t old_bytes = alloc_bytes;
+
+    // After: the whole request path of RTDB
+    alloc_calls = 0;
+    alloc_bytes = 0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        db->deleteData(paths[i % path_count]);
+    }
+    size_t new_calls = alloc_calls;
+    size_t new_bytes = alloc_bytes;
+
+    int failures = 0;
+    for (size_t i = 0; i < path_count; i++) {
+        std::string expected = base + paths[i] + AUTH_QUERY_PREFIX + token;
+        db->deleteData(paths[i]);
+        if (expected != fake_server.url) {
+            printf("FAIL: URL for path \"%s\" is %s\n", paths[i], fake_server.url);
+            failures++;
+        }
+    }
+    if (new_calls != 0) {
+        printf("FAIL: %zu allocations in %d requests\n", new_calls, ITERATIONS);
+        failures++;
+    }
+
+    printf("RTDB URL construction, %d requests, ~%zu-byte URLs\n", ITERATIONS, url_len / ITERATIONS);
+    printf("  std::string concat   %6.2f allocations %8.1f bytes per request\n",
+           (double)old_calls / ITERATIONS, (double)old_bytes / ITERATIONS);
+    printf("  RTDB::buildUrl       %6.2f allocations %8.1f bytes per request\n",
+           (double)new_calls / ITERATIONS, (double)new_bytes / ITERATIONS);
+
+    delete db;
+    delete app;
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
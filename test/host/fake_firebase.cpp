@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fake_firebase.h"
+
+// Stands in for the HTTP side of FirebaseApp so RTDB runs on the host. Only the
+// members rtdb.cpp uses are implemented; none of them allocates per request.
+
+fake_server_t fake_server;
+
+void fake_server_reset(void) {
+    memset(&fake_server, 0, sizeof(fake_server));
+    fake_server.status_code = 200;
+    fake_server.body = "null";
+    fake_server.etag = "";
+}
+
+const char* fake_server_header(const char* header) {
+    for (int i = 0; i < FAKE_HEADER_MAX; i++) {
+        if (fake_server.header_names[i] && strcmp(fake_server.header_names[i], header) == 0) {
+            return fake_server.header_values[i];
+        }
+    }
+    return NULL;
+}
+
+FirebaseApp::FirebaseApp(const char* api_key) {
+    (void)api_key;
+    local_response_buffer = (char *)calloc(1, HTTP_RECV_BUFFER_SIZE);
+    auth_query = (char *)calloc(1, AUTH_QUERY_BUFFER_SIZE);
+
+    // A token as long as a real ID token (~1 KB JWT)
+    int len = snprintf(auth_query, AUTH_QUERY_BUFFER_SIZE, AUTH_QUERY_PREFIX);
+    for (; len < 1000; len++) {
+        auth_query[len] = 'a' + len % 26;
+    }
+    auth_query[len] = '\0';
+    auth_query_len = len;
+    response_etag[0] = '\0';
+}
+
+FirebaseApp::~FirebaseApp() {
+    free(local_response_buffer);
+    free(auth_query);
+}
+
+http_ret_t FirebaseApp::performRequest(const char* url, esp_http_client_method_t method, const char* post_field) {
+    if (requests_suspended || (in_call && call_generation != cancel_generation)) {
+        return {ESP_ERR_INVALID_STATE, 0};
+    }
+
+    snprintf(fake_server.url, sizeof(fake_server.url), "%s", url);
+    snprintf(fake_server.post_field, sizeof(fake_server.post_field), "%s", post_field ? post_field : "");
+    fake_server.method = method;
+    fake_server.accept_gzip = accept_gzip;
+    fake_server.requests++;
+    if (fake_server.on_request) {
+        fake_server.on_request();
+    }
+
+    snprintf(local_response_buffer, HTTP_RECV_BUFFER_SIZE, "%s", fake_server.body);
+    snprintf(response_etag, ETAG_BUFFER_SIZE, "%s", fake_server.etag);
+
+    return {ESP_OK, fake_server.status_code};
+}
+
+esp_err_t FirebaseApp::setHeader(const char* header, const char* value) {
+    int slot = -1;
+    for (int i = 0; i < FAKE_HEADER_MAX; i++) {
+        if (fake_server.header_names[i] && strcmp(fake_server.header_names[i], header) == 0) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 && fake_server.header_names[i] == NULL) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return ESP_FAIL;
+    }
+    fake_server.header_names[slot] = header;
+    snprintf(fake_server.header_values[slot], sizeof(fake_server.header_values[slot]), "%s", value);
+    return ESP_OK;
+}
+
+esp_err_t FirebaseApp::deleteHeader(const char* header) {
+    for (int i = 0; i < FAKE_HEADER_MAX; i++) {
+        if (fake_server.header_names[i] && strcmp(fake_server.header_names[i], header) == 0) {
+            fake_server.header_names[i] = NULL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t FirebaseApp::setAcceptGzip(bool enable) {
+    if (enable != accept_gzip) {
+        fake_server.gzip_changes++;
+    }
+    accept_gzip = enable;
+    return ESP_OK;
+}
+
+void FirebaseApp::clearHTTPBuffer(void) {
+    memset(local_response_buffer, 0, HTTP_RECV_BUFFER_SIZE);
+    response_etag[0] = '\0';
+}
+
+const char* FirebaseApp::getAuthQuery(size_t* len) {
+    *len = auth_query_len;
+    return auth_query;
+}
+
+bool FirebaseApp::isAuthTokenExpiring(void) {
+    return false;
+}
+
+esp_err_t FirebaseApp::refreshAuthToken(void) {
+    return ESP_OK;
+}
+
+int64_t FirebaseApp::getAuthTokenTimeToLive(void) {
+    return 3600 * 1000000LL;
+}
+
+esp_err_t FirebaseApp::loginUserAccount(const user_account_t& account) {
+    return ESP_OK;
+}
+
+esp_err_t FirebaseApp::resumeSession(const user_account_t& account) {
+    fake_server.logins++;
+    return ESP_OK;
+}
+
+void FirebaseApp::beginCall(int64_t deadline_us) {
+    request_deadline_us = deadline_us;
+    call_generation = cancel_generation;
+    in_call = true;
+}
+
+void FirebaseApp::endCall(void) {
+    request_deadline_us = 0;
+    in_call = false;
+}
+
+void FirebaseApp::cancelRequests(void) {
+    cancel_generation++;
+}
+
+void FirebaseApp::suspendRequests(void) {
+    requests_suspended = true;
+}
+
+void FirebaseApp::resumeRequests(void) {
+    requests_suspended = false;
+}
+
+void FirebaseApp::closeConnection(void) {
+    fake_server.connections_closed++;
+}
@@ -0,0 +1,36 @@
+#ifndef FAKE_FIREBASE_H_
+#define FAKE_FIREBASE_H_
+
+#include "firebase.hpp"
+
+#define FAKE_HEADER_MAX 8
+
+// Scripted server behind the fake FirebaseApp, see fake_firebase.cpp
+struct fake_server_t {
+    // Next response
+    int status_code;
+    const char* body;
+    const char* etag;
+    void (*on_request)(void);   // Runs while a request is in flight, e.g. to cancel it
+
+    // Last request
+    char url[2048];
+    esp_http_client_method_t method;
+    char post_field[HTTP_RECV_BUFFER_SIZE];
+    bool accept_gzip;
+    uint32_t requests;
+    uint32_t logins;
+    uint32_t connections_closed;
+    uint32_t gzip_changes;
+
+    // Headers currently set on the client
+    const char* header_names[FAKE_HEADER_MAX];
+    char header_values[FAKE_HEADER_MAX][64];
+};
+
+extern fake_server_t fake_server;
+
+void fake_server_reset(void);
+const char* fake_server_header(const char* header);
+
+#endif
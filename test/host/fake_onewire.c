@@ -0,0 +1,348 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/rmt_rx.h"
+#include "driver/rmt_tx.h"
+
+#include "fake_onewire.h"
+
+#define RECEIVE_IDLE_US 700     // signal_range_max_ns of the driver's receive config
+
+fake_device_t fake_bus_devices[FAKE_BUS_DEVICES];
+int fake_bus_device_count;
+
+int fake_rmt_live_channels;
+int fake_rmt_live_encoders;
+int fake_rmt_channels_created;
+bool fake_rmt_rx_wedged;
+
+long fake_rmt_transactions;
+long fake_rmt_rx_transactions;
+long fake_bus_time_us;
+
+struct rmt_encoder_t {
+    bool bytes;
+    rmt_symbol_word_t bit0;
+    rmt_symbol_word_t bit1;
+};
+
+struct rmt_channel_t {
+    bool rx;
+    bool enabled;
+    bool armed;                 // rmt_receive called, waiting for symbols
+    rmt_rx_done_callback_t on_recv_done;
+    void *user_ctx;
+    rmt_symbol_word_t *buffer;
+    size_t capacity;
+};
+
+static rmt_channel_handle_t rx_channel;
+
+uint8_t fake_bus_crc8(const uint8_t *data, int length) {
+    uint8_t crc = 0;
+
+    for (int i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for (int k = 0; k < 8; k++) {
+            uint8_t mix = (crc ^ byte) & 1;
+            crc >>= 1;
+            if (mix) {
+                crc ^= 0x8C;
+            }
+            byte >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+fake_device_t *fake_bus_add_device(const uint8_t rom[7], const uint8_t scratchpad[8]) {
+    if (fake_bus_device_count == FAKE_BUS_DEVICES) {
+        return NULL;
+    }
+
+    fake_device_t *device = &fake_bus_devices[fake_bus_device_count++];
+    memset(device, 0, sizeof(*device));
+    memcpy(device->rom, rom, 7);
+    device->rom[7] = fake_bus_crc8(rom, 7);
+    if (scratchpad != NULL) {
+        memcpy(device->scratchpad, scratchpad, 8);
+        device->scratchpad[8] = fake_bus_crc8(scratchpad, 8);
+    }
+    device->present = true;
+    return device;
+}
+
+void fake_bus_reset_counters(void) {
+    fake_rmt_transactions = 0;
+    fake_rmt_rx_transactions = 0;
+    fake_bus_time_us = 0;
+}
+
+// RMT driver
+
+esp_err_t rmt_new_bytes_encoder(const rmt_bytes_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder) {
+    struct rmt_encoder_t *encoder = calloc(1, sizeof(*encoder));
+    encoder->bytes = true;
+    encoder->bit0 = config->bit0;
+    encoder->bit1 = config->bit1;
+    *ret_encoder = encoder;
+    fake_rmt_live_encoders++;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder) {
+    *ret_encoder = calloc(1, sizeof(struct rmt_encoder_t));
+    fake_rmt_live_encoders++;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    free(encoder);
+    fake_rmt_live_encoders--;
+    return ESP_OK;
+}
+
+static esp_err_t new_channel(bool rx, rmt_channel_handle_t *ret_chan) {
+    if (fake_rmt_live_channels >= FAKE_RMT_CHANNELS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct rmt_channel_t *channel = calloc(1, sizeof(*channel));
+    channel->rx = rx;
+    fake_rmt_live_channels++;
+    fake_rmt_channels_created++;
+    *ret_chan = channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan) {
+    return new_channel(false, ret_chan);
+}
+
+esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t *config, rmt_channel_handle_t *ret_chan) {
+    esp_err_t ret = new_channel(true, ret_chan);
+    if (ret == ESP_OK) {
+        rx_channel = *ret_chan;
+    }
+    return ret;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel) {
+    free(channel);
+    fake_rmt_live_channels--;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) {
+    if (channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel) {
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = false;
+    channel->armed = false;
+    if (channel->rx) {
+        fake_rmt_rx_wedged = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t channel, const rmt_rx_event_callbacks_t *cbs, void *user_data) {
+    channel->on_recv_done = cbs->on_recv_done;
+    channel->user_ctx = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_receive(rmt_channel_handle_t channel, void *buffer, size_t buffer_size, const rmt_receive_config_t *config) {
+    if (!channel->enabled || channel->armed || fake_rmt_rx_wedged) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->buffer = buffer;
+    channel->capacity = buffer_size / sizeof(rmt_symbol_word_t);
+    channel->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel, int timeout_ms) {
+    return ESP_OK;
+}
+
+// Devices
+
+static bool device_active(const fake_device_t *device) {
+    return device->present && !device->hung;
+}
+
+static int bit_of(const uint8_t *bytes, int n) {
+    return (bytes[n / 8] >> (n % 8)) & 1;
+}
+
+static void device_slot(fake_device_t *device, int seen) {
+    switch (device->state) {
+        case FAKE_DEVICE_ROM_COMMAND:
+            device->command |= seen << device->bit;
+            if (++device->bit == 8) {
+                device->bit = 0;
+                device->phase = 0;
+                switch (device->command) {
+                    case 0xF0: device->state = FAKE_DEVICE_SEARCH; break;
+                    case 0x55: device->state = FAKE_DEVICE_MATCH; break;
+                    case 0xCC: device->state = FAKE_DEVICE_FUNCTION; break;
+                    default: device->state = FAKE_DEVICE_IDLE; break;
+                }
+                device->command = 0;
+            }
+            break;
+        case FAKE_DEVICE_SEARCH:
+            if (device->phase < 2) {
+                device->phase++;
+            } else if (seen != bit_of(device->rom, device->bit)) {
+                device->state = FAKE_DEVICE_IDLE;
+            } else {
+                device->phase = 0;
+                if (++device->bit == 64) {
+                    device->state = FAKE_DEVICE_IDLE;
+                }
+            }
+            break;
+        case FAKE_DEVICE_MATCH:
+            if (seen != bit_of(device->rom, device->bit)) {
+                device->state = FAKE_DEVICE_IDLE;
+            } else if (++device->bit == 64) {
+                device->bit = 0;
+                device->state = FAKE_DEVICE_FUNCTION;
+            }
+            break;
+        case FAKE_DEVICE_FUNCTION:
+            device->command |= seen << device->bit;
+            if (++device->bit == 8) {
+                device->bit = 0;
+                switch (device->command) {
+                    case 0xBE: device->state = FAKE_DEVICE_SEND; break;
+                    case 0x4E: device->state = FAKE_DEVICE_RECEIVE; break;
+                    default: device->state = FAKE_DEVICE_IDLE; break;
+                }
+                memset(device->received, 0, sizeof(device->received));
+            }
+            break;
+        case FAKE_DEVICE_SEND:
+            if (++device->bit == 72) {
+                device->state = FAKE_DEVICE_IDLE;
+            }
+            break;
+        case FAKE_DEVICE_RECEIVE:
+            device->received[device->bit / 8] |= seen << (device->bit % 8);
+            if (++device->bit == 24) {
+                device->scratchpad[2] = device->received[0];
+                device->scratchpad[3] = device->received[1];
+                device->scratchpad[4] = device->received[2] | 0x1F;
+                device->scratchpad[8] = fake_bus_crc8(device->scratchpad, 8);
+                device->state = FAKE_DEVICE_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Level of the bus during a slot in which the master writes a bit, or reads with a 1
+static int bus_slot(int written) {
+    int level = 1;
+
+    for (int i = 0; i < fake_bus_device_count; i++) {
+        fake_device_t *device = &fake_bus_devices[i];
+        if (!written || !device_active(device)) {
+            continue;
+        }
+        if (device->state == FAKE_DEVICE_SEARCH && device->phase < 2) {
+            int bit = bit_of(device->rom, device->bit);
+            level &= device->phase == 0 ? bit : !bit;
+        } else if (device->state == FAKE_DEVICE_SEND) {
+            level &= bit_of(device->scratchpad, device->bit);
+        }
+    }
+
+    int seen = written & level;
+    for (int i = 0; i < fake_bus_device_count; i++) {
+        if (device_active(&fake_bus_devices[i])) {
+            device_slot(&fake_bus_devices[i], seen);
+        }
+    }
+
+    return seen;
+}
+
+// Returns whether any device answered with a presence pulse
+static bool bus_reset(void) {
+    bool presence = false;
+
+    for (int i = 0; i < fake_bus_device_count; i++) {
+        fake_device_t *device = &fake_bus_devices[i];
+        if (device_active(device)) {
+            device->state = FAKE_DEVICE_ROM_COMMAND;
+            device->command = 0;
+            device->bit = 0;
+            device->phase = 0;
+            presence = true;
+        }
+    }
+
+    return presence;
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t channel, rmt_encoder_handle_t encoder, const void *payload, size_t payload_bytes, const rmt_transmit_config_t *config) {
+    static rmt_symbol_word_t tx[512], rx[512];
+    size_t tx_count = 0, rx_count = 0;
+
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (encoder->bytes) {
+        const uint8_t *bytes = payload;
+        for (size_t i = 0; i < payload_bytes; i++) {
+            for (int k = 0; k < 8; k++) {
+                tx[tx_count++] = (bytes[i] >> k) & 1 ? encoder->bit1 : encoder->bit0;
+            }
+        }
+    } else {
+        tx_count = payload_bytes / sizeof(rmt_symbol_word_t);
+        memcpy(tx, payload, payload_bytes);
+    }
+    fake_rmt_transactions++;
+
+    for (size_t i = 0; i < tx_count; i++) {
+        fake_bus_time_us += tx[i].duration0 + tx[i].duration1;
+        if (tx[i].duration0 >= 480) {
+            if (bus_reset()) {
+                rx[rx_count++] = (rmt_symbol_word_t) { .level0 = 0, .duration0 = 500, .level1 = 1, .duration1 = 30 };
+                rx[rx_count++] = (rmt_symbol_word_t) { .level0 = 0, .duration0 = 120, .level1 = 1, .duration1 = 0 };
+            } else {
+                rx[rx_count++] = (rmt_symbol_word_t) { .level0 = 0, .duration0 = 500, .level1 = 1, .duration1 = 0 };
+            }
+        } else {
+            int seen = bus_slot(tx[i].duration0 < 15);
+            rx[rx_count++] = (rmt_symbol_word_t) { .level0 = 0, .duration0 = seen ? 2 : 60, .level1 = 1, .duration1 = 2 };
+        }
+    }
+
+    if (rx_channel != NULL && rx_channel->armed) {
+        fake_rmt_rx_transactions++;
+        fake_bus_time_us += RECEIVE_IDLE_US;
+        rx_channel->armed = false;
+        if (rx_count > rx_channel->capacity) {
+            rx_count = rx_channel->capacity;
+        }
+        memcpy(rx_channel->buffer, rx, rx_count * sizeof(rmt_symbol_word_t));
+        rmt_rx_done_event_data_t event = { rx_channel->buffer, rx_count };
+        rx_channel->on_recv_done(rx_channel, &event, rx_channel->user_ctx);
+    }
+
+    return ESP_OK;
+}
@@ -0,0 +1,67 @@
+#ifndef FAKE_ONEWIRE_H_
+#define FAKE_ONEWIRE_H_
+
+// Model of the RMT peripheral with DS18B20-like devices on its 1-Wire bus.
+// Every transmitted symbol goes through the devices, and the resulting bus
+// levels are handed to the rx callback, as the open-drain loopback does on the
+// board. The devices answer search ROM, match ROM, skip ROM, read scratchpad
+// and write scratchpad.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAKE_BUS_DEVICES 4
+#define FAKE_RMT_CHANNELS 8
+
+typedef enum {
+    FAKE_DEVICE_IDLE,
+    FAKE_DEVICE_ROM_COMMAND,
+    FAKE_DEVICE_SEARCH,
+    FAKE_DEVICE_MATCH,
+    FAKE_DEVICE_FUNCTION,
+    FAKE_DEVICE_SEND,           // Sending the scratchpad
+    FAKE_DEVICE_RECEIVE,        // Receiving TH, TL and the configuration
+} fake_device_state_t;
+
+typedef struct {
+    uint8_t rom[8];
+    uint8_t scratchpad[9];
+    bool present;
+    bool hung;                  // Ignores the bus until power cycled
+    fake_device_state_t state;
+    uint8_t command;
+    int bit;                    // Bit of the command, ROM number or scratchpad
+    int phase;                  // Search: 0 sends the bit, 1 its complement, 2 reads the master's choice
+    uint8_t received[3];
+} fake_device_t;
+
+extern fake_device_t fake_bus_devices[FAKE_BUS_DEVICES];
+extern int fake_bus_device_count;
+
+// RMT resources and faults
+extern int fake_rmt_live_channels;
+extern int fake_rmt_live_encoders;
+extern int fake_rmt_channels_created;
+extern bool fake_rmt_rx_wedged;         // rx channel refuses to receive until it is disabled
+
+// Bus traffic: transactions, those that received, and symbol time plus the
+// 700 us of idle bus that ends every receive
+extern long fake_rmt_transactions;
+extern long fake_rmt_rx_transactions;
+extern long fake_bus_time_us;
+
+// Adds a present device, the CRCs of its ROM number and scratchpad are filled in
+fake_device_t *fake_bus_add_device(const uint8_t rom[7], const uint8_t scratchpad[8]);
+
+void fake_bus_reset_counters(void);
+uint8_t fake_bus_crc8(const uint8_t *data, int length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
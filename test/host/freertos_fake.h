@@ -0,0 +1,18 @@
+#ifndef FREERTOS_FAKE_H_
+#define FREERTOS_FAKE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Counters kept by freertos_fake.c
+extern uint32_t fake_tasks_created;
+extern uint32_t fake_task_notifications;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "driver/rmt_types.h"
+
+typedef struct {
+    int clk_src;
+    int gpio_num;
+    size_t mem_block_symbols;
+    uint32_t resolution_hz;
+} rmt_rx_channel_config_t;
+
+typedef struct {
+    uint32_t signal_range_min_ns;
+    uint32_t signal_range_max_ns;
+} rmt_receive_config_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t rmt_new_rx_channel(const rmt_rx_channel_config_t *config, rmt_channel_handle_t *ret_chan);
+esp_err_t rmt_receive(rmt_channel_handle_t channel, void *buffer, size_t buffer_size, const rmt_receive_config_t *config);
+esp_err_t rmt_rx_register_event_callbacks(rmt_channel_handle_t channel, const rmt_rx_event_callbacks_t *cbs, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
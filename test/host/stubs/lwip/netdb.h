@@ -0,0 +1,20 @@
+#pragma once
+
+// struct addrinfo from the host; lookups go to lwip_getaddrinfo as with
+// LWIP_COMPAT_SOCKETS, so the test can stand in for the resolver.
+#include <netdb.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int lwip_getaddrinfo(const char *nodename, const char *servname, const struct addrinfo *hints, struct addrinfo **res);
+void lwip_freeaddrinfo(struct addrinfo *ai);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define getaddrinfo(nodname, servname, hints, res) lwip_getaddrinfo(nodname, servname, hints, res)
+#define freeaddrinfo(addrinfo) lwip_freeaddrinfo(addrinfo)
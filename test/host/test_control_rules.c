@@ -0,0 +1,138 @@
+// The composter policy in control_rules.c run through the rule engine: each
+// scenario seeds the facts, feeds inputs one at a time and checks the actions
+// performed, in order, and the facts left afterwards.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "control/control_rules.h"
+#include "control/rule_engine.h"
+
+#define MAX_ACTIONS 8
+#define MAX_STEPS 6
+#define END -1
+
+typedef struct {
+    RuleFacts_t set;
+    RuleFacts_t clear;
+    int actions[MAX_ACTIONS];   // Expected actions, terminated by END
+    RuleFacts_t facts;          // Expected facts after the update
+} Step_t;
+
+typedef struct {
+    const char *name;
+    RuleFacts_t facts;          // Seeded facts
+    Step_t steps[MAX_STEPS];    // Terminated by a step that sets and clears nothing
+} Scenario_t;
+
+static const Scenario_t scenarios[] = {
+    {"crusher with the lid open asks to close it", 0, {
+        {FACT_CRUSHER_REQUESTED, 0, {CONTROL_ACTION_REQUEST_TO_CLOSE_LID, END}, 0},
+    }},
+    {"crusher locks, runs with the mixer, then unlocks", FACT_LID_CLOSED, {
+        {FACT_CRUSHER_REQUESTED, 0, {CONTROL_ACTION_LOCK, CONTROL_ACTION_CRUSHER_ON, CONTROL_ACTION_MIXER_ON, END},
+         FACT_LID_CLOSED | FACT_LOCKED | FACT_CRUSHER_ON | FACT_MIXER_ON},
+        {FACT_CRUSHER_TIME_UP, 0, {CONTROL_ACTION_CRUSHER_OFF, CONTROL_ACTION_UNLOCK, END},
+         FACT_LID_CLOSED | FACT_MIXER_ON},
+    }},
+    {"opening the lid stops the crusher and unlocks", FACT_LID_CLOSED, {
+        {FACT_CRUSHER_REQUESTED, 0, {CONTROL_ACTION_LOCK, CONTROL_ACTION_CRUSHER_ON, CONTROL_ACTION_MIXER_ON, END},
+         FACT_LID_CLOSED | FACT_LOCKED | FACT_CRUSHER_ON | FACT_MIXER_ON},
+        {0, FACT_LID_CLOSED, {CONTROL_ACTION_CRUSHER_OFF, CONTROL_ACTION_UNLOCK, END}, FACT_MIXER_ON},
+    }},
+    {"full with the lid open asks to close it", 0, {
+        {FACT_FULL, 0, {CONTROL_ACTION_REQUEST_TO_CLOSE_LID, END}, FACT_FULL},
+    }},
+    {"full locks until emptied", FACT_LID_CLOSED, {
+        {FACT_FULL, 0, {CONTROL_ACTION_LOCK, END}, FACT_LID_CLOSED | FACT_FULL | FACT_LOCKED},
+        {0, FACT_FULL, {CONTROL_ACTION_UNLOCK, END}, FACT_LID_CLOSED},
+    }},
+    {"seeded full and locked, crushing keeps the lock", FACT_LID_CLOSED | FACT_FULL | FACT_LOCKED, {
+        {FACT_CRUSHER_REQUESTED, 0, {CONTROL_ACTION_CRUSHER_ON, CONTROL_ACTION_MIXER_ON, END},
+         FACT_LID_CLOSED | FACT_FULL | FACT_LOCKED | FACT_CRUSHER_ON | FACT_MIXER_ON},
+        {FACT_CRUSHER_TIME_UP, 0, {CONTROL_ACTION_CRUSHER_OFF, CONTROL_ACTION_REQUEST_TO_EMPTY_COMPOSTER, END},
+         FACT_LID_CLOSED | FACT_FULL | FACT_LOCKED | FACT_MIXER_ON},
+        {0, FACT_FULL, {CONTROL_ACTION_UNLOCK, END}, FACT_LID_CLOSED | FACT_MIXER_ON},
+    }},
+    {"opening the lid while full unlocks", FACT_LID_CLOSED | FACT_FULL | FACT_LOCKED, {
+        {0, FACT_LID_CLOSED, {CONTROL_ACTION_UNLOCK, END}, FACT_FULL},
+    }},
+};
+
+typedef struct {
+    int actions[MAX_ACTIONS];
+    size_t count;
+} Recorder_t;
+
+static bool record_action(int action, void *context) {
+    Recorder_t *recorder = context;
+    if (recorder->count < MAX_ACTIONS) {
+        recorder->actions[recorder->count] = action;
+    }
+    recorder->count++;
+    return true;
+}
+
+static int run_scenario(const Scenario_t *scenario) {
+    RuleEngine engine;
+    Recorder_t recorder;
+    int failures = 0;
+
+    RuleEngine_Init(&engine, controlRules, controlRulesCount, CONTROL_PULSE_FACTS, scenario->facts, record_action, &recorder);
+
+    for (size_t s = 0; s < MAX_STEPS; s++) {
+        const Step_t *step = &scenario->steps[s];
+        if (step->set == 0 && step->clear == 0) {
+            break;
+        }
+
+        memset(&recorder, 0, sizeof(recorder));
+        RuleEngine_Update(&engine, step->set, step->clear);
+
+        size_t expected = 0;
+        while (expected < MAX_ACTIONS && step->actions[expected] != END) {
+            expected++;
+        }
+
+        bool same = recorder.count == expected;
+        for (size_t i = 0; same && i < expected; i++) {
+            same = recorder.actions[i] == step->actions[i];
+        }
+        if (!same) {
+            printf("FAIL: %s, step %zu: got actions", scenario->name, s + 1);
+            for (size_t i = 0; i < recorder.count && i < MAX_ACTIONS; i++) {
+                printf(" %d", recorder.actions[i]);
+            }
+            printf(", expected");
+            for (size_t i = 0; i < expected; i++) {
+                printf(" %d", step->actions[i]);
+            }
+            printf("\n");
+            failures++;
+        }
+
+        RuleFacts_t facts = RuleEngine_GetFacts(&engine);
+        if (facts != step->facts) {
+            printf("FAIL: %s, step %zu: facts 0x%lx, expected 0x%lx\n", scenario->name, s + 1,
+                   (unsigned long) facts, (unsigned long) step->facts);
+            failures++;
+        }
+    }
+
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        failures += run_scenario(&scenarios[i]);
+    }
+
+    if (failures != 0) {
+        printf("test_control_rules: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_control_rules: %zu scenarios passed\n", sizeof(scenarios) / sizeof(scenarios[0]));
+    return 0;
+}
@@ -0,0 +1,108 @@
+// JsonWriter output checked against cJSON_PrintUnformatted, plus overflow and
+// nesting. Built with -fsanitize=float-cast-overflow so an out-of-range cast
+// in JsonWriter_AddNumber aborts the test.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "cJSON.h"
+#include "common/json_writer.h"
+
+static int failures;
+
+static void expect_str(const char *what, const char *actual, const char *expected) {
+    if (actual == NULL || strcmp(actual, expected) != 0) {
+        printf("FAIL: %s: got %s, expected %s\n", what, actual ? actual : "NULL", expected);
+        failures++;
+    }
+}
+
+static void test_numbers_match_cjson(void) {
+    static const double values[] = {
+        0, -0.0, 1, -1, 1.5, -0.25, 12345.678, 1e-7,
+        2147483647.0, -2147483648.0, 2147483648.0, -2147483649.0,
+        3e9, -3e9, 4294967296.0, 1e15, 1e300, -1e300,
+    };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char buffer[64];
+        JsonWriter writer;
+        JsonWriter_Init(&writer, buffer, sizeof(buffer));
+        JsonWriter_BeginObject(&writer, NULL);
+        JsonWriter_AddNumber(&writer, "v", values[i]);
+        JsonWriter_EndObject(&writer);
+
+        cJSON *json = cJSON_CreateObject();
+        cJSON_AddNumberToObject(json, "v", values[i]);
+        char *expected = cJSON_PrintUnformatted(json);
+
+        char what[48];
+        snprintf(what, sizeof(what), "AddNumber(%g)", values[i]);
+        expect_str(what, JsonWriter_Finish(&writer, NULL), expected);
+
+        cJSON_free(expected);
+        cJSON_Delete(json);
+    }
+}
+
+static void test_non_finite_is_null(void) {
+    char buffer[64];
+    JsonWriter writer;
+    JsonWriter_Init(&writer, buffer, sizeof(buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddNumber(&writer, "nan", NAN);
+    JsonWriter_AddNumber(&writer, "inf", -INFINITY);
+    JsonWriter_EndObject(&writer);
+
+    expect_str("non-finite numbers", JsonWriter_Finish(&writer, NULL), "{\"nan\":null,\"inf\":null}");
+}
+
+static void test_document(void) {
+    char buffer[128];
+    JsonWriter writer;
+    JsonWriter_Init(&writer, buffer, sizeof(buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddInt(&writer, "min", INT32_MIN);
+    JsonWriter_AddBool(&writer, "on", true);
+    JsonWriter_BeginObject(&writer, "nested");
+    JsonWriter_AddString(&writer, "s", "a\"b\\c\n\x01");
+    JsonWriter_AddString(&writer, "null", NULL);
+    JsonWriter_EndObject(&writer);
+    JsonWriter_EndObject(&writer);
+
+    expect_str("document", JsonWriter_Finish(&writer, NULL),
+               "{\"min\":-2147483648,\"on\":true,\"nested\":{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"null\":null}}");
+}
+
+static void test_overflow_and_unbalanced(void) {
+    char buffer[8];
+    JsonWriter writer;
+    JsonWriter_Init(&writer, buffer, sizeof(buffer));
+    JsonWriter_BeginObject(&writer, NULL);
+    JsonWriter_AddInt(&writer, "value", 1);
+    JsonWriter_EndObject(&writer);
+    if (JsonWriter_Finish(&writer, NULL) != NULL) {
+        printf("FAIL: overflowing document was returned\n");
+        failures++;
+    }
+
+    char large[32];
+    JsonWriter_Init(&writer, large, sizeof(large));
+    JsonWriter_BeginObject(&writer, NULL);
+    if (JsonWriter_Finish(&writer, NULL) != NULL) {
+        printf("FAIL: unterminated object was returned\n");
+        failures++;
+    }
+}
+
+int main(void) {
+    test_numbers_match_cjson();
+    test_non_finite_is_null();
+    test_document();
+    test_overflow_and_unbalanced();
+
+    printf("test_json_writer: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,117 @@
+// onewire_bus_recover against the RMT and device model of fake_onewire.c, with
+// two devices on the bus. Faults: a device left mid-transaction, a wedged rx
+// channel, a hung device, and devices that left the bus.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_count.h"
+#include "drivers/onewire_bus.h"
+#include "fake_onewire.h"
+
+#define RECOVERIES 1000
+
+static int failures;
+
+#define EXPECT(cond) do { if (!(cond)) { printf("FAIL line %d: %s\n", __LINE__, #cond); failures++; } } while (0)
+
+static int power_cycles;
+
+static esp_err_t power_cycle(void *user_ctx) {
+    for (int i = 0; i < fake_bus_device_count; i++) {
+        fake_bus_devices[i].hung = false;
+    }
+    power_cycles++;
+    return ESP_OK;
+}
+
+int main(void) {
+    static const uint8_t rom_a[7] = { 0x28, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    static const uint8_t rom_b[7] = { 0x28, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44 };
+    fake_device_t *device_a = fake_bus_add_device(rom_a, NULL);
+    fake_device_t *device_b = fake_bus_add_device(rom_b, NULL);
+    const uint8_t *a = device_a->rom, *b = device_b->rom;
+
+    onewire_rmt_config_t config = { .gpio_pin = 4, .max_rx_bytes = 10 };
+    onewire_bus_handle_t bus;
+    onewire_bus_recovery_stats_t stats;
+    EXPECT(onewire_new_bus_rmt(&config, &bus) == ESP_OK);
+
+    // Healthy bus: the bus reset and ROM search find both devices
+    EXPECT(onewire_bus_recover(bus, a) == ESP_OK);
+    EXPECT(onewire_bus_recover(bus, b) == ESP_OK);
+    EXPECT(onewire_bus_recover(bus, NULL) == ESP_OK);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    EXPECT(stats.recoveries == 3 && stats.channel_reinits == 0 && stats.failures == 0);
+
+    // Device left in the middle of a search: the bus reset is enough
+    device_a->state = FAKE_DEVICE_SEARCH;
+    device_a->bit = 17;
+    EXPECT(onewire_bus_recover(bus, a) == ESP_OK);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    EXPECT(stats.channel_reinits == 0);
+
+    // Wedged rx channel: needs the channels re-initialized
+    fake_rmt_rx_wedged = true;
+    EXPECT(onewire_bus_reset(bus) != ESP_OK);
+    EXPECT(onewire_bus_recover(bus, a) == ESP_OK);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    EXPECT(stats.channel_reinits == 1 && stats.power_cycles == 0 && stats.failures == 0);
+
+    // Hung device without a power cycle hook: fails, the other device still answers
+    device_a->hung = true;
+    EXPECT(onewire_bus_recover(bus, a) == ESP_ERR_NOT_FOUND);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    EXPECT(stats.failures == 1 && stats.power_cycles == 0);
+    EXPECT(onewire_bus_recover(bus, b) == ESP_OK);
+
+    // With the hook, the power cycle brings it back
+    EXPECT(onewire_bus_set_power_cycle_hook(bus, power_cycle, NULL) == ESP_OK);
+    EXPECT(onewire_bus_recover(bus, a) == ESP_OK);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    EXPECT(stats.power_cycles == 1 && power_cycles == 1 && stats.failures == 1);
+
+    // Devices gone for good
+    device_a->present = false;
+    EXPECT(onewire_bus_recover(bus, a) == ESP_ERR_NOT_FOUND);
+    EXPECT(onewire_bus_recover(bus, b) == ESP_OK);
+    device_b->present = false;
+    EXPECT(onewire_bus_recover(bus, NULL) == ESP_ERR_NOT_FOUND);
+
+    // Repeated recoveries reuse the channels and encoders and leave the heap flat
+    device_a->present = device_b->present = true;
+    int channels = fake_rmt_live_channels, encoders = fake_rmt_live_encoders, created = fake_rmt_channels_created;
+    long live_bytes = alloc_live_bytes;
+    size_t calls = alloc_calls;
+    for (int i = 0; i < RECOVERIES; i++) {
+        if (i % 3 == 0) {
+            fake_rmt_rx_wedged = true;
+        }
+        EXPECT(onewire_bus_recover(bus, b) == ESP_OK);
+    }
+    EXPECT(fake_rmt_live_channels == channels && fake_rmt_live_encoders == encoders && fake_rmt_channels_created == created);
+    EXPECT(alloc_live_bytes == live_bytes);
+    onewire_bus_get_recovery_stats(bus, &stats);
+    printf("  %d recoveries, %u with channel re-initialization: 0 rmt channels created, %.2f heap calls each, "
+           "%ld live bytes left\n", RECOVERIES, stats.channel_reinits - 1, (double) (alloc_calls - calls) / RECOVERIES,
+           alloc_live_bytes - live_bytes);
+
+    // The old recovery created a new bus each time, without deleting the old one
+    int created_buses = 0;
+    onewire_bus_handle_t leaked;
+    while (created_buses < FAKE_RMT_CHANNELS && onewire_new_bus_rmt(&config, &leaked) == ESP_OK) {
+        created_buses++;
+    }
+    EXPECT(created_buses == FAKE_RMT_CHANNELS / 2 - 1);
+    printf("  re-creating the bus instead: out of rmt channels after %d recoveries\n", created_buses);
+
+    EXPECT(onewire_del_bus(bus) == ESP_OK);
+
+    if (failures != 0) {
+        printf("test_onewire_recovery: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_onewire_recovery: passed\n");
+    return 0;
+}
@@ -0,0 +1,139 @@
+// RTDB read cache: ETag revalidation, TTL hits, invalidation on writes, the
+// conditional patch and its 412 fallback, and gzip configuration, against the
+// scripted server of fake_firebase.cpp.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_count.h"
+#include "esp_timer.h"
+#include "fake_firebase.h"
+#include "rtdb.h"
+
+#define PATH "/composters/3C71BF4A2D10"
+#define DOCUMENT "{\"complete\":0,\"days\":12,\"humidity\":61,\"temperature\":54,\"mixer\":false,\"crusher\":false,\"fan\":true}"
+
+static int64_t now_us;
+static int failures;
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static bool read_equals(RTDB* db, const char* path, const char* expected) {
+    cJSON* data_json = db->getData(path);
+    char* actual = cJSON_PrintUnformatted(data_json);
+    bool equal = actual && strcmp(actual, expected) == 0;
+    cJSON_free(actual);
+    cJSON_Delete(data_json);
+    return equal;
+}
+
+int main(void) {
+    fake_server_reset();
+    FirebaseApp* app = new FirebaseApp("api-key");
+    RTDB* db = new RTDB(app, "https://example.firebaseio.com");
+    uint32_t hits, not_modified, misses;
+
+    // First read downloads the document and caches it by ETag
+    fake_server.body = DOCUMENT;
+    fake_server.etag = "etag-1";
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server_header("if-none-match") == NULL);
+    db->getCacheStats(&hits, &not_modified, &misses);
+    EXPECT(misses == 1);
+
+    // Second read revalidates; a 304 is answered from the cached body
+    fake_server.status_code = 304;
+    fake_server.body = "";
+    uint32_t requests = fake_server.requests;
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server.requests == requests + 1);
+    db->getCacheStats(&hits, &not_modified, &misses);
+    EXPECT(not_modified == 1);
+
+    // Within the TTL no request goes out
+    db->setCacheTtl(1000);
+    now_us += 500 * 1000;
+    requests = fake_server.requests;
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server.requests == requests);
+    db->getCacheStats(&hits, &not_modified, &misses);
+    EXPECT(hits == 1);
+    db->setCacheTtl(0);
+
+    // A conditional patch merges into the cached document and keeps it cached
+    fake_server.status_code = 200;
+    fake_server.body = "{\"fan\":false}";
+    fake_server.etag = "etag-2";
+    EXPECT(db->patchIfMatch(PATH, NULL, "{\"fan\":false}") == ESP_OK);
+    EXPECT(fake_server.method == HTTP_METHOD_PUT);
+    EXPECT(strstr(fake_server.post_field, "\"days\":12") != NULL);
+    EXPECT(strstr(fake_server.post_field, "\"fan\":false") != NULL);
+
+    fake_server.status_code = 304;
+    fake_server.body = "";
+    EXPECT(read_equals(db, PATH, "{\"complete\":0,\"days\":12,\"humidity\":61,\"temperature\":54,\"mixer\":false,\"crusher\":false,\"fan\":false}"));
+
+    // A plain write drops the entry, so the next read is unconditional
+    fake_server.status_code = 200;
+    EXPECT(db->patchData(PATH "/days", "13") == ESP_OK);
+    fake_server.body = DOCUMENT;
+    fake_server.etag = "etag-3";
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server_header("if-none-match") == NULL);
+
+    // On 412 only the patched fields are sent, and nothing is cached for them
+    fake_server.status_code = 412;
+    fake_server.etag = "etag-4";
+    requests = fake_server.requests;
+    EXPECT(db->patchIfMatch(PATH, NULL, "{\"mixer\":true}") == ESP_FAIL);
+    EXPECT(fake_server.requests == requests + 2);
+    EXPECT(fake_server.method == HTTP_METHOD_PATCH);
+    EXPECT(strcmp(fake_server.post_field, "{\"mixer\":true}") == 0);
+    fake_server.status_code = 200;
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server_header("if-none-match") == NULL);
+
+    // Any other failure is returned without a second write
+    fake_server.status_code = 500;
+    requests = fake_server.requests;
+    EXPECT(db->patchIfMatch(PATH, NULL, "{\"mixer\":true}") == ESP_FAIL);
+    EXPECT(fake_server.requests == requests + 1);
+    EXPECT(fake_server.method == HTTP_METHOD_PUT);
+    EXPECT(fake_server_header("if-match") == NULL);
+    fake_server.status_code = 200;
+
+    // Compression is configured once, not toggled around each read
+    db->setCompression(true);
+    fake_server.etag = "etag-5";
+    EXPECT(read_equals(db, PATH, DOCUMENT));
+    EXPECT(fake_server.accept_gzip);
+    EXPECT(db->patchData(PATH "/days", "14") == ESP_OK);
+    EXPECT(fake_server.accept_gzip);
+    EXPECT(fake_server.gzip_changes == 1);
+    db->setCompression(false);
+
+    // An entry costs a copy of the body, not a parsed tree
+    alloc_calls = 0;
+    alloc_bytes = 0;
+    cJSON* tree = cJSON_Parse(DOCUMENT);
+    size_t tree_bytes = alloc_bytes;
+    cJSON_Delete(tree);
+    printf("Cached %zu-byte document: %zu bytes as a body, %zu bytes as a cJSON tree\n",
+           strlen(DOCUMENT), strlen(DOCUMENT) + 1, tree_bytes);
+
+    delete db;
+    delete app;
+
+    printf("test_rtdb_cache: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
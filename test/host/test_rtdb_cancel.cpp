@@ -0,0 +1,93 @@
+// Wi-Fi dropping and coming back while an RTDB call is running, as the
+// communicator sees it when wifi.c reconnects right away: the event handler
+// cancels the call, and the task never sees the connection go down, so it
+// never suspends or resumes the client. The cancelled call must fail and the
+// calls after it must go out.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "fake_firebase.h"
+#include "lwip/netdb.h"
+#include "rtdb_wrapper.h"
+
+#define PATH "/composters/3C71BF4A2D10"
+#define DATABASE_URL "https://autocompost-default-rtdb.europe-west1.firebasedatabase.app/"
+
+static RTDB_t* db;
+static int64_t now_us = 1000000;
+static int failures;
+
+int64_t esp_timer_get_time(void) {
+    return now_us += 1000;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return 320 * 1024;
+}
+
+int lwip_getaddrinfo(const char *nodename, const char *servname, const struct addrinfo *hints, struct addrinfo **res) {
+    return EAI_FAIL;
+}
+
+void lwip_freeaddrinfo(struct addrinfo *ai) {
+}
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// WIFI_EVENT_CONNECTION_OFF then ON while the request is on the wire; the
+// request itself times out, which the server answers here with a 500
+static void drop_and_reconnect(void) {
+    RTDB_Cancel(db);
+    fake_server.status_code = 500;
+    fake_server.on_request = NULL;
+}
+
+int main(void) {
+    user_data_t account = {"station@example.com", "password"};
+    fake_server_reset();
+    fake_server.body = "{\"temperature\":54}";
+
+    db = RTDB_Create("api-key", account, DATABASE_URL);
+    EXPECT(db != NULL);
+    if (db == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    // The failed read is not retried once the call is cancelled
+    fake_server.on_request = drop_and_reconnect;
+    cJSON* data_json = db->getData(db, PATH);
+    EXPECT(data_json == NULL);
+    EXPECT(fake_server.requests == 1);
+
+    // Without RTDB_Resume, the next calls go out
+    fake_server.status_code = 200;
+    data_json = db->getData(db, PATH);
+    EXPECT(data_json != NULL);
+    cJSON_Delete(data_json);
+    EXPECT(db->patchData(db, PATH, "{\"fan\":true}") == ESP_OK);
+    EXPECT(fake_server.requests == 3);
+
+    // A cancel between calls fails none of them
+    RTDB_Cancel(db);
+    EXPECT(db->patchData(db, PATH, "{\"fan\":false}") == ESP_OK);
+
+    // Suspension still holds every call until the client is resumed
+    RTDB_Suspend(db);
+    EXPECT(db->patchData(db, PATH, "{\"fan\":true}") == ESP_FAIL);
+    EXPECT(fake_server.requests == 4);
+    RTDB_Resume(db);
+    EXPECT(db->patchData(db, PATH, "{\"fan\":true}") == ESP_OK);
+    EXPECT(fake_server.requests == 5);
+
+    printf("test_rtdb_cancel: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
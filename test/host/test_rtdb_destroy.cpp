@@ -0,0 +1,109 @@
+// RTDB_Destroy with asynchronous requests still queued: none of them may run
+// against the freed client. Each completes with ESP_ERR_INVALID_STATE and no
+// data, its body is freed, and the next client starts a new worker.
+//
+// The fake scheduler never runs the worker, so every request stays queued
+// until the client is destroyed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_count.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "fake_firebase.h"
+#include "freertos_fake.h"
+#include "lwip/netdb.h"
+#include "rtdb_wrapper.h"
+
+#define PATH "/composters/3C71BF4A2D10"
+#define DATABASE_URL "https://autocompost-default-rtdb.europe-west1.firebasedatabase.app/"
+
+static int64_t now_us = 1000000;
+static int failures;
+static int completed;
+static int completed_ok;
+
+int64_t esp_timer_get_time(void) {
+    return now_us += 1000;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return 320 * 1024;
+}
+
+int lwip_getaddrinfo(const char *nodename, const char *servname, const struct addrinfo *hints, struct addrinfo **res) {
+    return EAI_FAIL;
+}
+
+void lwip_freeaddrinfo(struct addrinfo *ai) {
+}
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static void on_complete(int result, cJSON *data, void *arg) {
+    completed++;
+    if (result == ESP_ERR_INVALID_STATE && data == NULL && arg == &completed) {
+        completed_ok++;
+    }
+    cJSON_Delete(data);
+}
+
+// Creates a client, queues `patches` patches and a read, and destroys it.
+// Returns the heap the round left behind.
+static long destroy_with_queued(int patches) {
+    user_data_t account = {"station@example.com", "password"};
+    long live_bytes = alloc_live_bytes;
+
+    RTDB_t* db = RTDB_Create("api-key", account, DATABASE_URL);
+    EXPECT(db != NULL);
+    if (db == NULL) {
+        return 0;
+    }
+
+    uint32_t tasks_created = fake_tasks_created;
+
+    for (int i = 0; i < patches; i++) {
+        EXPECT(db->patchDataAsync(db, PATH, "{\"fan\":true}", RTDB_PRIORITY_TELEMETRY, on_complete, &completed) == ESP_OK);
+    }
+    EXPECT(db->getDataAsync(db, PATH, RTDB_PRIORITY_COMMAND, on_complete, &completed) == ESP_OK);
+    EXPECT(fake_tasks_created == tasks_created + 1);
+
+    completed = completed_ok = 0;
+    uint32_t notifications = fake_task_notifications;
+    RTDB_Destroy(db);
+
+    // The worker was told to stop, and every request completed without going out
+    EXPECT(fake_task_notifications == notifications + 1);
+    EXPECT(completed == patches + 1);
+    EXPECT(completed_ok == patches + 1);
+    EXPECT(fake_server.requests == 0);
+
+    return alloc_live_bytes - live_bytes;
+}
+
+int main(void) {
+    fake_server_reset();
+
+    // The first round also allocates the session, queues and worker semaphore
+    destroy_with_queued(1);
+
+    // Every round restarts the worker; the fake keeps each task record, so
+    // compare rounds: more queued bodies must not leave more heap behind
+    long one_patch = destroy_with_queued(1);
+    long five_patches = destroy_with_queued(5);
+    EXPECT(five_patches == one_patch);
+
+    // A queue that filled up while the client was alive is emptied as well
+    long full_queue = destroy_with_queued(8);
+    EXPECT(full_queue == one_patch);
+
+    printf("test_rtdb_destroy: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
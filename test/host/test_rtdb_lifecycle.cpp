@@ -0,0 +1,99 @@
+// Soak of the RTDB client lifecycle: 10,000 Wi-Fi flaps driven the way the
+// communicator does it, checking that the client is reused and the heap held
+// by the library stays flat. Also checks the memory budget on creation.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc_count.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "fake_firebase.h"
+#include "freertos_fake.h"
+#include "lwip/netdb.h"
+#include "rtdb_wrapper.h"
+
+#define FLAPS 10000
+#define PATH "/composters/3C71BF4A2D10"
+#define DATABASE_URL "https://autocompost-default-rtdb.europe-west1.firebasedatabase.app/"
+
+static size_t heap_size;
+static int64_t now_us = 1000000;
+static int failures;
+
+// Every call takes 1 ms, well within the request deadline
+int64_t esp_timer_get_time(void) {
+    return now_us += 1000;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return heap_size - alloc_live_bytes;
+}
+
+int lwip_getaddrinfo(const char *nodename, const char *servname, const struct addrinfo *hints, struct addrinfo **res) {
+    return EAI_FAIL;
+}
+
+void lwip_freeaddrinfo(struct addrinfo *ai) {
+}
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+int main(void) {
+    user_data_t account = {"station@example.com", "password"};
+    fake_server_reset();
+    fake_server.body = "{\"temperature\":54}";
+    fake_server.etag = "etag-1";
+
+    // Refused below the memory budget, without leaking
+    heap_size = 32 * 1024;
+    EXPECT(RTDB_Create("api-key", account, DATABASE_URL) == NULL);
+    long refused_live_bytes = alloc_live_bytes;
+
+    heap_size = 320 * 1024;
+    RTDB_t* db = RTDB_Create("api-key", account, DATABASE_URL);
+    EXPECT(db != NULL);
+    if (db == NULL) {
+        return EXIT_FAILURE;
+    }
+    long client_live_bytes = alloc_live_bytes - refused_live_bytes;
+    uint32_t tasks_created = fake_tasks_created;
+
+    long settled_live_bytes = 0;
+    for (int i = 0; i < FLAPS; i++) {
+        // CONNECTION_ON: a read, as the communicator's first poll does
+        cJSON* data_json = db->getData(db, PATH);
+        EXPECT(data_json != NULL);
+        cJSON_Delete(data_json);
+
+        // CONNECTION_OFF: the event handler cancels, the task suspends
+        RTDB_Cancel(db);
+        RTDB_Suspend(db);
+        data_json = db->getData(db, PATH);
+        EXPECT(data_json == NULL);
+
+        // CONNECTION_ON again
+        EXPECT(RTDB_Create("api-key", account, DATABASE_URL) == db);
+
+        if (i == 0) {
+            settled_live_bytes = alloc_live_bytes;
+        }
+    }
+
+    EXPECT(fake_server.logins == 1);
+    EXPECT(fake_server.connections_closed == FLAPS);
+    EXPECT(fake_tasks_created == tasks_created);
+    EXPECT(alloc_live_bytes == settled_live_bytes);
+
+    printf("RTDB client: %ld bytes after creation, %+ld bytes over %d flaps\n",
+           client_live_bytes, alloc_live_bytes - settled_live_bytes, FLAPS);
+
+    printf("test_rtdb_lifecycle: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+// RTDB_PreresolveHosts against a local stand-in for the lwIP resolver: which
+// hosts are looked up, and that a failing host does not stop the others.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "firebase.hpp"
+#include "lwip/netdb.h"
+#include "rtdb_wrapper.h"
+
+#define LOOKUPS_MAX 16
+
+static int64_t now_us = 1000000;
+static int failures;
+
+static char lookups[LOOKUPS_MAX][128];
+static int lookup_count;
+static const char* failing_host;
+
+int64_t esp_timer_get_time(void) {
+    return now_us;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    return 320 * 1024;
+}
+
+int lwip_getaddrinfo(const char *nodename, const char *servname, const struct addrinfo *hints, struct addrinfo **res) {
+    static struct addrinfo answer;
+
+    if (lookup_count < LOOKUPS_MAX) {
+        snprintf(lookups[lookup_count], sizeof(lookups[0]), "%s", nodename);
+    }
+    lookup_count++;
+
+    if (hints == NULL || hints->ai_family != AF_INET || hints->ai_socktype != SOCK_STREAM) {
+        return EAI_FAMILY;
+    }
+    if (failing_host && strcmp(nodename, failing_host) == 0) {
+        *res = NULL;
+        return EAI_FAIL;
+    }
+    *res = &answer;
+    return 0;
+}
+
+void lwip_freeaddrinfo(struct addrinfo *ai) {
+}
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+static int count_lookups(const char* host) {
+    int count = 0;
+    for (int i = 0; i < lookup_count && i < LOOKUPS_MAX; i++) {
+        count += strcmp(lookups[i], host) == 0;
+    }
+    return count;
+}
+
+static void preresolve(const char* database_url) {
+    lookup_count = 0;
+    RTDB_PreresolveHosts(database_url);
+}
+
+int main(void) {
+    // The database host is taken from the URL; each host is looked up cold, then cached
+    preresolve("https://autocompost-default-rtdb.europe-west1.firebasedatabase.app/");
+    EXPECT(lookup_count == 6);
+    EXPECT(count_lookups("autocompost-default-rtdb.europe-west1.firebasedatabase.app") == 2);
+    EXPECT(count_lookups(FIREBASE_IDENTITY_HOST) == 2);
+    EXPECT(count_lookups(FIREBASE_SECURETOKEN_HOST) == 2);
+
+    // Ports and paths are not part of the host
+    preresolve("https://example.firebaseio.com:443/composters");
+    EXPECT(count_lookups("example.firebaseio.com") == 2);
+
+    // A host that does not resolve is looked up once and the others still are
+    failing_host = FIREBASE_IDENTITY_HOST;
+    preresolve("https://example.firebaseio.com/");
+    EXPECT(lookup_count == 5);
+    EXPECT(count_lookups(FIREBASE_IDENTITY_HOST) == 1);
+    EXPECT(count_lookups(FIREBASE_SECURETOKEN_HOST) == 2);
+    failing_host = NULL;
+
+    // A database host too long for the buffer is skipped
+    char long_url[256] = "https://";
+    memset(long_url + 8, 'a', 120);
+    strcat(long_url, ".firebaseio.com/");
+    preresolve(long_url);
+    EXPECT(lookup_count == 4);
+
+    printf("test_rtdb_preresolve: %s\n", failures ? "FAILED" : "passed");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+// Timing wheel run against a simulated tick count. The wheel task runs on the
+// test thread: each ulTaskNotifyTake advances the clock by the time the task
+// asked to sleep, or by less when the scenario arms or cancels a timer meanwhile.
+// Ticks are milliseconds here, and the clock starts just before it wraps around.
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "common/timer_wheel.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define START_TICK 0xFFFFF000u
+#define SOAK_TIMERS 200
+#define HOUR_MS (3600 * 1000u)
+
+static TickType_t tick = START_TICK;
+static TickType_t end_tick;
+static jmp_buf stop;
+static TaskFunction_t wheel_task;
+static uint32_t wakes;
+static int critical_depth;
+static uint32_t notifications;
+static bool (*interrupt)(TickType_t wait);    // Wakes the task early when it returns true
+static int failures;
+
+#define EXPECT(cond, ...) do { if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+TickType_t xTaskGetTickCount(void) {
+    return tick;
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t) (uint32_t) (tick - START_TICK) * 1000;
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux) {
+    critical_depth++;
+}
+
+void vPortExitCritical(portMUX_TYPE *mux) {
+    critical_depth--;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, TaskHandle_t *handle) {
+    wheel_task = code;
+    *handle = (TaskHandle_t) &wheel_task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+}
+
+// Notifying can switch tasks, which a spinlock holder must never do
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    EXPECT(critical_depth == 0, "wheel task notified inside a critical section");
+    notifications++;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    bool notified = interrupt != NULL && interrupt(ticks_to_wait);
+
+    if (!notified) {
+        if (ticks_to_wait == portMAX_DELAY || (uint32_t) (end_tick - tick) <= ticks_to_wait) {
+            longjmp(stop, 1);
+        }
+        tick += ticks_to_wait;
+    }
+    wakes++;
+
+    if ((int32_t) (tick - end_tick) >= 0) {
+        longjmp(stop, 1);
+    }
+    return notified;
+}
+
+// Runs the wheel task for a number of ticks
+static void run_for(uint32_t ticks) {
+    end_tick = tick + ticks;
+    wakes = 0;
+    if (!setjmp(stop)) {
+        wheel_task(NULL);
+    }
+}
+
+// One periodic timer: the task wakes a few times per expiry, not every level 0 turn
+static uint32_t hourly_fires;
+
+static void count_hourly(void *arg) {
+    hourly_fires++;
+}
+
+static void test_sleeps_until_next_expiry(void) {
+    WheelTimer_t timer;
+    TimerWheel_Init(&timer, "hourly", HOUR_MS, true, count_hourly, NULL);
+    TimerWheel_Arm(&timer);
+
+    run_for(10 * HOUR_MS + 1);
+    TimerWheel_Cancel(&timer);
+
+    EXPECT(hourly_fires == 10, "hourly timer fired %u times, expected 10", hourly_fires);
+    EXPECT(wakes <= 4 * hourly_fires + 4, "wheel task woke %u times for %u expiries", wakes, hourly_fires);
+    printf("  1 h periodic timer over 10 h: %u wakes\n", wakes);
+}
+
+// A cancelled timer must not leave its slot marked occupied and wake the task
+static void count_nothing(void *arg) {
+}
+
+static void test_cancel_empties_slot(void) {
+    WheelTimer_t soon, later;
+    TimerWheel_Init(&soon, "soon", 1000, false, count_nothing, NULL);
+    TimerWheel_Init(&later, "later", 100000, false, count_nothing, NULL);
+
+    // Start on a tick aligned to the top level, so every slot of the later timer is due after 1 s
+    tick = (tick | 0xFFFFFF) + 1;
+    TimerWheel_Arm(&soon);
+    TimerWheel_Arm(&later);
+    TimerWheel_Cancel(&soon);
+
+    run_for(99000);
+    TimerWheel_Cancel(&later);
+
+    EXPECT(wakes <= 1, "wheel task woke %u times for a cancelled timer", wakes);
+}
+
+// Random timers, armed and cancelled while the task sleeps, must fire on their tick
+static WheelTimer_t soak[SOAK_TIMERS];
+static TickType_t soak_due[SOAK_TIMERS];
+static uint32_t soak_fires;
+static uint32_t soak_late;
+
+static void soak_arm(int i) {
+    TimerWheel_Arm(&soak[i]);
+    soak_due[i] = tick + soak[i].period;
+    EXPECT(TimerWheel_GetRemainingMs(&soak[i]) == soak[i].period, "timer %d remaining %u ms after arming, expected %u",
+           i, TimerWheel_GetRemainingMs(&soak[i]), soak[i].period);
+}
+
+static void soak_expired(void *arg) {
+    int i = (int) (intptr_t) arg;
+
+    if (tick != soak_due[i]) {
+        soak_late++;
+        if (soak_late <= 5) {
+            printf("  timer %d fired at %u, due at %u\n", i, tick - START_TICK, soak_due[i] - START_TICK);
+        }
+    }
+    soak_fires++;
+
+    if (soak[i].periodic) {
+        soak_due[i] = tick + soak[i].period;
+    } else if (i % 7 == 0) {
+        soak_arm(i);
+    }
+}
+
+static bool soak_interrupt(TickType_t wait) {
+    TickType_t span = wait == portMAX_DELAY ? 1000 : wait;
+    if (span <= 1 || rand() % 3 != 0) {
+        return false;
+    }
+
+    tick += 1 + rand() % (span - 1);
+    int i = rand() % SOAK_TIMERS;
+    if (rand() % 4 == 0) {
+        TimerWheel_Cancel(&soak[i]);
+    } else {
+        soak_arm(i);
+    }
+    return true;
+}
+
+static void test_soak_fires_on_time(void) {
+    srand(1);
+    for (int i = 0; i < SOAK_TIMERS; i++) {
+        uint32_t ms = rand() % 5 == 0 ? (rand() % (4 * 3600)) * 1000u : rand() % 300000 + 10u;
+        TimerWheel_Init(&soak[i], "soak", ms, i % 2, soak_expired, (void *) (intptr_t) i);
+        soak_arm(i);
+    }
+
+    interrupt = soak_interrupt;
+    run_for(13 * HOUR_MS);
+    interrupt = NULL;
+
+    for (int i = 0; i < SOAK_TIMERS; i++) {
+        TimerWheel_Cancel(&soak[i]);
+    }
+
+    EXPECT(soak_late == 0, "%u of %u expiries off their tick", soak_late, soak_fires);
+    EXPECT(soak_fires > 10000, "only %u expiries in the soak", soak_fires);
+    EXPECT(notifications > 0, "no timer armed while the task slept woke it early");
+    printf("  %d random timers over 13 h: %u expiries, %u wakes, %u early\n", SOAK_TIMERS, soak_fires, wakes, notifications);
+}
+
+int main(void) {
+    TimerWheel_Start();
+
+    test_sleeps_until_next_expiry();
+    test_cancel_empties_slot();
+    test_soak_fires_on_time();
+
+    TimerWheelStats_t stats;
+    TimerWheel_GetStats(&stats);
+    EXPECT(stats.active == 0, "%u timers still armed", stats.active);
+
+    if (failures != 0) {
+        printf("test_timer_wheel: %d failures\n", failures);
+        return 1;
+    }
+    printf("test_timer_wheel: passed\n");
+    return 0;
+}